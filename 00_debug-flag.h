@@ -35,6 +35,30 @@
 //#define DM_DBG					// Dimmer channel module (cmDimmer.cpp)
 //#define RE_DBG					// Remote channel module (cmRemote.cpp)
 
+//#define PRF_DBG				// Profiling counters of the main loop stages, 't' in the serial console dumps and resets them
+//#define TRC_DBG				// Send and receive messages of SN_DBG and RV_DBG as binary trace, decode with tools/trace_decode.py
+//#define NRG_DBG				// Energy accounting of radio, mcu and eeprom per message type and channel, 'e' in the serial console dumps and resets it
+
+/* the benchmarks of bench/ measure the library without any debug output */
+#ifdef AS_BENCH
+	#undef SER_DBG
+	#undef DMP_DBG
+	#undef AS_DBG
+	#undef CC_DBG
+	#undef SN_DBG
+	#undef RV_DBG
+	#undef CB_DBG
+	#undef LD_DBG
+	#undef CM_DBG
+	#undef MN_DBG
+	#undef SW_DBG
+	#undef DM_DBG
+	#undef RE_DBG
+	#undef PRF_DBG
+	#undef TRC_DBG
+	#undef NRG_DBG
+#endif
+
 
 /*
 * @brief This macro has to be in every .cpp file to enable the DBG() message.
@@ -92,6 +116,31 @@ template<class T> inline Print &operator ,(Print &obj, T arg) { return obj << ar
 	#define DBG_RV(...) 
 #endif
 
+/* trace sites of the send and receive module, TRC(MODULE, ID, ARG, BUF, LEN, ...) writes a record with the trace id,
+*  one argument byte and LEN bytes of BUF into the trace ring if TRC_DBG is set, otherwise the rest is printed like DBG().
+*  The ring is drained to serial by AS::poll() while no wake reason is registered, see s_trc in AS_type_defs.h */
+#define TRC( MODULE, ...) PRIMITIVE_CAT(TRC_, MODULE, __VA_ARGS__)
+
+#ifdef TRC_DBG
+	#define _TRC(ID, ARG, BUF, LEN, ...) trc.add(ID, ARG, BUF, LEN)
+	#define TRC_POLL() if (!sched.reason) trc.drain()
+#else
+	#define _TRC(ID, ARG, BUF, LEN, ...) Serial ,__VA_ARGS__
+	#define TRC_POLL()
+#endif
+
+#ifdef SN_DBG
+	#define TRC_SN(...) _TRC(__VA_ARGS__)
+#else
+	#define TRC_SN(...) 
+#endif
+
+#ifdef RV_DBG
+	#define TRC_RV(...) _TRC(__VA_ARGS__)
+#else
+	#define TRC_RV(...) 
+#endif
+
 /* config button class */
 #ifdef CB_DBG
 	#define DBG_CB(...) Serial ,__VA_ARGS__
@@ -141,6 +190,33 @@ template<class T> inline Print &operator ,(Print &obj, T arg) { return obj << ar
 	#define DBG_RE(...) 
 #endif
 
+/* profiling counters, PRF() measures the given statements, PRF_SCOPE() the rest of the block, see s_prf in AS_type_defs.h */
+#ifdef PRF_DBG
+	#define PRF(STAGE, ...) { uint32_t prf_start = get_cycles(); __VA_ARGS__; prf.add(STAGE, prf_start); }
+	#define PRF_SCOPE(STAGE) s_prf_scope prf_scope(STAGE)
+#else
+	#define PRF(STAGE, ...) { __VA_ARGS__; }
+	#define PRF_SCOPE(STAGE)
+#endif
+
+/* energy accounting, NRG() attributes the given statements to a context, NRG_SCOPE() the rest of the block, NRG_RADIO()
+*  and NRG_MCU() mark a state change, see s_nrg in AS_type_defs.h */
+#ifdef NRG_DBG
+	#define NRG(CTX, ...) { s_nrg_scope nrg_scope(CTX); __VA_ARGS__; }
+	#define NRG_SCOPE(CTX) s_nrg_scope nrg_scope(CTX)
+	#define NRG_RADIO(STATE) nrg.set_radio(STATE)
+	#define NRG_MCU(STATE) nrg.set_mcu(STATE)
+	#define NRG_EE_WRITE() nrg.ee_write()
+	#define NRG_TICK() nrg.tick()
+#else
+	#define NRG(CTX, ...) { __VA_ARGS__; }
+	#define NRG_SCOPE(CTX)
+	#define NRG_RADIO(STATE)
+	#define NRG_MCU(STATE)
+	#define NRG_EE_WRITE()
+	#define NRG_TICK()
+#endif
+
 
 
 
@@ -43,6 +43,93 @@ namespace MSG_INTENT {
 	enum E : uint8_t { BROADCAST = 'b', MASTER = 'm', PEER = 'p', INTERN = 'i', LOGGING = 'l', NOT_PAIRED = 'x', ERROR = 'u', };
 };
 
+/*
+* @brief Key byte of the message dispatch table, which byte beside BY03 identifies the message
+* BY03 - 0, message type byte is sufficient
+* BY10 - 1, sub type in byte 10, ACK and INSTRUCTION messages
+* BY11 - 2, sub type in byte 11, CONFIG messages
+*/
+namespace MSG_KEY {
+	enum E : uint8_t { BY03 = 0x00, BY10 = 0x01, BY11 = 0x02, };
+};
+
+/*
+* @brief Rule to resolve the channel module for a received message, used by the message dispatch table
+* NONE   - 0, handled in the main class, no channel module needed
+* BY10   - 1, channel in byte 10, CONFIG messages
+* BY11   - 2, channel in byte 11, INSTRUCTION messages, device wide if the message length is 0x0a
+* PEER   - 3, peer in the payload, channel by peer lookup, SWITCH message
+* INTENT - 4, channel remembered by get_intend, peer messages
+* DEVICE - 5, device wide, channel 0
+*/
+namespace MSG_CNL {
+	enum E : uint8_t { NONE = 0x00, BY10 = 0x01, BY11 = 0x02, PEER = 0x03, INTENT = 0x04, DEVICE = 0x05, };
+};
+
+/*
+* @brief Wake reasons, registered by modules which have work to do that is not bound to a waittimer
+* RECEIVE  - received message waits for processing
+* SEND     - send function is busy
+* LIST_MSG - peer or param list answer is in progress
+* PEER_MSG - peer message is in progress
+* CONFIG   - config session waits for the commit
+* RESET    - device reset is pending
+* EEPROM   - eeprom write back is pending
+* LED      - led pattern continues without timer
+*/
+namespace WAKE_REASON {
+	enum E : uint8_t { NONE = 0x00, RECEIVE = 0x01, SEND = 0x02, LIST_MSG = 0x04, PEER_MSG = 0x08, CONFIG = 0x10, RESET = 0x20, EEPROM = 0x40, LED = 0x80, };
+};
+
+/*
+* @brief Profiling stages of the main loop, counted if PRF_DBG is set in 00_debug-flag.h
+* RCV       - rcv_data of the communication module
+* RCV_POLL  - rcv_poll
+* MSG_      - process_message by message type, DEVICE_INFO 0x00, CONFIG 0x01, ACK 0x02, AES 0x03/0x04, INFO 0x10,
+*             INSTRUCTION 0x11, HAVE_DATA 0x12 and all peer messages
+* SND_POLL  - snd_poll
+* SND_DATA  - snd_data of the communication module
+* LIST_POLL - process_list_message_poll
+* PEER_POLL - process_peer_message_poll
+* EE_       - eeprom write back poll, get_eeprom and set_eeprom
+* BAT, CBN, LED, POM - poll of battery, config button, status led and power management
+* CNL       - poll of the channel modules, one stage per channel, channels above CNT are counted in the last stage
+*/
+namespace PRF_STAGE {
+	enum E : uint8_t { RCV = 0, RCV_POLL, MSG_DEVICE_INFO, MSG_CONFIG, MSG_ACK, MSG_AES, MSG_INFO, MSG_INSTRUCTION, MSG_HAVE_DATA, MSG_PEER, 
+		SND_POLL, SND_DATA, LIST_POLL, PEER_POLL, EE_POLL, EE_GET, EE_SET, BAT, CBN, LED, POM, CNL, CNT = CNL + 6, };
+};
+
+/*
+* @brief Energy accounting, counted if NRG_DBG is set in 00_debug-flag.h
+* NRG_STATE - states with their own current, the radio is in RX, TX, BURST or PWD, the mcu ACTIVE or SLEEP at the same
+*             time, EEPROM is the programming time of the eeprom writes
+* NRG_CTX   - contexts the charge is attributed to, RCV and SND are followed by the message group of s_nrg::msg_group(),
+*             DEVICE_INFO, CONFIG, ACK, AES, INFO, INSTRUCTION, HAVE_DATA and all peer messages, CNL by the channel,
+*             channels above CNT are counted in the last one. NONE is the main loop and the sleep in between
+*/
+namespace NRG_STATE {
+	enum E : uint8_t { RX = 0, TX, BURST, PWD, ACTIVE, SLEEP, EEPROM, CNT, };
+};
+namespace NRG_CTX {
+	enum E : uint8_t { RCV = 0, SND = 8, CNL = 16, CNT = CNL + 6, NONE = 0xff, };
+};
+
+/*
+* @brief Trace sites, see TRC() in 00_debug-flag.h. tools/trace_decode.py reads the names and values from here,
+*        the format of every name is defined there
+* LOST        - records dropped while the ring was full, arg is the amount
+* RCV_MSG     - received message, arg is the intent
+* RCV_REPEAT  - repeated message, already processed
+* RCV_UNKNOWN - message for us, but not in the dispatch table
+* SND_INTERN  - message to ourself, processed as received message
+* SND_MSG     - message sent to the communication module
+* SND_TIMEOUT - no answer on a message which requested one
+*/
+namespace TRC_ID {
+	enum E : uint8_t { LOST = 0x00, RCV_MSG = 0x01, RCV_REPEAT = 0x02, RCV_UNKNOWN = 0x03, SND_INTERN = 0x10, SND_MSG = 0x11, SND_TIMEOUT = 0x12, };
+};
+
 /*
 * @brief Reason for sending the message
 * ANSWER  - 0, messgae answers a received string
@@ -302,7 +389,7 @@ namespace MSG_TYPE {
 
 
 		/* 0x10 ff ff ff * REPLY_MSG, placeholder only */
-		REPLY_MSG = 0x10ffff,
+		REPLY_MSG = 0x10ffffff,
 
 		/* 0x10 00 ff 14 * - INFO_SERIAL
 		*    LEN CNT FLAG BY03 SND       RCV       By10  SERIAL
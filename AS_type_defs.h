@@ -9,8 +9,8 @@
 #include "00_debug-flag.h"
 #include "HAL.h"
 #include "waittimer.h"
-#include "as_enum_defs.h"
-#include "as_message_defs.h"
+#include "AS_enum_defs.h"
+#include "AS_message_defs.h"
 #include "as_helpers.h"
 
 #ifndef _AS_TYPEDEFS_H
@@ -113,6 +113,85 @@ typedef struct ts_cm_status {
 } s_cm_status;
 
 
+/*
+* @brief Integrity check of the eeprom content
+*
+* The fixed blocks - dev_ident, the peer device table and list0/1 of every channel - have a 2 byte crc in a
+* table behind the config journal, every record in the peer pool ends with a 1 byte crc over header and list3/4.
+* Crc's are updated on every write of a block, blocks are verified when they are loaded and one by one in the
+* background by poll(). A corrupted block is restored selectively and LED_STAT::EEPROM_ERROR is shown.
+* Blocks: 0 = dev_ident, 1 = peer device table, 2 + cnl = list0/1 of the channel
+* A verified bit per pool record in RAM skips the crc of the record in load_list() until the record is written or
+* moved, poll() checks the records regardless of it. ee_check_rec[] is defined in the user sketch.
+*/
+extern uint8_t ee_check_rec[];									// verified bit per pool record, defined in the user sketch
+extern const uint8_t ee_check_rec_cnt;							// and the amount of records with a bit
+#define EE_BLOCK_IDENT     0
+#define EE_BLOCK_PEER_DEV  1
+#define EE_BLOCK_LIST      2
+#define EE_CHECK_TIME      500									// ms between two blocks in the background check
+
+typedef struct ts_ee_check {
+	uint16_t  ee_addr;											// address of the crc table for the fixed blocks
+	uint8_t   error;											// a corrupted block was found
+	uint16_t  next;												// next block for the background check, fixed blocks first, followed by the pool records
+	waittimer timer;											// time between two background checks
+
+	uint16_t calc(uint8_t block);								// calculates the crc of a fixed block
+	void     update(uint8_t block);								// calculates and stores the crc of a fixed block
+	uint8_t  verify(uint8_t block);								// 1 if the crc of a fixed block is ok, otherwise the block is restored
+	uint8_t  calc_rec(uint16_t addr, uint8_t len);				// calculates the crc of a pool record, len without the crc byte
+	void     update_rec(uint16_t addr, uint8_t len);			// calculates and stores the crc of a pool record
+	uint8_t  verify_rec(uint16_t addr, uint8_t cnl, uint8_t force = 0);	// 1 if the crc of the record is ok, otherwise list3/4 is restored
+	void     set_verified(uint8_t nr, uint8_t value);			// sets or clears the verified bit of a pool record
+	void     clear_verified(void);								// clears the verified bits of all pool records
+	void     update_addr(uint16_t addr);						// updates the crc of the block which contains the given address
+	void     poll(void);										// background check of the next block
+} s_ee_check;
+
+extern s_ee_check ee_check;
+
+
+/*
+* @brief Peer Pool
+*
+* Peers of all channels are stored together with their list3/4 in one eeprom region, the peer pool. Channels get
+* their records on demand, a channel with many peers takes as much space as needed, a channel without peers none.
+* Records are packed from the start of the pool without gaps, a record holds the channel (1 byte), the index of
+* the peer device in the shared device table + 1 (1 byte), the peer device channel (1 byte), the list3/4 of
+* the peer (lstP.len of the channel) and a crc byte, see s_ee_check. Removing a record moves all following
+* records down, the free space behind the last record is always empty, an empty channel byte marks the end.
+* The size of the pool is defined by peer_pool_size in the user sketch.
+* The progress of a compaction is written into two move markers behind the pool, recover() finishes a compaction
+* which was interrupted by a power loss.
+*/
+struct s_pool_move {
+	uint16_t hole;												// start of the gap which is moved to the end of the pool
+	uint8_t  len;												// length of the gap, 0 if the marker is empty
+	uint8_t  crc;												// crc over hole and len
+};
+
+typedef struct ts_peer_pool {
+	uint16_t ee_addr;											// start address of the pool in EEprom memory
+	uint16_t size;												// size of the pool in byte
+	uint16_t used;												// used bytes, set by init()
+	uint16_t ee_move;											// address of the two move markers
+
+	void     init(void);										// walks through the records to find the end and count the peers per channel
+	void     clear_all(void);									// clears the complete pool
+	uint8_t  is_rec_cnl(uint8_t cnl);							// 1 if the channel byte of a record is valid, walks stop at an invalid one
+	uint8_t  get_rec_len(uint8_t cnl);							// length of a record of the given channel
+	uint8_t  get_rec_nr(uint16_t addr);							// number of the record at the given address, 0xff if not found
+	uint16_t get_rec_addr(uint8_t cnl, uint8_t idx);			// address of the idx'th record of the channel, 0 if not found
+	uint16_t alloc(uint8_t cnl);								// reserves a record at the end of the pool, 0 if the pool is full
+	void     release(uint16_t addr, uint8_t len);				// removes a record, following records are moved down
+	void     recover(void);										// finishes an interrupted compaction, before init()
+	uint8_t  is_dev_used(uint8_t dev);							// 1 if any record references the given peer device
+} s_peer_pool;
+
+extern s_peer_pool peer_pool;
+
+
 /*
 * @brief Every channel has two lists, the first list holds the configuration which is required to drive the channel,
 *        the second list is related to peer messages and holds all information which are required to drive the functionality
@@ -143,19 +222,29 @@ typedef struct ts_list_table {
 	uint8_t len;							// length of register, defaults and value array
 	uint16_t ee_addr;						// start address for channel in eeprom
 
-	/* calculate the eeprom address on base of the index, list0 / 1 didnt need an index */
+	/* calculate the eeprom address on base of the index, list0 / 1 didnt need an index,
+	*  list3 / 4 are stored behind the record header in the peer pool */
 	uint16_t get_ee_addr(uint8_t idx = 0) {	
-		return ee_addr + (idx * len);
+		if (lst < 3) return ee_addr + (idx * len);
+		uint16_t addr = peer_pool.get_rec_addr(cnl, idx);		// 0 if the peer is not in the pool
+		return (addr) ? addr + 3 : 0;
 	}
 
 	/* load the respective list from the eeprom  */
 	void load_list(uint8_t idx = 0) {							
-		get_eeprom(get_ee_addr(idx), len, val);
+		uint16_t addr = get_ee_addr(idx);
+		if (!addr) return;
+		if (lst >= 3) ee_check.verify_rec(addr - 3, cnl);		// verify the peer record, list0/1 is verified on startup
+		get_eeprom(addr, len, val);
 	}
 
-	/* writes the respective list to the eeprom  */
+	/* writes the respective list to the eeprom and updates the crc */
 	void save_list(uint8_t idx = 0) {
-		set_eeprom(get_ee_addr(idx), len, val);
+		uint16_t addr = get_ee_addr(idx);
+		if (!addr) return;
+		set_eeprom(addr, len, val);
+		if (lst < 3) ee_check.update(EE_BLOCK_LIST + cnl);
+		else ee_check.update_rec(addr - 3, 3 + len);
 	}
 
 	/* load defaults from PROGMEM  */
@@ -191,7 +280,7 @@ typedef struct ts_list_table {
 
 	/* Writes values by a given register/value array into the local value array.
 	*/
-	void update_list(const uint8_t *buf, uint8_t len, uint8_t idx = 0) {
+	void update_list(const uint8_t *buf, uint8_t len, uint8_t /*idx*/ = 0) {
 		for (uint8_t i = 0; i < len; i += 2) {
 			uint8_t *ptr = ptr_to_val( buf[i] );
 			if (ptr) *ptr = buf[i + 1];
@@ -228,61 +317,141 @@ typedef struct ts_list_table {
 } s_list_table;
 
 
+/*
+* @brief Peer Device Table
+*
+* The HMID of every peer device is stored once in a table which is shared by all channels, 3 bytes per device.
+* A remote which is peered on all channels to the same actor needs therefore only one entry here. The channel
+* peer tables are referencing the device by its index. The size of the table is defined by peer_dev_max in the
+* user sketch, an entry is cleared by peer_dev_release() if no channel uses it anymore.
+*/
+typedef struct ts_peer_dev {
+	uint8_t  max;												// maximum number of peer devices
+	uint16_t ee_addr;											// address of the device table in EEprom memory
+
+	void get(uint8_t idx, uint8_t *buf) {						// reads the HMID of a device by idx
+		get_eeprom(ee_addr + (idx * 3), 3, buf);
+	}
+
+	uint8_t get_idx(uint8_t *buf) {								// returns the idx of the given HMID, or 0xff if not found
+		uint8_t x[3];
+		for (uint8_t i = 0; i < max; i++) {
+			get(i, x);
+			if (!memcmp(x, buf, 3)) return i;
+		}
+		return 0xff;
+	}
+
+	uint8_t add(uint8_t *buf) {									// returns the idx of the given HMID, unknown devices are added, 0xff if the table is full
+		uint8_t idx = get_idx(buf);
+		if (idx != 0xff) return idx;
+		uint8_t x[3] = {};
+		idx = get_idx(x);										// search for an empty entry
+		if (idx != 0xff) {
+			set_eeprom(ee_addr + (idx * 3), 3, buf);
+			ee_check.update(EE_BLOCK_PEER_DEV);
+		}
+		return idx;
+	}
+
+	void clear(uint8_t idx) {									// clears a device entry
+		if (idx >= max) return;
+		clear_eeprom(ee_addr + (idx * 3), 3);
+		ee_check.update(EE_BLOCK_PEER_DEV);
+	}
+
+	void clear_all() {											// clear all devices
+		clear_eeprom(ee_addr, max * 3);
+		ee_check.update(EE_BLOCK_PEER_DEV);
+	}
+} s_peer_dev;
+
+extern s_peer_dev peer_dev;
+
+
+
+
 /*
 * @brief Peer Device Table Entry
 *
 * This structure is used to specify the number of possible peers per channel and
-* assign corresponding EEprom memory sections where peer information is to be stored.
+* to find the peers of the channel in the shared peer pool.
 *
-* For each channel and peered device, 4 bytes are written to EEprom memory denoting the
-* peer device HMID (3 bytes) and peer device channel (1 byte). Consequently, the following
-* definition with 6 possible peers for channel 1 will use 24 bytes in EEprom memory.
+* No eeprom space is reserved per channel, max is only the limit for the channel and
+* a slot takes its space in the peer pool when a peer is added. The slot index of a peer is
+* the position of its record within the records of the channel, removing a peer moves the
+* following peers of the channel one index down. The interface is still working on 4 byte
+* peers, HMID (3 bytes) and peer device channel (1 byte).
 */
 typedef struct ts_peer_table {
 	uint8_t  max;												// maximum number of peer devices
-	uint16_t ee_addr;											// address of configuration data in EEprom memory
+	uint8_t  cnl;												// channel of the peer table, records in the pool are tagged with it
+	uint8_t  used;												// amount of used slots, counted by peer_pool.init()
 	uint8_t  dont_use_peer[4];									// placeholder for a peer id from or to eeprom
 
+	uint8_t get_dev(uint8_t idx) {								// returns the device index of the slot, 0xff if the slot is empty
+		uint16_t addr = peer_pool.get_rec_addr(cnl, idx);
+		uint8_t x = 0;
+		if (addr) get_eeprom(addr + 1, 1, &x);
+		return x - 1;
+	}
+
 	uint8_t *get_peer(uint8_t idx) {							// reads a peer address by idx from the database into the struct peer
 		if (idx >= max) return NULL;
-		get_eeprom(ee_addr + (idx * 4), 4, dont_use_peer);
+		uint16_t addr = peer_pool.get_rec_addr(cnl, idx);
+		dont_use_peer[2] = 0;
+		if (addr) get_eeprom(addr + 1, 2, &dont_use_peer[2]);	// device index and peer channel
+		if (dont_use_peer[2]) peer_dev.get(dont_use_peer[2] - 1, dont_use_peer);
+		else memset(dont_use_peer, 0, 4);
 		return dont_use_peer;
 	}
 
-	void set_peer(uint8_t idx, uint8_t *buf) {					// writes the peer to the by idx defined place in the database
-		if (idx >= max) return;
-		set_eeprom(ee_addr + (idx * 4), 4, buf);
+	uint8_t set_peer(uint8_t idx, uint8_t *buf) {				// writes the peer to the by idx defined place in the database, 0 if the pool or the device table is full
+		if ((idx >= max) || (idx > used)) return 0;				// new peers are added behind the last one
+		if ((idx == used) && (get_free_slot() == 0xff)) return 0;	// no space left in the pool
+		uint8_t x[3] = { cnl, peer_dev.add(buf), buf[3] };		// get or add the device in the shared table
+		if (x[1]++ == 0xff) return 0;
+		uint16_t addr = (idx < used) ? peer_pool.get_rec_addr(cnl, idx) : peer_pool.alloc(cnl);
+		if (!addr) return 0;
+		if (idx == used) used++;
+		set_eeprom(addr, 3, x);
+		ee_check.update_rec(addr, peer_pool.get_rec_len(cnl) - 1);
+		return 1;
 	}
 
-	void clear_peer(uint8_t idx) {								// clears the peer in the by idx defined place in the database
-		if (idx >= max) return;									// to secure we are in the range
-		clear_eeprom(ee_addr + (idx * 4), 4);					// clear the specific eeprom block
+	void clear_peer(uint8_t idx) {								// removes the peer and its list from the pool, see peer_dev_release()
+		uint16_t addr = peer_pool.get_rec_addr(cnl, idx);
+		if (!addr) return;										// to secure we are in the range
+		peer_pool.release(addr, peer_pool.get_rec_len(cnl));
+		used--;
 	}
 
 	uint8_t get_idx(uint8_t *buf) {								// returns the idx of the given peer, or 0xff if not found. don't use the peer array of the struct, it will be overwritten!
 		if (!*(uint32_t*)buf) return 0;							// for list0/1 requests the peer address is empty
-		for (uint8_t i = 0; i < max; i++) if (!memcmp(get_peer(i), buf, 4)) return i;
-		return 0xff;
+		return get_idx(peer_dev.get_idx(buf), buf[3]);
 	}
 
-	uint8_t get_free_slot() {									// returns the idx of an empty peer, or 0xff if not found. don't use the peer array of the struct, it will be overwritten!
-		for (uint8_t i = 0; i < max; i++) {
-			uint8_t *x = get_peer(i);
-			//dbg << F("x: ") << _HEX(x, 4) << '\n';
-			if (isEmpty(x, 4)) return i;
+	uint8_t get_idx(uint8_t dev, uint8_t pcnl) {				// returns the idx of the given device index and peer channel, or 0xff if not found
+		if (dev++ == 0xff) return 0xff;						// device is not known at all, records are holding idx + 1
+		uint8_t x[3], idx = 0;
+		for (uint16_t addr = peer_pool.ee_addr; addr < peer_pool.ee_addr + peer_pool.used; addr += peer_pool.get_rec_len(x[0])) {
+			get_eeprom(addr, 3, x);								// one walk through the pool, record header only
+			if (!peer_pool.is_rec_cnl(x[0])) break;
+			if (x[0] != cnl) continue;
+			if ((x[1] == dev) && (x[2] == pcnl)) return idx;
+			idx++;
 		}
 		return 0xff;
 	}
 
-	void clear_all() {											// clear all peers
-		//dbg << "ee:" << ee_addr << ", max:" << max << '\n';
-		clear_eeprom(ee_addr, max * 4);
+	uint8_t get_free_slot() {									// returns the idx of an empty peer, or 0xff if the channel or the pool is full
+		if (used >= max) return 0xff;
+		if (peer_pool.used + peer_pool.get_rec_len(cnl) > peer_pool.size) return 0xff;
+		return used;
 	}
 
 	uint8_t used_slots() {										// returns the amount of used slots
-		uint8_t retByte = 0;
-		for (uint8_t i = 0; i < max; i++) if (*(uint32_t*)get_peer(i)) retByte++;
-		return retByte;
+		return used;
 	}
 
 	uint8_t get_nr_slices(uint8_t byte_per_msg = 16) {			// calculates the amount of needed slices to send all peers depending on the given msg length in peers per message
@@ -293,10 +462,11 @@ typedef struct ts_peer_table {
 
 	uint8_t get_slice(uint8_t slice_nr, uint8_t *buf, uint8_t byte_per_msg = 16) {	// cpoies all known peers into the given buffer, as msg length is limited we use multipe messages
 		uint8_t byteCnt = 0, slcCnt = 0;						// start the byte and slice counter
-		for (uint8_t i = 0; i < max; i++) {						// step through the possible peer slots
-			get_eeprom(ee_addr + (i * 4), 4, &buf[byteCnt]);	// get the peer
-			if (!*(uint32_t*)&buf[byteCnt]) continue;			// continue if peer is empty
-			byteCnt += 4; 										// increase the byte counter while not empty 
+		for (uint8_t i = 0; i < used; i++) {					// step through the used peer slots
+			uint8_t *peer = get_peer(i);						// get the peer
+			if (!peer) break;									// idx above max, peer_pool.init() clamps used to max
+			memcpy(&buf[byteCnt], peer, 4);
+			byteCnt += 4; 										// increase the byte counter
 			if (byteCnt >= byte_per_msg) {						// string is full
 				if (slcCnt == slice_nr) goto end_get_slice;		// and we are in the right slice, return result
 				byteCnt = 0; slcCnt++;							// wrong slice, next slice from beginning
@@ -311,6 +481,29 @@ typedef struct ts_peer_table {
 
 
 
+class CM_MASTER;
+
+/*
+* @brief Line of the message dispatch table, used to sort out received messages in AS::process_message
+*
+* by03       - message type, lines in the table are sorted by this byte
+* by1x       - sub type in byte 10 or 11 as defined in key, 0xff matches any sub type
+* key        - which byte beside by03 identifies the message, see MSG_KEY
+* cnl        - how to resolve the channel module, see MSG_CNL
+* aes        - message has to be challenged if AES is activated in list0/1 of the channel module
+* keep       - handler takes care of the receive buffer, it will not be cleared afterwards
+* handler    - function to process the message, 0 if the message is known but needs no processing
+*/
+typedef struct ts_msg_dispatch {
+	uint8_t by03;						// message type
+	uint8_t by1x;						// sub type in byte 10 or 11, 0xff for any
+	uint8_t key  : 2;					// MSG_KEY, byte to compare by1x with
+	uint8_t cnl  : 3;					// MSG_CNL, rule to resolve the channel module
+	uint8_t aes  : 1;					// challenge the message if AES is active
+	uint8_t keep : 1;					// don't clear the receive buffer after processing
+	void(*handler)(CM_MASTER *pCM);		// function to process the message
+} s_msg_dispatch;
+
 /*
 * @brief Struct to hold the buffer for any received string with some flags for further processing
 *
@@ -327,6 +520,7 @@ typedef struct ts_peer_table {
 * prev_MSG_CNT - remember the last message counter to check if it is a repeated message
 *
 * clear()      - function to reset flags
+* get_dispatch - copies the matching line of the message dispatch table, returns 0 if the message is unknown
 */
 typedef struct ts_receive_message {
 
@@ -398,6 +592,7 @@ typedef struct ts_receive_message {
 	void clear() {						// function to reset flags
 		buf[0] = 0;
 	}
+	uint8_t get_dispatch(s_msg_dispatch *line);	// search the dispatch table for the received message, defined in as_main.cpp
 } s_rcv_msg;
 
 /*
@@ -538,7 +733,7 @@ typedef struct ts_peer_msg {
 	}
 	void prep_slot(void) {				// prepare the slot table
 		for (uint8_t i = 0; i < peerDB->max; i++) {
-			if (*(uint32_t*)peerDB->get_peer(i)) set_slot(i);
+			if (i < peerDB->used) set_slot(i);
 			else clear_slot(i);
 		}
 	}
@@ -562,12 +757,255 @@ typedef struct ts_pair_mode {
 
 /*
 * @brief Helper struct to remember on the config mode status in asksin main function
+* Values received by CONFIG_WRITE_INDEX2 are staged in RAM and committed once after CONFIG_END, a timeout or a NACK
+* of the config session discards the staged values.
+* The stage is a value copy of the open list, indexed like list->val, followed by a dirty bit per register. It is
+* defined in the user sketch with the size of the biggest lstC/lstP, see CONFIG_STAGE_SIZE().
 */
+extern uint8_t config_stage[];				// staged values and dirty bits, defined in the user sketch
+extern const uint8_t config_stage_len;		// size of the biggest list, defined in the user sketch
+#define CONFIG_STAGE_SIZE(len)  ((len) + ((len) + 7) / 8)
+
 typedef struct ts_config_mode {
 	uint8_t   active;						// indicates status, 1 if config mode is active
+	uint8_t   commit;						// 1 if the staged values are waiting for the commit
 	uint8_t   idx_peer;						// and the peer index
 	s_list_table *list;						// pointer to the respective list
 	waittimer timer;						// config mode timeout
+	uint8_t   stage_cnt;					// amount of staged registers
+
+	/* discard all staged values */
+	void stage_clear(void) {
+		stage_cnt = 0;
+		memset(config_stage + config_stage_len, 0, (config_stage_len + 7) / 8);
+	}
+
+	/* stage a register/value array, a register which is already staged gets the new value, unknown registers are
+	*  skipped like in update_list(). list->len is checked against config_stage_len by CONFIG_START */
+	void stage_array(uint8_t *buf, uint8_t len) {
+		for (uint8_t i = 0; i < len; i += 2) {
+			uint8_t *pos_in_reg = (uint8_t*)memchr_P(list->reg, buf[i], list->len);
+			if (!pos_in_reg) continue;
+			uint8_t idx = pos_in_reg - list->reg;
+			uint8_t *dirty = config_stage + config_stage_len + (idx >> 3);
+			if (!(*dirty & (1 << (idx & 7)))) stage_cnt++;
+			*dirty |= 1 << (idx & 7);
+			config_stage[idx] = buf[i + 1];
+		}
+	}
+
+	/* copy the staged values into the loaded list */
+	void stage_apply(void) {
+		for (uint8_t i = 0; i < list->len; i++) {
+			if (config_stage[config_stage_len + (i >> 3)] & (1 << (i & 7))) list->val[i] = config_stage[i];
+		}
+	}
 } s_config_mode;
 
+
+/*
+* @brief Scheduler, knows if something is due in AS::poll and how long the device may sleep
+*
+* Timer driven work is covered by the waittimer registry, waittimer::next_due() delivers the earliest deadline.
+* Work which is not bound to a timer registers a wake reason, see WAKE_REASON, and clears it when done.
+*
+* reason       - bitmask of registered wake reasons
+* set()        - register a wake reason
+* clear()      - clear a wake reason
+* mark()       - register or clear a wake reason depending on a status flag
+* sleep_time() - ms the device may sleep, 0 if something is due, WAITTIMER_NONE if no timer is armed
+* is_due()     - 1 if a wake reason is registered or a timer is due
+*
+* Channel modules with pending work are flagged in sched_cnl[], a bit per channel sized by cm_def[] in the user
+* sketch, the sketch asserts one line of cm_def[] per channel module of cmm[].
+*/
+extern uint8_t sched_cnl[];					// channel modules with pending work, defined in the user sketch
+extern const uint8_t cm_def_cnt;			// amount of channel modules in cm_def[] and bits in sched_cnl[]
+
+typedef struct ts_scheduler {
+	uint8_t reason;							// registered wake reasons
+
+	void set(uint8_t wake_reason) {
+		reason |= wake_reason;
+	}
+	void clear(uint8_t wake_reason) {
+		reason &= ~wake_reason;
+	}
+	void mark(uint8_t wake_reason, uint8_t status) {
+		if (status) set(wake_reason);
+		else clear(wake_reason);
+	}
+	uint32_t sleep_time(void) {
+		if (reason) return 0;
+		return waittimer::next_due();
+	}
+	uint8_t is_due(void) {
+		return (sleep_time()) ? 0 : 1;
+	}
+	void set_cnl(uint8_t channel) {
+		if (channel < cm_def_cnt) sched_cnl[channel >> 3] |= (1 << (channel & 7));
+	}
+	void mark_cnl(uint8_t channel, uint8_t status) {
+		if (channel >= cm_def_cnt) return;
+		if (status) sched_cnl[channel >> 3] |= (1 << (channel & 7));
+		else sched_cnl[channel >> 3] &= ~(1 << (channel & 7));
+	}
+	uint8_t take_cnl(uint8_t channel) {
+		if (channel >= cm_def_cnt) return 1;				// not covered by the bitmap, polled on every pass
+		uint8_t mask = 1 << (channel & 7);
+		uint8_t ret = sched_cnl[channel >> 3] & mask;
+		sched_cnl[channel >> 3] &= ~mask;
+		return ret;
+	}
+} s_scheduler;
+
+extern s_scheduler sched;
+
+
+/*
+* @brief Profiling counters of the main loop stages, compiled in with PRF_DBG in 00_debug-flag.h
+* Cycles are taken from get_cycles(), the resolution is the prescaler of the millis timer. The average is sum / cnt,
+* both are halved before they overflow, min and max are kept till the next clear().
+*/
+typedef struct ts_prf_stat {
+	uint16_t cnt;							// invocations
+	uint32_t min;							// shortest run in cycles
+	uint32_t max;							// longest run in cycles
+	uint32_t sum;							// all runs in cycles
+} s_prf_stat;
+
+typedef struct ts_prf {
+	s_prf_stat stat[PRF_STAGE::CNT];
+
+	void add(uint8_t stage, uint32_t start);
+	void clear(void);
+	static uint8_t msg_stage(uint8_t by03) {
+		if (by03 <= 0x02) return PRF_STAGE::MSG_DEVICE_INFO + by03;
+		if (by03 <= 0x04) return PRF_STAGE::MSG_AES;
+		if ((by03 >= 0x10) && (by03 <= 0x12)) return PRF_STAGE::MSG_INFO + by03 - 0x10;
+		return PRF_STAGE::MSG_PEER;
+	}
+	static uint8_t cnl_stage(uint8_t cnl) {
+		return (cnl < PRF_STAGE::CNT - PRF_STAGE::CNL) ? PRF_STAGE::CNL + cnl : PRF_STAGE::CNT - 1;
+	}
+} s_prf;
+
+extern s_prf prf;
+
+typedef struct ts_prf_scope {
+	uint8_t  stage;
+	uint32_t start;
+	ts_prf_scope(uint8_t prf_stage) : stage(prf_stage), start(get_cycles()) {}
+	~ts_prf_scope() { prf.add(stage, start); }
+} s_prf_scope;
+
+
+/*
+* @brief Energy accounting, compiled in with NRG_DBG in 00_debug-flag.h
+* tick() adds the time since the last tick to the current radio and mcu state and the charge of both to the current
+* context. The state changes are marked in the CC1101 functions and in POM::poll, the contexts by NRG() around the
+* message processing, the send function and the channel module polls. Eeprom writes are not measured, every write of
+* the storage backend counts NRG_EE_WRITE_US. Charge is in nAs (uA * ms), cnt and sum of a context are halved before
+* they overflow, like s_prf does, the charge per event stays. The currents are typical datasheet values of a
+* CC1101 at 868MHz and +10dBm and an ATmega328P at 8MHz and 3V, they can be overwritten in the user sketch.
+*/
+#ifndef NRG_UA_RX
+#define NRG_UA_RX          15000			// uA, CC1101 receiving
+#endif
+#ifndef NRG_UA_TX
+#define NRG_UA_TX          30000			// uA, CC1101 sending
+#endif
+#ifndef NRG_UA_BURST
+#define NRG_UA_BURST       30000			// uA, CC1101 sending the wake up burst
+#endif
+#ifndef NRG_UA_PWD
+#define NRG_UA_PWD         1				// uA, CC1101 in power down, 0.2uA rounded up
+#endif
+#ifndef NRG_UA_ACTIVE
+#define NRG_UA_ACTIVE      3500				// uA, mcu running
+#endif
+#ifndef NRG_UA_SLEEP
+#define NRG_UA_SLEEP       5				// uA, mcu in power down with the watchdog running
+#endif
+#ifndef NRG_UA_EEPROM
+#define NRG_UA_EEPROM      3000				// uA, eeprom programming on top of the mcu
+#endif
+#ifndef NRG_EE_WRITE_US
+#define NRG_EE_WRITE_US    3400				// us per write of the storage backend, internal eeprom byte write
+#endif
+#ifndef NRG_BAT_MAH
+#define NRG_BAT_MAH        2400				// mAh of the battery for the projection, 2 AA cells
+#endif
+
+typedef struct ts_nrg_ctx {
+	uint16_t cnt;							// events
+	uint32_t sum;							// charge of all events in nAs
+} s_nrg_ctx;
+
+typedef struct ts_nrg {
+	uint32_t  ms[NRG_STATE::CNT];			// time per state
+	uint16_t  us[NRG_STATE::CNT];			// and the part below a ms
+	s_nrg_ctx ctx[NRG_CTX::CNT];
+	uint8_t   radio;						// current radio state
+	uint8_t   mcu;							// current mcu state
+	uint8_t   cur;							// current context
+	uint32_t  last;							// get_micros() of the last tick
+
+	void tick(void);
+	void add(uint8_t state, uint32_t us);
+	void enter(uint8_t context);
+	void ee_write(void);
+	void clear(void);
+	void set_radio(uint8_t state) { tick(); radio = state; }
+	void set_mcu(uint8_t state) { tick(); mcu = state; }
+	static uint16_t current(uint8_t state);
+	static uint8_t msg_group(uint8_t by03) {
+		return s_prf::msg_stage(by03) - PRF_STAGE::MSG_DEVICE_INFO;
+	}
+	static uint8_t cnl_ctx(uint8_t cnl) {
+		return (cnl < NRG_CTX::CNT - NRG_CTX::CNL) ? NRG_CTX::CNL + cnl : NRG_CTX::CNT - 1;
+	}
+} s_nrg;
+
+extern s_nrg nrg;
+
+typedef struct ts_nrg_scope {
+	uint8_t prev;
+	ts_nrg_scope(uint8_t context) : prev(nrg.cur) { nrg.enter(context); }
+	~ts_nrg_scope() { nrg.tick(); nrg.cur = prev; }
+} s_nrg_scope;
+
+
+/*
+* @brief Ring buffer of binary trace records, compiled in with TRC_DBG in 00_debug-flag.h
+* Record: TRC_SYNC, id, arg, len, loop millis (4 byte, little endian), len bytes of data. A record which doesn't fit
+* is dropped and counted, the count is written as TRC_ID::LOST record as soon as there is space again. drain() writes
+* only whole records which fit into the serial send buffer, so it never blocks and ascii debug output written in
+* between never splits a record. A record has to be smaller than the serial send buffer, 64 byte on the AVR cores.
+*/
+#ifndef TRC_SIZE
+#define TRC_SIZE   128						// size of the trace ring, max 255, can be overwritten in the user sketch
+#endif
+#define TRC_SYNC   0xa5						// first byte of a record, never part of the ascii debug output
+#define TRC_HEAD   8						// record size without data
+
+typedef struct ts_trc {
+	uint8_t buf[TRC_SIZE];
+	uint8_t head;							// next byte to write
+	uint8_t tail;							// next byte to drain
+	uint8_t lost;							// records dropped since the last LOST record
+
+	uint8_t space(void) {
+		return TRC_SIZE - 1 - (uint8_t)((head + TRC_SIZE - tail) % TRC_SIZE);
+	}
+	void put(uint8_t byte) {
+		buf[head] = byte;
+		head = (head + 1) % TRC_SIZE;
+	}
+	void add(uint8_t id, uint8_t arg, uint8_t *data, uint8_t len);
+	void drain(void);
+} s_trc;
+
+extern s_trc trc;
+
 #endif
\ No newline at end of file
@@ -15,7 +15,9 @@
 #ifndef _HAL_H
 #define _HAL_H
 
-#if defined(ARDUINO) && ARDUINO >= 100
+#if defined(HAL_HOST)
+	#include "HAL_host.h"
+#elif defined(ARDUINO) && ARDUINO >= 100
 	#include "Arduino.h"
 #else
 	#include "WProgram.h"
@@ -37,6 +39,8 @@
 	#else
 		#error "No HAL definition for current MCU available!"
 	#endif
+#elif defined(HAL_HOST)
+	// linux host, everything is defined in HAL_host.h
 #else
 	#error "No HAL definition for current MCU available!"
 #endif
@@ -75,6 +79,7 @@ static void(*pci_ptr)(uint8_t vec, uint8_t pin, uint8_t flag);
 void register_PCINT(uint8_t pin_def);
 uint8_t check_PCINT(uint8_t pin_def, uint8_t debounce);
 void maintain_PCINT(uint8_t vec);
+uint8_t take_PCINT(void);																	// vectors with a pin change since the last call, see AS::poll()
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
@@ -87,14 +92,40 @@ uint8_t spi_send_byte(uint8_t send_byte);
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
-/*-- eeprom functions -----------------------------------------------------------------------------------------------------
-* eeprom is very hardware supplier related, therefor we define her some external functions which needs to be defined
+/*-- i2c functions --------------------------------------------------------------------------------------------------------
+* i2c is very hardware supplier related, therefor we define her some external functions which needs to be defined
 * in the hardware specific HAL file. for ATMEL it is defined in HAL_atmega.h.
 */
+void enable_i2c(void);
+uint8_t i2c_start(uint8_t addr_rw);
+uint8_t i2c_send_byte(uint8_t send_byte);
+uint8_t i2c_read_byte(uint8_t ack);
+void i2c_stop(void);
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- eeprom functions -----------------------------------------------------------------------------------------------------
+* the eeprom functions are hardware independent and defined in as_storage.cpp. they work on a storage backend which
+* is selected in the user sketch (internal eeprom, i2c eeprom, spi fram).
+* set_eeprom and clear_eeprom are queued and return immediately, get_eeprom always reflects the queued content.
+* poll_eeprom starts the background write back and returns 1 while something is pending, flush_eeprom is the barrier
+* which returns when everything is written (sleep, power fail).
+* write_next_eeprom is the write back step, called by the eeprom ready interrupt or by poll_eeprom.
+*/
 void init_eeprom(void);
 void get_eeprom(uint16_t addr, uint8_t len, void *ptr);
 void set_eeprom(uint16_t addr, uint8_t len, void *ptr);
 void clear_eeprom(uint16_t addr, uint16_t len);
+void flush_eeprom(void);
+uint8_t poll_eeprom(void);
+uint8_t write_next_eeprom(void);
+
+/* the internal eeprom is very hardware supplier related, the raw access functions are defined in HAL_<vendor>.h */
+void get_int_eeprom(uint16_t addr, uint8_t len, void *ptr);
+void set_int_eeprom(uint16_t addr, uint8_t byte);
+uint8_t is_int_eeprom_ready(void);
+void set_int_eeprom_irq(uint8_t enable);
+uint8_t get_int_eeprom_irq(void);
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
@@ -117,6 +148,20 @@ void init_millis_timer3(int16_t correct_ms = 0);
 #endif
 uint32_t get_millis(void);
 void add_millis(uint32_t ms);
+
+/* get_millis() needs an atomic block per call, therefore AS::poll() takes one snapshot per loop with snap_millis().
+* waittimer, debounce and debug output are working on the snapshot, get_millis() is the fresh read where the exact time is needed.
+* waittimer::set() takes a fresh snapshot, a timer armed after a blocking call starts at the real time.
+* a sketch which uses waittimer without calling hm.poll() has to call snap_millis() in its loop. */
+extern uint32_t loop_millis;
+void snap_millis(void);
+inline uint32_t get_loop_millis(void) { return loop_millis; }
+
+/* cpu cycles since start, taken from the millis timer, the resolution is the prescaler of the timer. used by PRF_DBG */
+uint32_t get_cycles(void);
+
+/* microseconds since start, taken from the millis timer like get_cycles, wraps after 71 minutes. used by NRG_DBG */
+uint32_t get_micros(void);
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
@@ -138,6 +183,8 @@ void startWDG32ms(void);
 void startWDG64ms(void);
 void startWDG256ms(void);
 void startWDG8192ms(void);
+uint16_t startWDGms(uint32_t sleep_ms);
+uint16_t getWDGms(void);
 void setSleep(void);
 
 void startWDG(void);
@@ -181,7 +228,7 @@ inline Print &operator <<(Print &obj, const _HEX &arg) {
 }
 
 enum _eTIME { _TIME };
-inline Print &operator <<(Print &obj, _eTIME arg) { obj.print('('); obj.print(get_millis()); obj.print(')'); return obj; }
+inline Print &operator <<(Print &obj, _eTIME) { obj.print('('); obj.print(get_loop_millis()); obj.print(')'); return obj; }
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
@@ -74,6 +74,7 @@ struct  s_pcint_vector {
 	uint32_t time;
 };
 volatile s_pcint_vector pcint_vector[pc_interrupt_vectors];									// define a struct for pc int processing
+static volatile uint8_t pcint_raised;														// bit per vector with a pin change, taken by take_PCINT()
 
 /* function to register a pin interrupt */
 void register_PCINT(uint8_t def_pin) {
@@ -105,7 +106,7 @@ uint8_t check_PCINT(uint8_t def_pin, uint8_t debounce) {
 	uint8_t prev = pcint_vector[vec].prev & bit ? 1 : 0;									// evaluate the previous pin status
 
 	if (status == prev) return status;														// check if something had changed since last time
-	if (debounce && ((get_millis() - pcint_vector[vec].time) < DEBOUNCE)) return status;	// seems there is a change, check if debounce is necassary and done
+	if (debounce && ((int32_t)(get_loop_millis() - pcint_vector[vec].time) < DEBOUNCE)) return status;// signed, the interrupt could be younger than the loop snapshot
 
 	pcint_vector[vec].prev ^= bit;															// if we are here, there was a change and debounce check was passed, remember for next time
 
@@ -117,6 +118,7 @@ uint8_t check_PCINT(uint8_t def_pin, uint8_t debounce) {
 void maintain_PCINT(uint8_t vec) {
 	pcint_vector[vec].curr = *pcint_vector[vec].PINREG & pcint_vector[vec].mask;			// read the pin port and mask out only pins registered
 	pcint_vector[vec].time = get_millis();													// store the time, if debounce is asked for
+	pcint_raised |= _BV(vec);																// the channel modules get a poll to check their pins
 
 	if (pci_ptr) {
 		uint8_t pin_int = pcint_vector[vec].curr ^ pcint_vector[vec].prev;					// evaluate the pin which raised the interrupt
@@ -124,6 +126,16 @@ void maintain_PCINT(uint8_t vec) {
 	}
 }
 
+/* vectors with a pin change since the last call, the flags are set by the interrupt */
+uint8_t take_PCINT(void) {
+	uint8_t vec;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		vec = pcint_raised;
+		pcint_raised = 0;
+	}
+	return vec;
+}
+
 /* interrupt vectors to catch pin change interrupts */
 #ifdef PCIE0
 ISR(PCINT0_vect) {
@@ -173,33 +185,101 @@ uint8_t spi_send_byte(uint8_t send_byte) {
 
 
 /*-- eeprom functions -----------------------------------------------------------------------------------------------------
-* to make the library more hardware independend all eeprom relevant functions are defined at one point
+* raw access to the internal eeprom, used by the INT_EEP storage backend. the write back cache and the public eeprom
+* functions are hardware independent and defined in as_storage.cpp.
+* set_int_eeprom starts the write of one byte and returns, is_int_eeprom_ready indicates the end of the write.
+* the EE_READY interrupt calls write_next_eeprom as long as it returns 1, afterwards the interrupt is disabled.
 */
 
-/* init the eeprom, can be enriched for a serial eeprom as well */
-void init_eeprom(void) {
-	// place the code to init a i2c eeprom
+/* read a block from the internal eeprom */
+void get_int_eeprom(uint16_t addr, uint8_t len, void *ptr) {
+	eeprom_read_block((void*)ptr, (const void*)addr, len);									// AVR GCC standard function, waits for a running write
 }
 
-/* read a specific eeprom address */
-void get_eeprom(uint16_t addr, uint8_t len, void *ptr) {
-	eeprom_read_block((void*)ptr, (const void*)addr, len);									// AVR GCC standard function
+/* start the write of one byte, the byte is only written if it differs */
+void set_int_eeprom(uint16_t addr, uint8_t byte) {
+	if (eeprom_read_byte((const uint8_t*)addr) == byte) return;								// update is much faster, while writes only when needed
+	eeprom_write_byte((uint8_t*)addr, byte);												// starts the write and returns without waiting
 }
 
-/* write a block to a specific eeprom address */
-void set_eeprom(uint16_t addr, uint8_t len, void *ptr) {
-	/* update is much faster, while writes only when needed; needs some byte more space
-	* but otherwise we run in timing issues */
-	eeprom_update_block((const void*)ptr, (void*)addr, len);								// AVR GCC standard function
+/* check if the last write was finished */
+uint8_t is_int_eeprom_ready(void) {
+	return eeprom_is_ready() ? 1 : 0;
 }
 
-/* and clear the eeprom */
-void clear_eeprom(uint16_t addr, uint16_t len) {
-	uint8_t tB = 0;
-	if (!len) return;
-	for (uint16_t l = 0; l < len; l++) {													// step through the bytes of eeprom
-		set_eeprom(addr + l, 1, (void*)&tB);
-	}
+/* enable or disable the eeprom ready interrupt */
+void set_int_eeprom_irq(uint8_t enable) {
+	if (enable) EECR |= _BV(EERIE);
+	else EECR &= ~_BV(EERIE);
+}
+
+/* returns 1 if the eeprom ready interrupt is enabled */
+uint8_t get_int_eeprom_irq(void) {
+	return (EECR & _BV(EERIE)) ? 1 : 0;
+}
+
+/* interrupt engine, fires as long as the eeprom is ready and disables itself if nothing is left to write */
+ISR(EE_READY_vect) {
+	if (!write_next_eeprom()) EECR &= ~_BV(EERIE);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- i2c functions --------------------------------------------------------------------------------------------------------
+* blocking twi master functions, needed for serial eeproms like the 24Cxx series. bus speed is 400khz, with a prescaler
+* of 1 the bit rate register is (F_CPU / 400000 - 16) / 2
+*/
+#define TW_STATUS_MASK        0xF8
+#define TW_START              0x08
+#define TW_REP_START          0x10
+#define TW_MT_SLA_ACK         0x18
+#define TW_MT_DATA_ACK        0x28
+#define TW_MR_SLA_ACK         0x40
+
+/* wait till the twi hardware has done the job and return the status */
+static uint8_t i2c_wait(void) {
+	while (!(TWCR & _BV(TWINT)));															// wait until transfer finished
+	return TWSR & TW_STATUS_MASK;
+}
+
+/* configures the twi port */
+void enable_i2c(void) {
+	power_twi_enable();																		// enable only needed functions
+	TWSR = 0;																				// prescaler 1
+	TWBR = ((F_CPU / 400000L) - 16) / 2;													// 400khz bus speed
+	TWCR = _BV(TWEN);
+}
+
+/* send a start condition and the address byte, returns 1 if the device answers with an ACK */
+uint8_t i2c_start(uint8_t addr_rw) {
+	TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);												// start condition
+	uint8_t status = i2c_wait();
+	if ((status != TW_START) && (status != TW_REP_START)) return 0;
+
+	TWDR = addr_rw;																			// device address incl read/write bit
+	TWCR = _BV(TWINT) | _BV(TWEN);
+	status = i2c_wait();
+	return ((status == TW_MT_SLA_ACK) || (status == TW_MR_SLA_ACK)) ? 1 : 0;
+}
+
+/* send one byte, returns 1 if the device answers with an ACK */
+uint8_t i2c_send_byte(uint8_t send_byte) {
+	TWDR = send_byte;
+	TWCR = _BV(TWINT) | _BV(TWEN);
+	return (i2c_wait() == TW_MT_DATA_ACK) ? 1 : 0;
+}
+
+/* read one byte, ack has to be 0 for the last byte */
+uint8_t i2c_read_byte(uint8_t ack) {
+	TWCR = _BV(TWINT) | _BV(TWEN) | ((ack) ? _BV(TWEA) : 0);
+	i2c_wait();
+	return TWDR;
+}
+
+/* send a stop condition */
+void i2c_stop(void) {
+	TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+	while (TWCR & _BV(TWSTO));																// wait till the stop condition is done
 }
 //- -----------------------------------------------------------------------------------------------------------------------
 
@@ -212,11 +292,19 @@ void clear_eeprom(uint16_t addr, uint16_t len) {
 */
 // https://github.com/zkemble/millis/blob/master/millis/
 static volatile uint32_t milliseconds;
-static volatile uint8_t timer = 255;
+volatile uint8_t timer = 255;
+uint32_t loop_millis;
 
 void add_millis(uint32_t ms) {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
 		milliseconds += ms;
+		loop_millis = milliseconds;															// time jumped, the snapshot follows
+	}
+}
+
+void snap_millis(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		loop_millis = milliseconds;
 	}
 }
 
@@ -228,6 +316,40 @@ uint32_t get_millis(void) {
 	return ms;
 }
 
+/* millis and the cycles within the current ms, read together from the millis timer */
+static uint32_t read_millis_timer(uint16_t *cycles) {
+	uint32_t ms;
+	uint16_t cnt = 0, top = 0;
+	uint8_t prescaler = 64, wrap = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ms = milliseconds;
+#ifdef TCNT0
+		if (timer == 0) { cnt = TCNT0; top = OCR0A; wrap = TIFR0 & _BV(OCF0A); }
+#endif
+#ifdef TCNT1
+		if (timer == 1) { cnt = TCNT1; top = OCR1A; wrap = TIFR1 & _BV(OCF1A); }
+#endif
+#ifdef TCNT2
+		if (timer == 2) { cnt = TCNT2; top = OCR2A; wrap = TIFR2 & _BV(OCF2A); prescaler = 32; }
+#endif
+	}
+	if ((wrap) && (cnt < (top >> 1))) ms++;													// the counter wrapped, but the interrupt is still pending
+	*cycles = cnt * prescaler;
+	return ms;
+}
+
+uint32_t get_cycles(void) {
+	uint16_t cycles;
+	uint32_t ms = read_millis_timer(&cycles);
+	return ms * (F_CPU / 1000) + cycles;
+}
+
+uint32_t get_micros(void) {
+	uint16_t cycles;
+	uint32_t ms = read_millis_timer(&cycles);
+	return ms * 1000 + cycles / (F_CPU / 1000000);
+}
+
 #ifdef TIMER0_COMPA_vect
 ISR(TIMER0_COMPA_vect) {
 	if (timer == 0) ++milliseconds;
@@ -326,6 +448,7 @@ uint16_t get_adc_value(uint8_t reg_admux) {
 * http://www.mikrocontroller.net/articles/Sleep_Mode#Idle_Mode
 */
 static uint16_t wdtSleep_TIME;																// variable to store the current mode, amount will be added after wakeup to the millis timer
+static volatile uint16_t wdtSleep_ADDED;													// time added by the interrupt since the last getWDGms()
 
 void startWDG32ms(void) {
 	WDTCSR |= (1 << WDCE) | (1 << WDE);
@@ -348,7 +471,35 @@ void startWDG8192ms(void) {
 	wdtSleep_TIME = 8192;
 }
 
+/* starts the longest watchdog period which fits into sleep_ms, periods are 16ms * 2^n up to 8192ms.
+*  returns the period in ms, 0 if sleep_ms is shorter than the shortest period */
+uint16_t startWDGms(uint32_t sleep_ms) {
+	uint8_t wdp = 9;																		// 8192ms
+	while ((wdp) && ((16UL << wdp) > sleep_ms)) wdp--;
+	if ((16UL << wdp) > sleep_ms) return 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {														// timed sequence, no interrupt in between
+		WDTCSR |= (1 << WDCE) | (1 << WDE);
+		WDTCSR = (1 << WDIE) | ((wdp & 0x08) ? (1 << WDP3) : 0) | ((wdp & 0x07) << WDP0);
+	}
+	wdtSleep_TIME = 16 << wdp;
+	return wdtSleep_TIME;
+}
+
+/* returns the ms the watchdog interrupt has added to the millis timer since the last call, a sleep which was ended
+*  by another interrupt before the watchdog fired adds nothing */
+uint16_t getWDGms(void) {
+	uint16_t ms;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ms = wdtSleep_ADDED;
+		wdtSleep_ADDED = 0;
+	}
+	return ms;
+}
+
 void setSleep(void) {
+	flush_eeprom();																			// nothing should stay in the eeprom cache while sleeping
+
 	// some power savings by switching off some CPU functionality
 	ADCSRA = 0;																				// disable ADC
 	backupPwrRegs();																		// save content of power reduction register and set it to all off
@@ -377,6 +528,7 @@ void    setSleepMode() {
 
 ISR(WDT_vect) {
 	add_millis(wdtSleep_TIME);																// nothing to do, only for waking up
+	wdtSleep_ADDED += wdtSleep_TIME;
 }
 //- -----------------------------------------------------------------------------------------------------------------------
 
@@ -63,6 +63,11 @@ const uint16_t ref_v_external = 1100;															// internal reference voltag
 //- -------------------------------------------------------------------------------------------------------------------------
 
 
+//- eeprom definitions ------------------------------------------------------------------------------------------------------
+const uint16_t int_eeprom_size = E2END + 1;													// size of the internal eeprom
+//- -------------------------------------------------------------------------------------------------------------------------
+
+
 //- pin definition ----------------------------------------------------------------------------------------------------------
 #define pc_interrupt_vectors 3																// amount of pin change interrupt vectors
 
@@ -0,0 +1,670 @@
+#if defined(HAL_HOST)
+
+
+#include "HAL.h"
+#include "as_communication.h"
+
+#include <time.h>
+
+
+/*-- pin functions --------------------------------------------------------------------------------------------------------
+* every virtual port has a direction, an output and an input register. the input is driven by the host with host_set_pin(),
+* an input which is not driven reads the output register, like a pin with or without pull up.
+* the pins of the cc1101 are handed over to the register model.
+*/
+#define PIN_PORT(pin_def)  ((pin_def) >> 3)
+#define PIN_BIT(pin_def)   _BV((pin_def) & 7)
+
+static uint8_t port_ddr[pc_interrupt_vectors];												// direction, 1 is output
+static uint8_t port_out[pc_interrupt_vectors];												// output register, pull up for inputs
+static uint8_t port_drv[pc_interrupt_vectors];												// input pins which are driven by the host
+static uint8_t port_ext[pc_interrupt_vectors];												// and their level
+
+static uint8_t get_port_input(uint8_t port) {
+	return (port_out[port] & ~port_drv[port]) | (port_ext[port] & port_drv[port] & ~port_ddr[port]) | (port_out[port] & port_ddr[port]);
+}
+
+/* set a specific pin as output */
+void set_pin_output(uint8_t pin_def) {
+	port_ddr[PIN_PORT(pin_def)] |= PIN_BIT(pin_def);
+}
+/* set the pin as input */
+void set_pin_input(uint8_t pin_def) {
+	port_ddr[PIN_PORT(pin_def)] &= ~PIN_BIT(pin_def);
+}
+
+/* set high level on specific pin */
+void set_pin_high(uint8_t pin_def) {
+	port_out[PIN_PORT(pin_def)] |= PIN_BIT(pin_def);
+	if (pin_def == host_cc1101.pin_csl) host_cc1101.select(0);								// chip select is low active
+}
+/* set a low level on a specific pin */
+void set_pin_low(uint8_t pin_def) {
+	port_out[PIN_PORT(pin_def)] &= ~PIN_BIT(pin_def);
+	if (pin_def == host_cc1101.pin_csl) host_cc1101.select(1);
+}
+/* detect a pin input if it is high or low */
+uint8_t get_pin_status(uint8_t pin_def) {
+	if (pin_def == host_cc1101.pin_gdo0) return host_cc1101.get_gdo0();
+	if (get_port_input(PIN_PORT(pin_def)) & PIN_BIT(pin_def)) return HIGH;
+	return LOW;
+}
+
+/* the host drives an input pin, a change raises the pin change interrupt if the pin is registered */
+void host_set_pin(uint8_t pin_def, uint8_t level) {
+	uint8_t port = PIN_PORT(pin_def);
+	port_drv[port] |= PIN_BIT(pin_def);
+	if (level) port_ext[port] |= PIN_BIT(pin_def);
+	else port_ext[port] &= ~PIN_BIT(pin_def);
+	maintain_PCINT(port);
+}
+/* level of an output pin, e.g. a led or a relay */
+uint8_t host_get_pin(uint8_t pin_def) {
+	return (port_out[PIN_PORT(pin_def)] & PIN_BIT(pin_def)) ? HIGH : LOW;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- interrupt functions --------------------------------------------------------------------------------------------------
+* same logic as in HAL_atmega.cpp, every virtual port is one vector. the interrupt is raised by host_set_pin().
+*/
+struct  s_pcint_vector {
+	uint8_t curr;
+	uint8_t prev;
+	uint8_t mask;
+	uint32_t time;
+};
+static s_pcint_vector pcint_vector[pc_interrupt_vectors];									// define a struct for pc int processing
+static uint8_t pcint_raised;																// bit per vector with a pin change, taken by take_PCINT()
+
+/* function to register a pin interrupt */
+void register_PCINT(uint8_t def_pin) {
+	set_pin_input(def_pin);																	// set the pin as input
+	set_pin_high(def_pin);																	// key is connected against ground, set it high to detect changes
+
+	uint8_t vec = PIN_PORT(def_pin);
+	pcint_vector[vec].curr |= get_pin_status(def_pin) ? PIN_BIT(def_pin) : 0;				// remember current status of the port bit
+	pcint_vector[vec].prev = pcint_vector[vec].curr;										// and set it as previous while we check for changes
+	pcint_vector[vec].mask |= PIN_BIT(def_pin);												// set the pin bit in the bitmask
+}
+
+/* period check if a pin interrupt had happend */
+uint8_t check_PCINT(uint8_t def_pin, uint8_t debounce) {
+	uint8_t vec = PIN_PORT(def_pin);
+	uint8_t bit = PIN_BIT(def_pin);
+
+	uint8_t status = pcint_vector[vec].curr & bit ? 1 : 0;									// evaluate the pin status
+	uint8_t prev = pcint_vector[vec].prev & bit ? 1 : 0;									// evaluate the previous pin status
+
+	if (status == prev) return status;														// check if something had changed since last time
+	if (debounce && ((int32_t)(get_loop_millis() - pcint_vector[vec].time) < DEBOUNCE)) return status;// signed, the interrupt could be younger than the loop snapshot
+
+	pcint_vector[vec].prev ^= bit;															// if we are here, there was a change and debounce check was passed, remember for next time
+
+	if (status) return 3;																	// pin is 1, old was 0
+	else return 2;																			// pin is 0, old was 1
+}
+
+/* internal function to handle pin change interrupts */
+void maintain_PCINT(uint8_t vec) {
+	uint8_t curr = get_port_input(vec) & pcint_vector[vec].mask;
+	if (curr == pcint_vector[vec].curr) return;												// no registered pin had changed, no interrupt
+	pcint_vector[vec].curr = curr;
+	pcint_vector[vec].time = get_millis();													// store the time, if debounce is asked for
+	pcint_raised |= 1 << vec;																// the channel modules get a poll to check their pins
+
+	if (pci_ptr) {
+		uint8_t pin_int = pcint_vector[vec].curr ^ pcint_vector[vec].prev;					// evaluate the pin which raised the interrupt
+		pci_ptr(vec, pin_int, pcint_vector[vec].curr & pin_int);							// callback the interrupt function in user sketch
+	}
+}
+
+/* vectors with a pin change since the last call, no interrupt on the host, host_set_pin() is in the same thread */
+uint8_t take_PCINT(void) {
+	uint8_t vec = pcint_raised;
+	pcint_raised = 0;
+	return vec;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- spi functions --------------------------------------------------------------------------------------------------------
+* the only device on the bus is the cc1101 register model, it is selected by its chip select pin
+*/
+void enable_spi(void) {
+}
+uint8_t spi_send_byte(uint8_t send_byte) {
+	return host_cc1101.transfer(send_byte);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- i2c functions --------------------------------------------------------------------------------------------------------
+* there is no device on the virtual i2c bus, every start condition is answered with a NACK
+*/
+void enable_i2c(void) {
+}
+uint8_t i2c_start(uint8_t) {
+	return 0;
+}
+uint8_t i2c_send_byte(uint8_t) {
+	return 0;
+}
+uint8_t i2c_read_byte(uint8_t) {
+	return 0xff;
+}
+void i2c_stop(void) {
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- eeprom functions -----------------------------------------------------------------------------------------------------
+* the internal eeprom is an array which starts like a virgin eeprom with 0xff. with host_open_eeprom() the content is
+* loaded from a file and every write goes also into the file, so the device keeps its pairing and peers between runs.
+* writes are done at once, the ready interrupt is fired by host_irq().
+*/
+static uint8_t int_eep[int_eeprom_size];
+static uint8_t int_eep_init;
+static uint8_t int_eep_irq;
+static FILE   *int_eep_file;
+
+static void init_int_eeprom(void) {
+	if (int_eep_init) return;
+	memset(int_eep, 0xff, sizeof(int_eep));
+	int_eep_init = 1;
+}
+
+uint8_t host_open_eeprom(const char *file_name) {
+	init_int_eeprom();
+	int_eep_file = fopen(file_name, "r+b");
+	if (int_eep_file) {																		// existing file, load the content
+		fread(int_eep, 1, sizeof(int_eep), int_eep_file);
+		return 1;
+	}
+
+	int_eep_file = fopen(file_name, "w+b");													// new file, write the virgin content
+	if (!int_eep_file) return 0;
+	fwrite(int_eep, 1, sizeof(int_eep), int_eep_file);
+	fflush(int_eep_file);
+	return 1;
+}
+
+/* read a block from the internal eeprom */
+void get_int_eeprom(uint16_t addr, uint8_t len, void *ptr) {
+	init_int_eeprom();
+	memcpy(ptr, int_eep + addr, len);
+}
+
+/* write one byte, the file is updated on the fly */
+void set_int_eeprom(uint16_t addr, uint8_t byte) {
+	init_int_eeprom();
+	if (int_eep[addr] == byte) return;
+	int_eep[addr] = byte;
+
+	if (!int_eep_file) return;
+	fseek(int_eep_file, addr, SEEK_SET);
+	fputc(byte, int_eep_file);
+	fflush(int_eep_file);
+}
+
+/* writes are done at once */
+uint8_t is_int_eeprom_ready(void) {
+	return 1;
+}
+
+/* enable or disable the eeprom ready interrupt */
+void set_int_eeprom_irq(uint8_t enable) {
+	int_eep_irq = enable;
+}
+
+/* returns 1 if the eeprom ready interrupt is enabled */
+uint8_t get_int_eeprom_irq(void) {
+	return int_eep_irq;
+}
+
+/* interrupt engine, the host calls it between two loops, one byte per call like the EE_READY interrupt */
+void host_irq(void) {
+	if ((int_eep_irq) && (!write_next_eeprom())) int_eep_irq = 0;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/* a network of nodes needs one HMID per node, register.h takes it over in firstTimeStart() */
+uint8_t host_hmid[3];
+
+
+/*-- timer functions ------------------------------------------------------------------------------------------------------
+* the virtual clock runs in microseconds, it is moved by the host with host_advance(), by the busy waits of the library
+* and by sleeping. time doesn't pass while code is running, a loop takes no time if the host doesn't say so.
+* get_cycles() is different, it returns the cpu time of the host converted into F_CPU cycles, so the profiling of PRF_DBG
+* measures the code on the host cpu. get_micros() follows the virtual clock, the energy accounting of NRG_DBG needs the
+* time of the device.
+*/
+static uint64_t host_us;
+uint32_t loop_millis;
+
+void init_millis_timer0(int16_t) {
+}
+
+void host_advance(uint32_t us) {
+	host_us += us;
+}
+
+uint64_t host_get_us(void) {
+	return host_us;
+}
+
+void _delay_ms(double ms) {
+	host_us += (uint64_t)(ms * 1000);
+}
+
+void _delay_us(double us) {
+	host_us += (uint64_t)us;
+}
+
+void add_millis(uint32_t ms) {
+	host_us += (uint64_t)ms * 1000;
+	loop_millis = get_millis();																// time jumped, the snapshot follows
+}
+
+void snap_millis(void) {
+	loop_millis = get_millis();
+}
+
+uint32_t get_millis(void) {
+	return (uint32_t)(host_us / 1000);
+}
+
+uint32_t get_micros(void) {
+	return (uint32_t)host_us;
+}
+
+uint32_t get_cycles(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	return (uint32_t)(ns * (F_CPU / 1000000) / 1000);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- battery measurement functions ----------------------------------------------------------------------------------------
+* the ADC returns the raw value which is set by the host, the calculation is the same as in HAL_atmega.cpp.
+* default is 375, which is 3.0V for the internal measurement.
+*/
+static uint16_t host_adc = 375;
+
+void host_set_adc(uint16_t value) {
+	host_adc = value;
+}
+
+/* internal measurement */
+uint8_t get_internal_voltage(void) {
+	uint16_t result = host_adc;
+	if (!result) return 0xff;
+	result = 11253L / result;																// calculate Vcc (in mV); 11253 = 1.1*1023*10 (*10 while we want to get 10mv)
+	return (uint8_t)result;
+}
+
+/* external measurement */
+uint8_t get_external_voltage(uint8_t pin_enable, uint8_t pin_measure, uint8_t z1, uint8_t z2) {
+	set_pin_output(pin_enable);
+	set_pin_low(pin_enable);
+	set_pin_input(pin_measure);
+
+	uint32_t result = host_adc;
+	result = ((result * 1100) / 102) / z1;													// calculate vcc between gnd and measurement pin, internal reference
+	result = result * (z1 + z2) / 100;														// interpolate result to vcc
+
+	set_pin_input(pin_enable);
+	set_pin_input(pin_measure);
+	return result;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- power saving functions ----------------------------------------------------------------------------------------
+* sleeping moves the virtual clock till the watchdog fires, or till the next event of the host which would wake up the
+* device by an interrupt. the watchdog time is not added by add_millis(), the virtual clock is the real time.
+*/
+static uint16_t wdtSleep_TIME;
+static uint16_t wdtSleep_ADDED;
+static uint8_t  wdt_active;
+static uint32_t host_sleep_limit = 0xffffffff;
+static uint8_t  host_sleeping;
+
+void host_set_sleep_limit(uint32_t ms) {
+	host_sleep_limit = ms;
+}
+
+uint8_t host_get_sleeping(void) {
+	uint8_t ret = host_sleeping;
+	host_sleeping = 0;
+	return ret;
+}
+
+void startWDG32ms(void) {
+	wdtSleep_TIME = 32;
+	wdt_active = 1;
+}
+void startWDG64ms(void) {
+	wdtSleep_TIME = 64;
+	wdt_active = 1;
+}
+void startWDG256ms(void) {
+	wdtSleep_TIME = 256;
+	wdt_active = 1;
+}
+void startWDG8192ms(void) {
+	wdtSleep_TIME = 8192;
+	wdt_active = 1;
+}
+
+/* same periods as the atmega watchdog, 16ms * 2^n up to 8192ms */
+uint16_t startWDGms(uint32_t sleep_ms) {
+	uint8_t wdp = 9;																		// 8192ms
+	while ((wdp) && ((16UL << wdp) > sleep_ms)) wdp--;
+	if ((16UL << wdp) > sleep_ms) return 0;
+
+	wdtSleep_TIME = 16 << wdp;
+	wdt_active = 1;
+	return wdtSleep_TIME;
+}
+
+/* the virtual clock does not lose the time of an early wake up, it is reported as well */
+uint16_t getWDGms(void) {
+	uint16_t ms = wdtSleep_ADDED;
+	wdtSleep_ADDED = 0;
+	return ms;
+}
+
+void setSleep(void) {
+	flush_eeprom();																			// nothing should stay in the eeprom cache while sleeping
+
+	uint32_t now = get_millis();
+	uint32_t wake = host_sleep_limit;
+	if ((wdt_active) && ((uint32_t)(wake - now) > wdtSleep_TIME)) wake = now + wdtSleep_TIME;
+	if ((int32_t)(wake - now) > 0) host_us += (uint64_t)(wake - now) * 1000;
+	if ((wdt_active) && ((int32_t)(wake - now) > 0)) wdtSleep_ADDED += wake - now;
+	host_sleeping = 1;
+}
+
+void startWDG() {
+	wdt_active = 1;
+}
+void stopWDG() {
+	wdt_active = 0;
+}
+void setSleepMode() {
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+uint16_t freeRam() {
+	return 0;
+}
+
+
+
+/*************************************************************************************************************************/
+/*************************************************************************************************************************/
+/* - arduino replacements ---------------------------------------------------------------------------------------------- */
+/*************************************************************************************************************************/
+/*************************************************************************************************************************/
+
+//- print functions, same output as the arduino print class ---------------------------------------------------------------
+static size_t print_number(Print *obj, unsigned long num, uint8_t base) {
+	char buf[8 * sizeof(long) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+	*str = '\0';
+	if (base < 2) base = 10;
+	do {
+		uint8_t digit = num % base;
+		*--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+		num /= base;
+	} while (num);
+	return obj->print(str);
+}
+
+size_t Print::write(const uint8_t *buf, size_t len) {
+	size_t n = 0;
+	while (len--) n += write(*buf++);
+	return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+	return print(reinterpret_cast<const char*>(str));
+}
+size_t Print::print(const char *str) {
+	return write((const uint8_t*)str, strlen(str));
+}
+size_t Print::print(char c) {
+	return write((uint8_t)c);
+}
+size_t Print::print(unsigned char num, int base) {
+	return print((unsigned long)num, base);
+}
+size_t Print::print(int num, int base) {
+	return print((long)num, base);
+}
+size_t Print::print(unsigned int num, int base) {
+	return print((unsigned long)num, base);
+}
+size_t Print::print(long num, int base) {
+	if ((base == 10) && (num < 0)) return print('-') + print_number(this, -num, 10);
+	return print_number(this, num, base);
+}
+size_t Print::print(unsigned long num, int base) {
+	return print_number(this, num, base);
+}
+size_t Print::print(double num, int digits) {
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.*f", digits, num);
+	return print(buf);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+//- serial interface, output goes to stdout, input is filled by the host --------------------------------------------------
+HardwareSerial Serial;
+static char     ser_buf[64];
+static uint8_t  ser_head, ser_tail;
+
+void host_serial_input(const char *str) {
+	while (*str) {
+		uint8_t next = (ser_head + 1) % sizeof(ser_buf);
+		if (next == ser_tail) return;														// buffer is full, like a real uart we lose characters
+		ser_buf[ser_head] = *str++;
+		ser_head = next;
+	}
+}
+
+int HardwareSerial::available(void) {
+	return (ser_head - ser_tail + sizeof(ser_buf)) % sizeof(ser_buf);
+}
+int HardwareSerial::read(void) {
+	if (ser_head == ser_tail) return -1;
+	uint8_t c = ser_buf[ser_tail];
+	ser_tail = (ser_tail + 1) % sizeof(ser_buf);
+	return c;
+}
+void HardwareSerial::flush(void) {
+	fflush(stdout);
+}
+size_t HardwareSerial::write(uint8_t byte) {
+	putchar(byte);
+	return 1;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*************************************************************************************************************************/
+/*************************************************************************************************************************/
+/* - cc1101 register model --------------------------------------------------------------------------------------------- */
+/*************************************************************************************************************************/
+/*************************************************************************************************************************/
+
+/* the model knows what the CC1101 class in as_communication.cpp is using - config and status register, strobes, the fifos
+*  and the GDO0 pin. frames are encoded on the air like on the real air interface, the host sees them decoded.
+*  timing: the state machine is switching at once, a transmission takes the air time at 10kBaud, 0.8ms per byte */
+#define CC_AIR_US_PER_BYTE   800
+#define CC_AIR_OVERHEAD      10																// preamble 4, sync 4, crc 2 byte
+
+s_host_cc1101 host_cc1101;
+
+static void cc_encode(uint8_t *buf) {
+	buf[1] = (~buf[1]) ^ 0x89;
+	uint8_t buf2 = buf[2];
+	uint8_t prev = buf[1];
+
+	uint8_t i;
+	for (i = 2; i < buf[0]; i++) {
+		prev = (prev + 0xDC) ^ buf[i];
+		buf[i] = prev;
+	}
+	buf[i] ^= buf2;
+}
+
+static void cc_decode(uint8_t *buf) {
+	uint8_t prev = buf[1];
+	buf[1] = (~buf[1]) ^ 0x89;
+
+	uint8_t i, t;
+	for (i = 2; i < buf[0]; i++) {
+		t = buf[i];
+		buf[i] = (prev + 0xDC) ^ buf[i];
+		prev = t;
+	}
+	buf[i] ^= buf[2];
+}
+
+void s_host_cc1101::attach(uint8_t csl, uint8_t miso, uint8_t gdo0_pin) {
+	pin_csl = csl;
+	pin_miso = miso;
+	pin_gdo0 = gdo0_pin;
+	reset();
+}
+
+void s_host_cc1101::reset(void) {
+	memset(reg, 0, sizeof(reg));
+	patable = 0;
+	state = MARCSTATE_IDLE;
+	rx_len = rx_pos = tx_len = 0;
+	gdo0 = 0;
+	tx_busy = 0;
+}
+
+/* a frame from outside, it is received only in RX state. returns 0 if the frame is lost */
+uint8_t s_host_cc1101::receive(uint8_t *buf, uint8_t rssi) {
+	if ((state != MARCSTATE_RX) || (buf[0] > 61)) return 0;
+
+	memcpy(rx_fifo, buf, buf[0] + 1);
+	cc_encode(rx_fifo);
+	rx_fifo[buf[0] + 1] = rssi;																// appended status, rssi and lqi with crc ok flag
+	rx_fifo[buf[0] + 2] = 0x80;
+	rx_len = buf[0] + 3;
+	rx_pos = 0;
+	gdo0 = 1;																				// sync word detected, falls at the end of the packet
+	rx_cnt++;
+	return 1;
+}
+
+/* chip select, a TX fifo which was written is sent when the chip gets deselected */
+void s_host_cc1101::select(uint8_t active) {
+	if (active) {
+		if (state == MARCSTATE_SLEEP) state = MARCSTATE_IDLE;								// power down ends with chip select
+		cnt = 0;
+		return;
+	}
+
+	if ((cnt) && (header == (CC1101_TXFIFO | WRITE_BURST)) && (state == MARCSTATE_TX) && (tx_len)) {
+		uint8_t buf[64];
+		memcpy(buf, tx_fifo, tx_len);
+		cc_decode(buf);
+		uint8_t burst = ((host_get_us() - tx_start) >= 300000) ? 1 : 0;						// carrier without data for 360ms is a burst
+		tx_end = host_get_us() + (uint64_t)(tx_len + CC_AIR_OVERHEAD) * CC_AIR_US_PER_BYTE;
+		tx_busy = 1;
+		tx_len = 0;
+		tx_cnt++;
+		if (on_tx) on_tx(buf, burst);
+	}
+	cnt = 0;
+}
+
+/* one byte on the spi bus, the first byte after chip select is the header */
+uint8_t s_host_cc1101::transfer(uint8_t byte) {
+	if (!cnt++) {
+		header = byte;
+		uint8_t addr = byte & 0x3f;
+		if ((addr >= CC1101_SRES) && (addr <= CC1101_SNOP) && (!(byte & WRITE_BURST))) {	// strobe
+			switch (addr) {
+			case CC1101_SRES:  reset(); break;
+			case CC1101_SCAL:
+			case CC1101_SIDLE: state = MARCSTATE_IDLE; tx_busy = 0; break;
+			case CC1101_SRX:   state = MARCSTATE_RX; break;
+			case CC1101_STX:   state = MARCSTATE_TX; tx_len = 0; tx_start = host_get_us(); break;
+			case CC1101_SPWD:  state = MARCSTATE_SLEEP; break;
+			case CC1101_SFRX:  rx_len = rx_pos = 0; break;
+			case CC1101_SFTX:  tx_len = 0; break;
+			}
+		}
+		return state << 4;																	// chip status byte
+	}
+
+	uint8_t addr = header & 0x3f;
+	uint8_t read = header & READ_SINGLE;
+	uint8_t burst = header & WRITE_BURST;
+
+	if (addr == CC1101_RXFIFO) {															// fifos
+		if (read) return (rx_pos < rx_len) ? rx_fifo[rx_pos++] : 0;
+		if (tx_len < sizeof(tx_fifo)) tx_fifo[tx_len++] = byte;
+		return 0;
+	}
+
+	if (addr == CC1101_PATABLE) {
+		if (!read) patable = byte;
+		return patable;
+	}
+
+	if ((read) && (burst) && (addr >= CC1101_PARTNUM)) {									// status register
+		switch (addr) {
+		case CC1101_PARTNUM:   return 0;
+		case CC1101_VERSION:   return 4;
+		case CC1101_MARCSTATE:
+			if ((state == MARCSTATE_TX) && (tx_busy) && (host_get_us() >= tx_end)) {		// frame is sent, MCSM1 switches to RX
+				state = MARCSTATE_RX;
+				tx_busy = 0;
+			}
+			return state;
+		case CC1101_PKTSTATUS: return (carrier) ? 0x40 : 0x10;								// carrier sense or channel clear
+		case CC1101_RXBYTES:   return rx_len - rx_pos;
+		case CC1101_TXBYTES:   return tx_len;
+		}
+		return 0;
+	}
+
+	addr += (burst) ? cnt - 2 : 0;															// config register, burst access increments the address
+	if (addr >= sizeof(reg)) return 0;
+	if (!read) reg[addr] = byte;
+	return reg[addr];
+}
+
+/* GDO0 is asserted while a packet is received, the first read after the reception sees the high level,
+*  the next one the falling edge at the end of the packet */
+uint8_t s_host_cc1101::get_gdo0(void) {
+	uint8_t ret = gdo0;
+	gdo0 = 0;
+	return ret;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+#endif
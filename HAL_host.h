@@ -0,0 +1,195 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin hardware abstraction layer for a linux host --------------------------------------------------------------------
+*  Selected in HAL.h if HAL_HOST is defined. The library, the channel modules and a device sketch are compiled with the
+*  native compiler into a linux executable, see host/Makefile. This file replaces Arduino.h and the HAL_<cpu>.h,
+*  the functions are defined in HAL_host.cpp.
+*  The hardware is simulated - pins and pin change interrupts, a file backed internal eeprom, a virtual clock which
+*  is driven by the host, the ADC and a register model of the CC1101 on the SPI bus.
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#ifndef _HAL_HOST_H
+#define _HAL_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#undef BIG_ENDIAN																			// glibc has its own, HAL.h defines the one of the library
+
+
+//- arduino and avr-libc replacements -------------------------------------------------------------------------------------
+#ifndef F_CPU
+#define F_CPU 8000000UL																		// the virtual cpu runs with 8MHz like most of the devices
+#endif
+
+#define PROGMEM
+#define pgm_read_byte(x)        (*(const uint8_t*)(x))
+#define pgm_read_word(x)        (*(const uint16_t*)(x))
+#define memcpy_P                memcpy
+#define strlen_P                strlen
+#define memchr_P                memchr
+
+class __FlashStringHelper;
+#define F(x)                    (reinterpret_cast<const __FlashStringHelper*>(x))
+
+#define HIGH                    1
+#define LOW                     0
+#define DEC                     10
+#define HEX                     16
+#define _BV(bit)                (1 << (bit))
+
+#define sei()
+#define cli()
+#define power_all_disable()
+#define power_debug_enable()
+
+void _delay_ms(double ms);																	// busy waits are advancing the virtual clock
+void _delay_us(double us);
+
+class Print {
+public:																						//----------------------------------------------------------------------------------------------------------------
+	virtual size_t write(uint8_t byte) = 0;
+	size_t write(const uint8_t *buf, size_t len);
+
+	size_t print(const __FlashStringHelper *str);
+	size_t print(const char *str);
+	size_t print(char c);
+	size_t print(unsigned char num, int base = DEC);
+	size_t print(int num, int base = DEC);
+	size_t print(unsigned int num, int base = DEC);
+	size_t print(long num, int base = DEC);
+	size_t print(unsigned long num, int base = DEC);
+	size_t print(double num, int digits = 2);
+};
+
+class HardwareSerial : public Print {
+public:																						//----------------------------------------------------------------------------------------------------------------
+	using Print::write;
+
+	void    begin(unsigned long) {}
+	int     available(void);
+	int     read(void);
+	int     availableForWrite(void) { return 64; }
+	void    flush(void);
+	size_t  write(uint8_t byte);
+	operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+//- timer definitions -----------------------------------------------------------------------------------------------------
+#define hasTimer0																			// virtual timer, init_millis_timer0() only resets the clock
+//- -------------------------------------------------------------------------------------------------------------------------
+
+
+//- eeprom definitions ------------------------------------------------------------------------------------------------------
+const uint16_t int_eeprom_size = 1024;														// same size as on the atmega328 and 32U4
+//- -------------------------------------------------------------------------------------------------------------------------
+
+
+//- pin definition ----------------------------------------------------------------------------------------------------------
+/* virtual ports B to F with 8 pins each, every port is one pin change interrupt vector.
+*  the names are the same as for the atmega, so a register.h can be used without changes */
+#define pc_interrupt_vectors 5																// amount of pin change interrupt vectors
+
+#define pinB0 (0)
+#define pinB1 (1)
+#define pinB2 (2)
+#define pinB3 (3)
+#define pinB4 (4)
+#define pinB5 (5)
+#define pinB6 (6)
+#define pinB7 (7)
+
+#define pinC0 (8)
+#define pinC1 (9)
+#define pinC2 (10)
+#define pinC3 (11)
+#define pinC4 (12)
+#define pinC5 (13)
+#define pinC6 (14)
+#define pinC7 (15)
+
+#define pinD0 (16)
+#define pinD1 (17)
+#define pinD2 (18)
+#define pinD3 (19)
+#define pinD4 (20)
+#define pinD5 (21)
+#define pinD6 (22)
+#define pinD7 (23)
+
+#define pinE0 (24)
+#define pinE1 (25)
+#define pinE2 (26)
+#define pinE3 (27)
+#define pinE4 (28)
+#define pinE5 (29)
+#define pinE6 (30)
+#define pinE7 (31)
+
+#define pinF0 (32)
+#define pinF1 (33)
+#define pinF2 (34)
+#define pinF3 (35)
+#define pinF4 (36)
+#define pinF5 (37)
+#define pinF6 (38)
+#define pinF7 (39)
+//- -------------------------------------------------------------------------------------------------------------------------
+
+
+/*-- host control ---------------------------------------------------------------------------------------------------------
+* functions for the host side, the test driver in host/ uses them to play the role of the outside world.
+* the virtual clock runs in microseconds and only moves if the host advances it, a busy wait or a sleep of the device.
+*/
+void     host_advance(uint32_t us);															// move the virtual clock forward
+uint64_t host_get_us(void);																	// current time of the virtual clock
+void     host_set_sleep_limit(uint32_t ms);													// a sleep ends at this time at latest, next event of the host
+uint8_t  host_get_sleeping(void);															// 1 while the device was sleeping since the last call
+
+void     host_set_pin(uint8_t pin_def, uint8_t level);										// drive an input pin from outside, raises the pin change interrupt
+uint8_t  host_get_pin(uint8_t pin_def);														// level of an output pin
+void     host_set_adc(uint16_t value);														// raw value of the ADC, 10 bit
+uint8_t  host_open_eeprom(const char *file_name);											// load the internal eeprom from a file and keep it in sync
+void     host_serial_input(const char *str);												// characters for Serial.read()
+void     host_irq(void);																	// pending interrupts, the eeprom ready interrupt
+extern uint8_t host_hmid[3];																// HMID for the first start, 00 00 00 keeps the one of HMSerialData
+
+/* register model of the CC1101, driven by spi_send_byte() and the chip select pin.
+*  the pins are taken from the CC1101 constructor in register.h, the model doesn't know them by itself */
+struct s_host_cc1101 {
+	uint8_t  pin_csl = 0xff, pin_miso = 0xff, pin_gdo0 = 0xff;								// pins of the module, 0xff until attach()
+	uint8_t  reg[0x30];																		// configuration register
+	uint8_t  patable;
+	uint8_t  state;																			// MARCSTATE
+	uint8_t  carrier;																		// carrier sense, a burst is in the air
+
+	uint8_t  rx_fifo[64], rx_len, rx_pos;													// received frame, length byte + data + rssi + lqi
+	uint8_t  tx_fifo[64], tx_len;															// frame which is written by the device
+	uint8_t  tx_busy;																		// frame is on the air
+	uint8_t  gdo0;																			// level of the GDO0 pin
+	uint64_t tx_start, tx_end;																// begin of TX state and end of the frame in the virtual clock
+	uint32_t tx_cnt, rx_cnt;																// frames in both directions
+
+	uint8_t  header, cnt;																	// spi transfer, first byte and byte counter
+	void (*on_tx)(uint8_t *buf, uint8_t burst);												// hook for every sent frame, buf is decoded, buf[0] is the length
+
+	void     attach(uint8_t csl, uint8_t miso, uint8_t gdo0_pin);
+	void     reset(void);
+	uint8_t  receive(uint8_t *buf, uint8_t rssi);											// frame from outside, decoded like in the m> logs
+	void     select(uint8_t active);														// chip select changed
+	uint8_t  transfer(uint8_t byte);														// one byte on the spi bus
+	uint8_t  get_gdo0(void);
+};
+extern s_host_cc1101 host_cc1101;
+//- -----------------------------------------------------------------------------------------------------------------------
+
+#endif
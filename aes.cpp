@@ -94,6 +94,7 @@ void aes_init(const void* key, uint16_t keysize_b, aes_genctx_t* ctx) {
 	}
 }
 
+#ifndef AES_FAST
 void aes128_enc(void* buffer, aes128_ctx_t* ctx) {
 	aes_encrypt_core((aes_cipher_state_t*)buffer, (aes_genctx_t*)ctx, 10);
 }
@@ -102,6 +103,84 @@ void aes128_dec(void* buffer, aes128_ctx_t* ctx) {
 	aes_decrypt_core((aes_cipher_state_t*)buffer, (aes_genctx_t*)ctx, 10);
 }
 
+#else
+// - speed optimized AES-128, see AES_FAST in aes.h. the state is column wise, byte r of column c is s[4 * c + r]
+#define SBOX(a)    pgm_read_byte(aes_sbox + (a))
+#define INVSBOX(a) pgm_read_byte(aes_invsbox + (a))
+
+static inline uint8_t aes_xtime(uint8_t a) {
+	return (a << 1) ^ ((a & 0x80) ? 0x1b : 0x00);
+}
+static inline void aes_addkey(uint8_t* s, const uint8_t* k) {
+	for (uint8_t i = 0; i < 16; i++) s[i] ^= k[i];
+}
+static void aes_subshift(uint8_t* s) {
+	uint8_t t;
+	s[0] = SBOX(s[0]); s[4] = SBOX(s[4]); s[8] = SBOX(s[8]); s[12] = SBOX(s[12]);
+	/* row 1 one to the left */
+	t = s[1]; s[1] = SBOX(s[5]); s[5] = SBOX(s[9]); s[9] = SBOX(s[13]); s[13] = SBOX(t);
+	/* row 2 two to the left */
+	t = s[2]; s[2] = SBOX(s[10]); s[10] = SBOX(t);
+	t = s[6]; s[6] = SBOX(s[14]); s[14] = SBOX(t);
+	/* row 3 three to the left, which is one to the right */
+	t = s[15]; s[15] = SBOX(s[11]); s[11] = SBOX(s[7]); s[7] = SBOX(s[3]); s[3] = SBOX(t);
+}
+static void aes_invsubshift(uint8_t* s) {
+	uint8_t t;
+	s[0] = INVSBOX(s[0]); s[4] = INVSBOX(s[4]); s[8] = INVSBOX(s[8]); s[12] = INVSBOX(s[12]);
+	t = s[13]; s[13] = INVSBOX(s[9]); s[9] = INVSBOX(s[5]); s[5] = INVSBOX(s[1]); s[1] = INVSBOX(t);
+	t = s[2]; s[2] = INVSBOX(s[10]); s[10] = INVSBOX(t);
+	t = s[6]; s[6] = INVSBOX(s[14]); s[14] = INVSBOX(t);
+	t = s[3]; s[3] = INVSBOX(s[7]); s[7] = INVSBOX(s[11]); s[11] = INVSBOX(s[15]); s[15] = INVSBOX(t);
+}
+static void aes_mixcol(uint8_t* s) {
+	for (uint8_t i = 0; i < 4; i++, s += 4) {
+		uint8_t a0 = s[0], t = s[0] ^ s[1] ^ s[2] ^ s[3];
+		s[0] ^= t ^ aes_xtime(s[0] ^ s[1]);
+		s[1] ^= t ^ aes_xtime(s[1] ^ s[2]);
+		s[2] ^= t ^ aes_xtime(s[2] ^ s[3]);
+		s[3] ^= t ^ aes_xtime(s[3] ^ a0);
+	}
+}
+static void aes_invmixcol(uint8_t* s) {
+	/* InvMixColumns is MixColumns after a multiplication with 4 x^2 + 5, see "The Design of Rijndael", 4.1.3 */
+	uint8_t* c = s;
+	for (uint8_t i = 0; i < 4; i++, c += 4) {
+		uint8_t u = aes_xtime(aes_xtime(c[0] ^ c[2]));
+		uint8_t v = aes_xtime(aes_xtime(c[1] ^ c[3]));
+		c[0] ^= u; c[1] ^= v; c[2] ^= u; c[3] ^= v;
+	}
+	aes_mixcol(s);
+}
+
+void aes128_enc(void* buffer, aes128_ctx_t* ctx) {
+	uint8_t* s = (uint8_t*)buffer;
+	const uint8_t* k = ctx->key[0].ks;
+	aes_addkey(s, k);
+	for (uint8_t r = 1; r < 10; r++) {
+		aes_subshift(s);
+		aes_mixcol(s);
+		aes_addkey(s, k += 16);
+	}
+	aes_subshift(s);
+	aes_addkey(s, k + 16);
+}
+
+void aes128_dec(void* buffer, aes128_ctx_t* ctx) {
+	uint8_t* s = (uint8_t*)buffer;
+	const uint8_t* k = ctx->key[10].ks;
+	aes_addkey(s, k);
+	for (uint8_t r = 1; r < 10; r++) {
+		aes_invsubshift(s);
+		aes_addkey(s, k -= 16);
+		aes_invmixcol(s);
+	}
+	aes_invsubshift(s);
+	aes_addkey(s, k - 16);
+}
+
+#endif
+
 
 // - non public ----------------------------------------------------------------------------
 
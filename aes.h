@@ -19,6 +19,14 @@
 
 #include <stdint.h>
 
+/*
+* @brief Remove the double slash to get the speed optimized backend of aes128_enc() and aes128_dec(). MixColumns is done
+*        with xtime() instead of the gf256mul() bit loop, InvMixColumns is reduced to MixColumns by two xtime() per
+*        column, and shiftRows goes together with subBytes without the helper calls. The rounds are fixed to the 10
+*        of AES-128. Same API and key schedule. Faster for more flash, the aes_fast config of bench/ has the numbers.
+*/
+//#define AES_FAST
+
 
 typedef struct {
 	uint8_t ks[16];
@@ -20,6 +20,9 @@ void AES::prep_AES_REPLY(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *challeng
 void AES::check_AES_REPLY(uint8_t *hmkey, uint8_t *rcv_buf) {
 }
 uint8_t AES::check_SEND_AES_TO_ACTOR(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *rcv_buf) {
+	return 0;
+}
+void AES::poll(uint8_t *) {
 }
 
 
@@ -32,21 +35,26 @@ NO_AES::NO_AES() : AES() {
 
 /* HAS_AES functions to overwrite AES main class */
 HAS_AES::HAS_AES() : AES() {
+	ctx_key = AES_CTX::NONE;
+	hmkey_ready = 0;
 }
 void HAS_AES::prep_AES_REQ(uint8_t *hmkey, uint8_t *rcv_buf, uint8_t *snd_buf) {
 	/* save the initial message for later use */
 	memcpy(prev_buf, rcv_buf, rcv_buf[0] + 1);				// we store the initial message
 	active = MSG_AES::AES_REQ;								// set the flag that something is in the buffer
 
-	/* here we make a temporarily key with the challenge and the HMKEY, as we need this for later signature verification */
+	/* the temporarily key of the challenge and the HMKEY is needed for the signature verification, but not before the
+	*  AES_REPLY is here. so the key expansion is left to poll(), which is called after the AES_REQ is sent */
 	get_random(snd_buf + 11);								// six random bytes to the payload
-	make_temp_hmkey(hmkey, snd_buf + 11);					// generate a temp key
+	memcpy(challenge, snd_buf + 11, 6);						// remember the challenge
+	ctx_key = AES_CTX::REQ_PENDING;
 }
 
 void HAS_AES::prep_AES_REPLY(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *challenge, uint8_t *snd_buf) {
 	//dbg << "key: " << _HEX(hmkey, 16) << ", idx: " << _HEXB(hmkey_index[0]) << ", challenge: " << _HEX(challenge, 7) << ", snd_buf: " << _HEX(snd_buf, snd_buf[0] + 1) << '\n';
 	/* we need a key to encrypt */
 	make_temp_hmkey(hmkey, challenge);						// build the temporarily key from challenge
+	ctx_key = AES_CTX::REPLY;								// the one of our own AES_REQ is gone
 
 	/* the iv and a message to encrypt */
 	get_random(prev_buf);									// fill the first 6 byte with random
@@ -60,6 +68,18 @@ void HAS_AES::prep_AES_REPLY(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *chal
 }
 
 void HAS_AES::check_AES_REPLY(uint8_t *hmkey, uint8_t *rcv_buf) {
+	/* a reply without our challenge has nothing to compare with, prev_buf is empty or an old one */
+	if (active != MSG_AES::AES_REQ) {
+		rcv_buf[0] = 0;										// nothing to do any more
+		return;
+	}
+
+	/* normally poll() has prepared the temp key already, otherwise it has to be done now */
+	if (ctx_key != AES_CTX::REQ) {
+		make_temp_hmkey(hmkey, challenge);
+		ctx_key = AES_CTX::REQ;
+	}
+
 	/* decrypt it and check if the content compares to the last received message */
 	prep_iv(prev_buf); 										// some cleanup and preparation of iv variable
 	aes128_dec(rcv_buf + 10, &ctx);							// decrypt payload with temporarily key first time
@@ -85,8 +105,8 @@ void HAS_AES::check_AES_REPLY(uint8_t *hmkey, uint8_t *rcv_buf) {
 uint8_t HAS_AES::check_SEND_AES_TO_ACTOR(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *rcv_buf) {
 	/* a new hmkey will be delivered in two messages, identifikation is based on the hmkey index in byte 11, the first 8 byte of
 	* the key are flagged by an even index, the next 8 byte by an odd index. the key index we have to remember has to be divided by 2 */
-	aes128_init(hmkey, &ctx);								// load HMKEY
-	aes128_dec(rcv_buf + 10, &ctx);							// decrypt payload width HMKEY first time
+	load_hmkey(hmkey);										// round keys of the HMKEY, expanded only if it was changed
+	aes128_dec(rcv_buf + 10, &hmkey_ctx);					// decrypt payload width HMKEY first time
 
 	if (rcv_buf[10] != 0x01) return 0;						// byte 10 needs to be 0x01 
 	uint8_t slice = rcv_buf[11] & 1;						// we are here while it was a valid decrypt, now analyze if it is the first, or second part of the new hmkey 
@@ -97,14 +117,32 @@ uint8_t HAS_AES::check_SEND_AES_TO_ACTOR(uint8_t *hmkey, uint8_t *hmkey_index, u
 	else return 0;
 }
 
+void HAS_AES::poll(uint8_t *hmkey) {
+	/* the key expansions are done here, while we wait for an answer, and not while a message is checked */
+	if (ctx_key == AES_CTX::REQ_PENDING) {
+		make_temp_hmkey(hmkey, challenge);					// temp key of the AES_REQ we have sent
+		ctx_key = AES_CTX::REQ;
+	} else load_hmkey(hmkey);								// or the HMKEY, if it was changed
+}
+
 void HAS_AES::make_temp_hmkey(uint8_t *hmkey, uint8_t *challenge) {
+	uint8_t temp_hmkey[16];
 	memcpy(temp_hmkey, hmkey, 16);
 	for (uint8_t i = 0; i < 6; i++) temp_hmkey[i] ^= challenge[i];
 	aes128_init(temp_hmkey, &ctx);
 }
 
+void HAS_AES::load_hmkey(uint8_t *hmkey) {
+	if ((hmkey_ready) && (!memcmp(hmkey_copy, hmkey, 16))) return;
+	memcpy(hmkey_copy, hmkey, 16);							// new or changed HMKEY, expand it
+	hmkey_ready = 1;
+	aes128_init(hmkey, &hmkey_ctx);
+}
+
 void HAS_AES::prep_iv(uint8_t *buf) {
+	uint8_t len = (buf[0] > 10) ? buf[0] - 10 : 0;			// payload of the initial message, the iv has 16 byte
+	if (len > 16) len = 16;
 	memset(iv, 0x00, 16);
-	memcpy(iv, buf + 11, buf[0] - 10);						// copy payload of initial message into IV
+	memcpy(iv, buf + 11, len);								// copy payload of initial message into IV
 }
 
@@ -19,6 +19,11 @@ namespace MSG_AES {
 	enum E : uint8_t { NONE = 0, AES_REQ = 1, AES_REPLY_OK = 2, };
 };
 
+/* what the round keys in HAS_AES::ctx belong to, the temp hmkey of our own AES_REQ waits in REQ_PENDING for poll() */
+namespace AES_CTX {
+	enum E : uint8_t { NONE = 0, REQ_PENDING = 1, REQ = 2, REPLY = 3, };
+};
+
 #define MaxDataLen 40
 
 /*
@@ -42,6 +47,7 @@ public:
 	virtual void prep_AES_REPLY(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *challenge, uint8_t *snd_buf);
 	virtual void check_AES_REPLY(uint8_t *hmkey, uint8_t *rcv_buf);
 	virtual uint8_t check_SEND_AES_TO_ACTOR(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *rcv_buf);
+	virtual void poll(uint8_t *hmkey);
 
 };
 
@@ -59,9 +65,13 @@ public:
 class HAS_AES : public AES {
 
 protected:
-	uint8_t  temp_hmkey[16];									// temp hmkey 
 	uint8_t  iv[16];
-	aes128_ctx_t ctx; 											// the context where the round keys are stored
+	uint8_t  challenge[6];										// challenge of our last AES_REQ
+	AES_CTX::E ctx_key;											// what the round keys in ctx belong to
+	uint8_t  hmkey_copy[16];									// the HMKEY of hmkey_ctx, to see if it was changed
+	uint8_t  hmkey_ready;										// hmkey_ctx holds the round keys of hmkey_copy
+	aes128_ctx_t ctx; 											// the context where the round keys of the temp hmkey are stored
+	aes128_ctx_t hmkey_ctx;										// and the round keys of the HMKEY
 
 public:
 	HAS_AES(void);
@@ -69,9 +79,11 @@ public:
 	void prep_AES_REPLY(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *challenge, uint8_t *snd_buf);
 	void check_AES_REPLY(uint8_t *hmkey, uint8_t *rcv_buf);
 	uint8_t check_SEND_AES_TO_ACTOR(uint8_t *hmkey, uint8_t *hmkey_index, uint8_t *rcv_buf);
+	void poll(uint8_t *hmkey);
 
 private:
 	void make_temp_hmkey(uint8_t *hmkey, uint8_t *challenge);
+	void load_hmkey(uint8_t *hmkey);
 	void prep_iv(uint8_t *buf);
 
 };
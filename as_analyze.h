@@ -17,6 +17,7 @@
 extern s_rcv_msg rcv_msg;
 extern s_snd_msg snd_msg;
 extern LED led;
+extern POM pom;
 
 void explain_msg(void);
 void serialEvent(void);
@@ -24,117 +25,14 @@ void dumpEEprom(void);
 
 
 void explain_msg(void) {
-	uint8_t *by03 = &rcv_msg.mBody.MSG_TYP;
-	uint8_t *by10 = &rcv_msg.mBody.BY10;
-	uint8_t *by11 = &rcv_msg.mBody.BY11;
-
-
-	if (*by03 == BY03(MSG_TYPE::DEVICE_INFO)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::CONFIG_REQ)) {
-
-		if        (*by11 == BY11(MSG_TYPE::CONFIG_PEER_ADD)) {
-
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_PEER_REMOVE)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_PEER_LIST_REQ)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_PARAM_REQ)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_START)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_END)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_WRITE_INDEX1)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_WRITE_INDEX2)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_SERIAL_REQ)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_PAIR_SERIAL)) {
-		
-		} else if (*by11 == BY11(MSG_TYPE::CONFIG_STATUS_REQUEST)) {
-		
-		} else {
-
-		}
-
-	} else if (*by03 == BY03(MSG_TYPE::ACK_MSG)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::AES_REPLY)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SEND_AES)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::REPLY_MSG)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::INSTRUCTION_MSG)) {
-
-		if        (*by10 == BY10(MSG_TYPE::INSTRUCTION_RESET)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_ADAPTION_DRIVE_SET)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER2)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_INHIBIT_OFF)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_INHIBIT_ON)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_SET)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_STOP_CHANGE)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_LED)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_LED_ALL)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_LEVEL)) {
-		
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_SLEEPMODE)) {
-
-		} else if (*by10 == BY10(MSG_TYPE::INSTRUCTION_SET_TEMP)) {
-		
-		} else {
-
-		}
-
-	} else if (*by03 == BY03(MSG_TYPE::HAVE_DATA)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SWITCH)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::TIMESTAMP)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::REMOTE)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SENSOR_EVENT)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SWITCH_LEVEL)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SENSOR_DATA)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::GAS_EVENT)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::CLIMATE_EVENT)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::SET_TEAM_TEMP)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::THERMAL_CONTROL)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::POWER_EVENT_CYCLE)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::POWER_EVENT)) {
-
-	} else if (*by03 == BY03(MSG_TYPE::WEATHER_EVENT)) {
-
-
-	} else {
-		//dbg << F("AS:message not known - please report: ") << _HEX(rcv_msg.buf, rcv_msg.buf[0] + 1) << '\n';
-
-	}
-
-	DBG(RV, (char)rcv_msg.intend, F("> "), _HEX(rcv_msg.buf, rcv_msg.buf[0] + 1), ' ', _TIME, '\n');
+	TRC(RV, TRC_ID::RCV_MSG, rcv_msg.intend, rcv_msg.buf, rcv_msg.buf[0] + 1, (char)rcv_msg.intend, F("> "), _HEX(rcv_msg.buf, rcv_msg.buf[0] + 1), ' ', _TIME, '\n');
 
+#ifdef RV_DBG
+	/* messages for us are identified by the same dispatch table as in AS::process_message, report the ones which are not known */
+	s_msg_dispatch line;
+	if ((rcv_msg.intend != MSG_INTENT::MASTER) && (rcv_msg.intend != MSG_INTENT::PEER)) return;
+	if (!rcv_msg.get_dispatch(&line)) TRC(RV, TRC_ID::RCV_UNKNOWN, 0, 0, 0, F("  message not known - please report\n"));
+#endif
 }
 
 /*
@@ -158,6 +56,43 @@ void serialEvent(void) {
 			snd_msg.active = MSG_ACTIVE::DEBUG;
 			i = 0;
 			return;
+		} else if (inChar == 'p') {
+			for (uint8_t j = 1; j < POWER_MODE_CNT; j++) {									// sleep statistics per power mode
+				DBG(SER, F("pom "), j, F(": cnt "), pom.stat[j].cnt, F(", ms "), pom.stat[j].time, '\n');
+			}
+			i = 0;
+			return;
+		} else if (inChar == 't') {
+#ifdef PRF_DBG
+			for (uint8_t j = 0; j < PRF_STAGE::CNT; j++) {									// cycles per main loop stage, see PRF_STAGE
+				s_prf_stat *s = &prf.stat[j];
+				if (!s->cnt) continue;
+				DBG(SER, F("prf "), j, F(": cnt "), s->cnt, F(", min "), s->min, F(", max "), s->max, F(", avg "), s->sum / s->cnt, '\n');
+			}
+			prf.clear();
+#endif
+			i = 0;
+			return;
+		} else if (inChar == 'e') {
+#ifdef NRG_DBG
+			nrg.tick();
+			uint32_t ms = nrg.ms[NRG_STATE::ACTIVE] + nrg.ms[NRG_STATE::SLEEP];
+			uint64_t nas = 0;
+			for (uint8_t j = 0; j < NRG_STATE::CNT; j++) {									// time per state, see NRG_STATE
+				nas += (uint64_t)s_nrg::current(j) * nrg.ms[j];
+				DBG(SER, F("nrg state "), j, F(": ms "), nrg.ms[j], '\n');
+			}
+			for (uint8_t j = 0; j < NRG_CTX::CNT; j++) {									// charge per event, see NRG_CTX, 3600 nAs are 1 nAh
+				s_nrg_ctx *c = &nrg.ctx[j];
+				if (!c->cnt) continue;
+				DBG(SER, F("nrg ctx "), j, F(": cnt "), c->cnt, F(", nAs "), c->sum / c->cnt, '\n');
+			}
+			uint32_t ua = (ms) ? (uint32_t)(nas / ms) : 0;									// average current and the battery life with it
+			DBG(SER, F("nrg ms "), ms, F(", avg uA "), ua, F(", battery days "), (ua) ? (uint32_t)NRG_BAT_MAH * 1000 / ua / 24 : 0, '\n');
+			nrg.clear();
+#endif
+			i = 0;
+			return;
 		} else if (inChar == 'l') {
 			DBG(SER, F("led: "), _HEX(snd_msg.buf, 1), '\n');
 			led.set((LED_STAT::E)snd_msg.buf[0]);
@@ -210,10 +145,10 @@ void dumpEEprom(void) {
 
 			if (j == 3 || j == 4) {
 				dbg << F("cmModul:\n");
-				for (uint8_t k = 0; k < peer->max; k++) {
+				for (uint8_t k = 0; k < peer->used; k++) {
 					uint8_t *p = peer->get_peer(k);											// process peer
-					dbg << F("peer   ") << _HEX(k) << F(": ") << _HEX(p, 4) << F(" (") << peer->ee_addr + (k * 4) << F(")\n");
-					pAddr = list->ee_addr + (k * list->len);								// process list
+					pAddr = list->get_ee_addr(k);											// list is stored behind the record header in the pool
+					dbg << F("peer   ") << _HEX(k) << F(": ") << _HEX(p, 4) << F(" (") << pAddr - 3 << F(")\n");
 					get_eeprom(pAddr, list->len, x);
 					dbg << F("eeprom ") << _HEX(k) << F(": ") << _HEX(x, list->len) << F(" (") << pAddr << F(")\n");
 				}
@@ -175,6 +175,7 @@ void    CC1101::init(void) {
 	} DBG(CC, '4');																		// we are in receive mode
 
 	/* show that we are ready */
+	NRG_RADIO(NRG_STATE::RX);
 	DBG(CC, F(" - ready\n"));															// some debug
 	return;																				// everything done, return
 
@@ -202,6 +203,7 @@ void    CC1101::snd_data(uint8_t *buf, uint8_t burst) {
 	DBG(CC, F("<c"), _TIME, ' ');
 
 	/* enter TX and wait till state is confirmed */
+	NRG_RADIO(NRG_STATE::TX);
 	strobe(CC1101_STX);																	// ask for transmit mode
 	x = 200;																			// set the counter for timeout
 	do {																				// waits until module gets ready
@@ -212,7 +214,9 @@ void    CC1101::snd_data(uint8_t *buf, uint8_t burst) {
 
 	/* if we have to send a burst, we wait still longer */
 	if (burst) {																		// BURST-bit set?
+		NRG_RADIO(NRG_STATE::BURST);
 		_delay_ms(360);																	// according to ELV, devices get activated every 300ms, so send burst for 360ms
+		NRG_RADIO(NRG_STATE::TX);
 		DBG(CC, F("BURST"), _TIME, ' ');												// some debug
 	}
 	//DBG(CC, F("O:"), _HEX(buf, buf[0]+1), ' ');										// some debug
@@ -245,10 +249,12 @@ void    CC1101::snd_data(uint8_t *buf, uint8_t burst) {
 		if (!--x) goto snddata_failure;													// otherwise we could loop forever on a missing module
 	} 
 	DBG(CC, F("TX"), _TIME, F(" \n"));													// we are back in rx mode
+	NRG_RADIO(NRG_STATE::RX);
 
 	return;																				// nothing to do any more, return
 
 snddata_failure:
+	NRG_RADIO(NRG_STATE::RX);
 	DBG(CC, F("something went wrong...\n")); 
 }
 
@@ -335,6 +341,7 @@ void    CC1101::set_idle() {															// put CC1101 into power-down state
 	strobe(CC1101_SFRX);
 	strobe(CC1101_SPWD);																// enter power down state
 	pwr_down = 1;																		// remember power down state
+	NRG_RADIO(NRG_STATE::PWD);
 	//dbg << "pd\n";
 }
 
@@ -406,6 +413,7 @@ void   CC1101::setActive() {															// put CC1101 into active state
 		_delay_us(10);
 	}
 	pwr_down = 0;																		// remember active state
+	NRG_RADIO(NRG_STATE::RX);															// idle for a moment, then RX or TX
 	//dbg << "act\n";
 }
 
@@ -0,0 +1,185 @@
+/**
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin wear leveled eeprom ring store ---------------------------------------------------------------------------------
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include "newasksin.h"
+
+static EE_RING *ring_first;																	// first registered ring store
+
+/* the sequence runs from 1 to 254, 0x00 and 0xff are never used while they are the content of an empty eeprom */
+static uint8_t next_seq(uint8_t seq) {
+	return (seq >= 254) ? 1 : seq + 1;
+}
+
+/* check byte of a record, low byte of the crc16 over sequence and payload */
+static uint8_t calc_check(uint8_t seq, uint8_t len, uint8_t *buf) {
+	uint16_t crc = crc16(0xffff, seq);
+	for (uint8_t i = 0; i < len; i++) {
+		crc = crc16(crc, buf[i]);
+	}
+	return (uint8_t)crc;
+}
+
+
+/**
+* @brief Constructor, registers the ring store. The eeprom address is assigned later by ring_prep_default()
+*
+* @param rec_len Length of the payload per record
+* @param rec_max Amount of slots, between 2 and 253
+*/
+EE_RING::EE_RING(uint8_t rec_len, uint8_t rec_max) {
+	len = rec_len;
+	max = rec_max;
+	head = 0xff;
+
+	next = ring_first;																		// add the instance to the chain
+	ring_first = this;
+}
+
+/**
+* @brief Copies the payload of the newest record
+*
+* @return 1 if a record was found, 0 if the store is empty
+*/
+uint8_t EE_RING::read(void *ptr) {
+	if (head == 0xff) return 0;
+	get_eeprom(get_slot_addr(head) + 1, len, ptr);
+	return 1;
+}
+
+/**
+* @brief Appends a new record in the next slot. Payload first, check byte last - an interrupted write fails the check
+* and the previous record stays the valid one
+*/
+void EE_RING::write(void *ptr) {
+	if (head == 0xff) {																		// store is empty, start in the first slot
+		head = 0;
+		seq = 1;
+	} else {																				// next slot and sequence
+		head = (head + 1) % max;
+		seq = next_seq(seq);
+	}
+
+	uint16_t addr = get_slot_addr(head);
+	uint8_t chk = calc_check(seq, len, (uint8_t*)ptr);
+	set_eeprom(addr + 1, len, ptr);															// payload
+	set_eeprom(addr, 1, &seq);																// sequence number
+	set_eeprom(addr + 1 + len, 1, &chk);													// and the check byte
+	DBG(AS, F("RING:write- addr:"), addr, F(", seq:"), seq, '\n');
+}
+
+/**
+* @brief Invalidates all records
+*/
+void EE_RING::clear(void) {
+	clear_eeprom(ee_addr, max * (len + 2));
+	head = 0xff;
+}
+
+/**
+* @brief Search the newest record. Records are written in sequence, so the newest one is the last valid record
+* where the following slot doesn't hold the next sequence number. Only the sequence bytes are read, the check
+* byte is verified for the found candidate only.
+*/
+void EE_RING::scan(void) {
+	head = 0xff;
+
+	uint8_t cand = 0xff;
+	uint8_t curr = get_seq(0);
+	for (uint8_t i = 0; i < max; i++) {
+		uint8_t nxt = get_seq((i + 1) % max);
+		if ((curr) && (nxt != next_seq(curr))) {											// valid record without a successor
+			cand = i;
+			break;
+		}
+		curr = nxt;
+	}
+	if (cand == 0xff) return;																// no valid record found
+
+	/* the candidate could be a torn record, step back as long as the check fails */
+	for (uint8_t i = 0; i < max; i++) {
+		if (is_valid(cand)) {
+			head = cand;
+			seq = get_seq(cand);
+			break;
+		}
+		uint8_t prev = (cand) ? cand - 1 : max - 1;
+		if ((!get_seq(prev)) || (next_seq(get_seq(prev)) != get_seq(cand))) break;			// predecessor is not part of the chain
+		cand = prev;
+	}
+	DBG(AS, F("RING:scan- addr:"), ee_addr, F(", head:"), head, F(", seq:"), seq, '\n');
+}
+
+/* returns the sequence number of a slot, 0 if the slot is empty */
+uint8_t EE_RING::get_seq(uint8_t slot) {
+	uint8_t s;
+	get_eeprom(get_slot_addr(slot), 1, &s);
+	return (s == 0xff) ? 0 : s;
+}
+
+/* verifies the check byte of a slot */
+uint8_t EE_RING::is_valid(uint8_t slot) {
+	uint16_t addr = get_slot_addr(slot);
+	uint8_t s = get_seq(slot);
+	if (!s) return 0;
+
+	uint16_t crc = crc16(0xffff, s);														// same as calc_check, but byte wise from eeprom
+	for (uint8_t i = 0; i < len; i++) {
+		uint8_t b;
+		get_eeprom(addr + 1 + i, 1, &b);
+		crc = crc16(crc, b);
+	}
+	uint8_t chk;
+	get_eeprom(addr + 1 + len, 1, &chk);
+	return ((uint8_t)crc == chk) ? 1 : 0;
+}
+
+
+//- ring store related helpers --------------------------------------------------------------------------------------------
+
+/*
+* @brief Assign eeprom addresses to all ring stores, starting at the end of the channel module area
+* returns the next free eeprom address
+*/
+uint16_t ring_prep_default(uint16_t ee_start_addr) {
+	for (EE_RING *r = ring_first; r; r = r->next) {
+		r->ee_addr = ee_start_addr;
+		ee_start_addr += ee_ring_size_c(r->len, r->max);
+		DBG(AS, F("RING:prep_default- addr:"), r->ee_addr, F(", len:"), r->len, F(", max:"), r->max, '\n');
+	}
+	return ee_start_addr;
+}
+
+/*
+* @brief The layout of the ring stores is part of the magic crc, a change of the layout results in a first time start
+*/
+uint16_t ring_calc_crc(uint16_t crc) {
+	for (EE_RING *r = ring_first; r; r = r->next) {
+		crc = crc16(crc, r->len);
+		crc = crc16(crc, r->max);
+	}
+	return crc;
+}
+
+/*
+* @brief Clear all ring stores, needed on first time start
+*/
+void ring_clear_all(void) {
+	for (EE_RING *r = ring_first; r; r = r->next) {
+		r->clear();
+	}
+}
+
+/*
+* @brief Search the newest record in all ring stores, has to be called before the channel modules are initialized
+*/
+void ring_init(void) {
+	for (EE_RING *r = ring_first; r; r = r->next) {
+		r->scan();
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+/**
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin wear leveled eeprom ring store ---------------------------------------------------------------------------------
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#ifndef _AS_EE_RING_H
+#define _AS_EE_RING_H
+
+#include "HAL.h"
+
+
+/**
+* @short Wear leveled record store for values which are updated frequently
+*
+* Every instance reserves rec_max slots of rec_len + 2 byte in the eeprom, the area is assigned by ring_prep_default()
+* behind the channel module area. Each write appends a record to the next slot, so the load is spread over all slots.
+* A record looks like: seq (1 byte), data (rec_len byte), check (1 byte)
+* seq is counting from 1 to 254, 0x00 and 0xff indicate an empty slot (cleared or virgin eeprom). check is the low
+* byte of a crc16 over seq and data, a record interrupted by a power loss is ignored.
+* The newest record is found once at startup by searching the break in the sequence, afterwards read() and write()
+* are O(1).
+*
+* Usage in a channel module:
+* @code
+* EE_RING level_ring(1, 16);                       // 1 byte record, 16 slots = 48 byte eeprom
+* ...
+* if (!level_ring.read(&level)) level = 0;         // in cm_init, ring is scanned before cm_init is called
+* level_ring.write(&level);                        // whenever the value has to be persisted
+* @endcode
+*/
+class EE_RING {
+public:  //----------------------------------------------------------------------------------------------------------------
+	EE_RING(uint8_t rec_len, uint8_t rec_max);												// constructor, registers the instance
+
+	uint8_t read(void *ptr);																// copies the newest record to ptr, returns 0 if there is none
+	void    write(void *ptr);																// appends a new record
+	void    clear(void);																	// invalidates all records
+
+	void    scan(void);																		// search the newest record, called by ring_init()
+
+	EE_RING  *next;																			// chain of all registered ring stores
+	uint16_t ee_addr;																		// start address in eeprom, set by ring_prep_default()
+	uint8_t  len;																			// length of the payload
+	uint8_t  max;																			// amount of slots
+
+private:  //---------------------------------------------------------------------------------------------------------------
+	uint8_t  head;																			// slot of the newest record, 0xff if empty
+	uint8_t  seq;																			// sequence number of the newest record
+
+	uint16_t get_slot_addr(uint8_t slot) { return ee_addr + slot * (len + 2); }
+	uint8_t  get_seq(uint8_t slot);
+	uint8_t  is_valid(uint8_t slot);
+};
+
+
+//- ring store related helpers --------------------------------------------------------------------------------------------
+
+uint16_t ring_prep_default(uint16_t ee_start_addr);										// assign eeprom addresses to all ring stores
+uint16_t ring_calc_crc(uint16_t crc);														// add the ring store layout to the magic crc
+void ring_clear_all(void);																	// clear all ring stores, first time start
+void ring_init(void);																		// search the newest record in all ring stores
+
+/* eeprom space of a ring store, rec_max slots of seq, payload and check byte */
+constexpr uint16_t ee_ring_size_c(uint8_t rec_len, uint8_t rec_max) {
+	return (rec_len + 2) * rec_max;
+}
+
+/* ring stores of the library, msg_cnt_ring in as_main.cpp. as_ring_size goes into the eeprom size assert of the user
+*  sketch, ring stores of the sketch are added there by ee_ring_size_c() */
+#define MSG_CNT_RING_LEN  1
+#define MSG_CNT_RING_MAX  8
+constexpr uint16_t as_ring_size = ee_ring_size_c(MSG_CNT_RING_LEN, MSG_CNT_RING_MAX);
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+#endif
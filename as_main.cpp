@@ -13,6 +13,129 @@
 #include "as_analyze.h"
 
 
+/* the send message counter is persisted in a wear leveled ring store. to reduce eeprom writes not every counter
+* value is stored, a block of MSG_CNT_STEP is reserved in advance and the next start continues behind it */
+#define MSG_CNT_STEP  16
+static EE_RING msg_cnt_ring(MSG_CNT_RING_LEN, MSG_CNT_RING_MAX);							// 1 byte payload, 8 slots, 24 byte eeprom, see as_ring_size
+static uint8_t msg_cnt_reserved;															// message counter is valid till this value
+
+#ifdef PRF_DBG
+s_prf prf;																					// profiling counters of the main loop stages
+
+void s_prf::add(uint8_t stage, uint32_t start) {
+	uint32_t cycles = get_cycles() - start;
+	s_prf_stat *s = &stat[stage];
+	if ((s->cnt == 0xffff) || (s->sum & 0x80000000)) {										// halve both before they overflow, the average stays
+		s->cnt >>= 1;
+		s->sum >>= 1;
+	}
+	if ((!s->cnt) || (cycles < s->min)) s->min = cycles;
+	if (cycles > s->max) s->max = cycles;
+	s->cnt++;
+	s->sum += cycles;
+}
+
+void s_prf::clear(void) {
+	memset(stat, 0, sizeof(stat));
+}
+#endif
+
+#ifdef NRG_DBG
+s_nrg nrg = { {}, {}, {}, NRG_STATE::RX, NRG_STATE::ACTIVE, NRG_CTX::NONE, 0, };			// energy accounting
+
+void s_nrg::tick(void) {
+	uint32_t now = get_micros();
+	uint32_t us = now - last;
+	last = now;
+	add(radio, us);
+	add(mcu, us);
+	if (cur == NRG_CTX::NONE) return;
+
+	uint32_t ua = current(radio) + current(mcu);
+	uint32_t nas = ua * (us / 1000) + ua * (us % 1000) / 1000;								// charge in nAs, uA * ms
+	s_nrg_ctx *c = &ctx[cur];
+	if (c->sum > 0xffffffff - nas) {														// halve both before they overflow, the charge per event stays
+		c->cnt >>= 1;
+		c->sum >>= 1;
+	}
+	c->sum += nas;
+}
+
+void s_nrg::add(uint8_t state, uint32_t us) {
+	us += this->us[state];
+	ms[state] += us / 1000;
+	this->us[state] = us % 1000;
+}
+
+void s_nrg::enter(uint8_t context) {
+	tick();																					// the time till now belongs to the previous context
+	cur = context;
+	s_nrg_ctx *c = &ctx[context];
+	if (c->cnt == 0xffff) {
+		c->cnt >>= 1;
+		c->sum >>= 1;
+	}
+	c->cnt++;
+}
+
+void s_nrg::ee_write(void) {
+	add(NRG_STATE::EEPROM, NRG_EE_WRITE_US);												// not measured, the write runs in the background
+}
+
+void s_nrg::clear(void) {
+	memset(ms, 0, sizeof(ms));
+	memset(us, 0, sizeof(us));
+	memset(ctx, 0, sizeof(ctx));
+}
+
+uint16_t s_nrg::current(uint8_t state) {
+	static const uint16_t ua[NRG_STATE::CNT] PROGMEM = { NRG_UA_RX, NRG_UA_TX, NRG_UA_BURST, NRG_UA_PWD, NRG_UA_ACTIVE, NRG_UA_SLEEP, NRG_UA_EEPROM, };
+	return _PGM_WORD(ua[state]);
+}
+#endif
+
+#ifdef TRC_DBG
+s_trc trc;																					// binary trace ring of the send and receive module
+
+void s_trc::add(uint8_t id, uint8_t arg, uint8_t *data, uint8_t len) {
+	if (lost) {																				// report the dropped records first
+		if (space() < TRC_HEAD) {
+			if (lost < 255) lost++;
+			return;
+		}
+		uint8_t cnt = lost;
+		lost = 0;
+		add(TRC_ID::LOST, cnt, 0, 0);
+	}
+	if (space() < TRC_HEAD + len) {
+		lost = 1;
+		return;
+	}
+
+	uint32_t time = get_loop_millis();
+	put(TRC_SYNC);
+	put(id);
+	put(arg);
+	put(len);
+	for (uint8_t i = 0; i < 4; i++, time >>= 8) put(time & 0xff);
+	for (uint8_t i = 0; i < len; i++) put(data[i]);
+}
+
+void s_trc::drain(void) {
+	int16_t room = Serial.availableForWrite();
+	while (tail != head) {																	// whole records only, debug output in between can't split them
+		uint8_t len = TRC_HEAD + buf[(tail + 3) % TRC_SIZE];
+		if (room < len) break;
+		room -= len;
+		for (; len; len--) {
+			Serial.write(buf[tail]);
+			tail = (tail + 1) % TRC_SIZE;
+		}
+	}
+}
+#endif
+
+
 // public:		//---------------------------------------------------------------------------------------------------------
 AS::AS() {
 }
@@ -28,11 +151,22 @@ void AS::init(void) {
 	* prepare the defaults incl eeprom address map for the channel modules */
 	init_eeprom();		
 	uint16_t pAddr = cm_prep_default(sizeof(dev_ident));
+	pAddr = ring_prep_default(pAddr);														// ring stores are placed behind the channel modules
+	if (pAddr > eep->size) {																// the layout would run over the end of the eeprom,
+		DBG(AS, F("AS:init eeprom too small, needed: "), pAddr, F(", available: "), eep->size, '\n');
+		led.init();																			// refuse to start and show the error instead
+		led.set(LED_STAT::EEPROM_ERROR);
+		for (;;) {
+			snap_millis();
+			led.poll();
+		}
+	}
 
 	/* - First time start check is done via comparing a magic number at the start of the eeprom
 	* with the CRC of the different lists in the channel modules. Every time there was a
 	* change in the configuration some addresses are changed and we have to rewrite the eeprom content.	*/
-	uint16_t flashCRC = cm_calc_crc();														// calculate the crc of all channel module list0/1, list3/4
+	uint16_t flashCRC = crc16(crc16(crc16(cm_layout_crc, peer_dev.max), peer_pool.size >> 8), peer_pool.size & 0xff);
+	flashCRC = ring_calc_crc(flashCRC);														// crc of all channel module list0/1, list3/4 is calculated at compile time, add peer devices, pool and ring stores
 	get_eeprom(0, sizeof(dev_ident), &dev_ident);											// get magic byte and all other information from eeprom
 	DBG(AS, F("AS:init crc- flash:"), flashCRC, F(", eeprom: "), dev_ident.MAGIC, '\n');	// some debug
 
@@ -44,9 +178,12 @@ void AS::init(void) {
 		for (uint8_t i = 0; i < cnl_max; i++) {												// write the defaults in respective list0/1
 			cmm[i]->lstC.load_default();													// copy from progmem into array
 			cmm[i]->lstC.save_list();														// write it into the eeprom
-			cmm[i]->peerDB.clear_all();
 			DBG(AS, F("AS:write_defaults, cnl:"), cmm[i]->lstC.cnl, F(", lst:"), cmm[i]->lstC.lst, F(", len:"), cmm[i]->lstC.len, '\n');
 		}
+		peer_pool.clear_all();																// the peers of all channels
+		peer_dev.clear_all();																// the shared peer device table
+		ring_clear_all();																	// and all ring stores
+		cm_journal_clear();																	// and the config journal
 
 		/* - First time detected
 		* get the homematic id, serial number, aes key index and homematic aes key from flash and copy it into the eeprom
@@ -56,16 +193,41 @@ void AS::init(void) {
 		dev_ident.MAGIC = flashCRC;															// set new magic number
 		memcpy_P(((uint8_t*)&dev_ident) + 2, HMSerialData, sizeof(dev_ident) - 2);			// copy from PROGMEM
 		set_eeprom(0, sizeof(dev_ident), ((uint8_t*)&dev_ident));
-		while (!eeprom_is_ready());
+		ee_check.update(EE_BLOCK_IDENT);
 		DBG(AS, F("AS:writing new magic byte\n"));											// some debug
 
 		/* - function to be placed in register.h, to setup default values on first time start */
 		firstTimeStart();				
+
+	} else {
+		/* - finish a config commit or a peer pool compaction which was interrupted by a power loss */
+		cm_journal_recover();
+		peer_pool.recover();
+
+		/* - verify the device identity and the peer devices, corrupted blocks are restored */
+		ee_check.error = 0;
+		ee_check.verify(EE_BLOCK_IDENT);
+		ee_check.verify(EE_BLOCK_PEER_DEV);
 	}
 
+	/* count the peers of the channels in the peer pool */
+	peer_pool.init();
+
+
+	/* search the newest records in the ring stores, channel modules can use them in their init */
+	ring_init();
+
+	/* restore the message counter and reserve the next block */
+	msg_cnt_ring.read(&snd_msg.MSG_CNT);													// stays untouched if the store is empty
+	msg_cnt_reserved = snd_msg.MSG_CNT + MSG_CNT_STEP;
+	msg_cnt_ring.write(&msg_cnt_reserved);
+
+	/* the eeprom work above could take a while, refresh the time before the channel modules set their timers */
+	snap_millis();
 
 	/* load list 0 and 1 defaults and inform the channel modules */
 	for (uint8_t i = 0; i < cnl_max; i++) {													// step through all channels
+		ee_check.verify(EE_BLOCK_LIST + i);													// restore the defaults if the list is corrupted
 		cmm[i]->lstC.load_list();															// read the defaults in respective list0/1
 		inform_config_change(i);															// inform the channel modules
 		cmm[i]->init();																		// initialize the channel modules
@@ -80,6 +242,7 @@ void AS::init(void) {
 	cbn.init();																				// init the config button
 	led.init();																				// initialize the leds
 	led.set(LED_STAT::WELCOME);																// show something as status
+	if (ee_check.error) led.set(LED_STAT::EEPROM_ERROR);									// or a restored eeprom block
 
 }
 
@@ -91,35 +254,71 @@ void AS::init(void) {
 * and message delegation.
 */
 void AS::poll(void) {
+	snap_millis();																			// one atomic read of the time for the whole loop
+	NRG_TICK();																				// keeps the energy accounting within the wrap of get_micros()
+	waittimer::tick();																		// advance the timer wheel, if the backend is enabled in waittimer.h
+
+	/* the main class works only if something was received, a wake reason is registered or a waittimer is due,
+	*  otherwise we go straight to the modules which have to watch their pins or state machines by their own */
+	uint8_t rcv = com->has_data();															// has_data() reports the edge of GDO0 only once
+	if ((rcv) || (sched.is_due())) poll_due(rcv);
+
+	/* regular polls for the channel modules, a pin change gives all of them a poll to check their pins */
+	if (take_PCINT()) for (uint8_t i = 0; i < cnl_max; i++) sched.set_cnl(i);
+	cm_call_poll();																			// poll the flagged channel modules
+
+	PRF(PRF_STAGE::CBN, cbn.poll());														// poll the config button
+
+	/* register the wake reasons of the main class for the next round */
+	sched.mark(WAKE_REASON::RECEIVE,  rcv_msg.buf[0]);
+	sched.mark(WAKE_REASON::SEND,     snd_msg.active);
+	sched.mark(WAKE_REASON::LIST_MSG, list_msg.active);
+	sched.mark(WAKE_REASON::PEER_MSG, peer_msg.active);
+	sched.mark(WAKE_REASON::CONFIG,   config_mode.commit);
+	sched.mark(WAKE_REASON::RESET,    dev_operate.reset);
+
+	TRC_POLL();																				// drain the trace ring while idle
+	PRF(PRF_STAGE::POM, pom.poll());														// poll the power management
+}
+
+/*
+* @brief Work of the main class which is done only if something is due, called by poll()
+* rcv is the result of com->has_data() in poll()
+*/
+void AS::poll_due(uint8_t rcv) {
 
 	/* copy the decoded data into the receiver module if something was received
 	*  and poll the received buffer, it checks if something is in the queue  */
-	if (com->has_data()) {																	// check if something is in the cc1101 receive buffer
-		com->rcv_data(rcv_msg.buf);															// if yes, get it into our receive processing struct
-		rcv_poll();																			// and poll the receive function to get intent and some basics
+	if (rcv) {																				// check if something is in the cc1101 receive buffer
+		PRF(PRF_STAGE::RCV, com->rcv_data(rcv_msg.buf));									// if yes, get it into our receive processing struct
+		PRF(PRF_STAGE::RCV_POLL, rcv_poll());												// and poll the receive function to get intent and some basics
 	}
 	if (rcv_msg.buf[0]) process_message();													// check if we have to handle the receive buffer
 
 	/* handle the send module */
-	snd_poll();																				// check if there is something to send
+	PRF(PRF_STAGE::SND_POLL, snd_poll());													// check if there is something to send
+
+	/* key expansions of the aes module, done after the send while we are waiting for the answer */
+	aes->poll(dev_ident.HMKEY);
 
 	/* peer and register list messages are processed here */
-	process_list_message_poll();															// check if something has to be send slice wise
+	PRF(PRF_STAGE::LIST_POLL, process_list_message_poll());									// check if something has to be send slice wise
 
 	/* peer message poll, typically needed from channels with a list4 */
-	process_peer_message_poll();															// if we want to send a peer message we have to poll the peer send processing
+	PRF(PRF_STAGE::PEER_POLL, process_peer_message_poll());									// if we want to send a peer message we have to poll the peer send processing
 
 
 
-	/* time out the config flag */
+	/* time out the config flag, staged pairs of the session are discarded */
 	if (config_mode.active) {																// check only if we are still in config mode
-		if (config_mode.timer.done()) config_mode.active = 0;								// when timer is done, set config flag to inactive
+		if (config_mode.timer.done()) {														// when timer is done, set config flag to inactive
+			config_mode.active = 0;
+			config_mode.stage_clear();
+		}
 	}
 
-	/* regular polls for the channel modules */
-	for (uint8_t i = 0; i < cnl_max; i++) {													// poll all the registered channel modules
-		cmm[i]->poll();
-	}
+	/* commit a finished config session, but not before the ACK is out */
+	if ((config_mode.commit) && (!snd_msg.active)) process_config_commit();
 
 	/* check if the device needs a reset */
 	if (dev_operate.reset) {
@@ -140,10 +339,20 @@ void AS::poll(void) {
 	}
 
 
-	bat->poll();																			// poll the battery check
-	cbn.poll();																				// poll the config button
-	led.poll();																				// poll the led's
-	pom.poll();																				// poll the power management
+	/* message counter reached the reserved block, reserve the next one */
+	if ((uint8_t)(snd_msg.MSG_CNT - msg_cnt_reserved) < 128) {
+		msg_cnt_reserved = snd_msg.MSG_CNT + MSG_CNT_STEP;
+		msg_cnt_ring.write(&msg_cnt_reserved);
+	}
+
+	/* write back the eeprom cache in the background, but not within a config session to collapse repeated writes */
+	if (!config_mode.active) PRF(PRF_STAGE::EE_POLL, sched.mark(WAKE_REASON::EEPROM, poll_eeprom()));// non blocking, starts the interrupt engine
+
+	/* integrity check of the eeprom, one block at a time while nothing else is going on */
+	if ((!config_mode.active) && (!config_mode.commit) && (!snd_msg.active) && (!list_msg.active)) ee_check.poll();
+
+	PRF(PRF_STAGE::BAT, bat->poll());														// poll the battery check
+	PRF(PRF_STAGE::LED, led.poll());														// poll the led's
 }
 
 
@@ -167,7 +376,7 @@ void AS::rcv_poll(void) {
 
 	/* check for a repeated string which was already processed, after this the repeated flag doesn't matter anymore */
 	if ((rcv_msg.mBody.FLAG.RPTED) && (rcv_msg.prev_MSG_CNT == rcv_msg.mBody.MSG_CNT)) {
-		DBG(RV, F("  repeated...\n"));
+		TRC(RV, TRC_ID::RCV_REPEAT, 0, 0, 0, F("  repeated...\n"));
 		goto clear_rcv_poll;
 	}
 	rcv_msg.prev_MSG_CNT = rcv_msg.mBody.MSG_CNT;											// remember for next time
@@ -241,182 +450,230 @@ void AS::get_intend() {
 }
 
 /*
-* @brief Receive handler: Process received messages
-* Process message is called while rcv_msg.hasdata is set to TRUE. It takes all information from the rcv_msg struct.
-* Sort out by several if's which message we received and delegates the reuqest for answer to the according class/function.
-* 
+* @brief Handler functions of the message dispatch table
+* Every handler gets the channel module which was resolved by the rule in the table line, 
+* or 0 if the message is handled without a channel module (MSG_CNL::NONE).
 */
-void AS::process_message(void) {
-
-	uint8_t rcv_by03 = rcv_msg.mBody.MSG_TYP;												// define some shorthands
-	uint8_t rcv_by10 = rcv_msg.mBody.BY10;
-	uint8_t rcv_by11 = rcv_msg.mBody.BY11;
-	CM_MASTER *pCM;
-
-	if         (rcv_by03 == BY03(MSG_TYPE::DEVICE_INFO)) {
-		/* not sure what to do with while received, probably nothing */
-
-
-	} else if (rcv_by03 == BY03(MSG_TYPE::CONFIG_REQ)) {
-		/* config request messages are used to configure a devive by writing registers and peers -
-		*  check the channel and forward for processing to the respective function */
-
-		if (rcv_msg.mBody.BY10 >= cnl_max) return;											// channel is out of range, return
-		pCM = cmm[rcv_by10];																// short hand to the respective channel module instance
-
-		/* check if we need to challange the request */
-		switch (rcv_by11) {
-			case BY11(MSG_TYPE::CONFIG_PEER_ADD):
-			case BY11(MSG_TYPE::CONFIG_PEER_REMOVE):
-			case BY11(MSG_TYPE::CONFIG_START):
-			case BY11(MSG_TYPE::CONFIG_END):
-			case BY11(MSG_TYPE::CONFIG_WRITE_INDEX1):
-			case BY11(MSG_TYPE::CONFIG_WRITE_INDEX2):
-
-				uint8_t *AES = pCM->lstC.ptr_to_val(0x08);
-				if ((AES) && (*AES) && (aes->active != MSG_AES::AES_REPLY_OK)) {			// check if we need AES confirmation
-					send_AES_REQ();															// send a request
-					return;																	// nothing to do any more, wait and see
-				}
-		}
-
-		/* challange done, now we can process the initial request */
-		if      (rcv_by11 == BY11(MSG_TYPE::CONFIG_PEER_ADD))       pCM->CONFIG_PEER_ADD(&rcv_msg.m01xx01); 
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_PEER_REMOVE))    pCM->CONFIG_PEER_REMOVE(&rcv_msg.m01xx02);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_PEER_LIST_REQ))  pCM->CONFIG_PEER_LIST_REQ(&rcv_msg.m01xx03);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_PARAM_REQ))      pCM->CONFIG_PARAM_REQ(&rcv_msg.m01xx04);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_START))          pCM->CONFIG_START(&rcv_msg.m01xx05);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_END))            pCM->CONFIG_END(&rcv_msg.m01xx06);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_WRITE_INDEX1))   pCM->CONFIG_WRITE_INDEX1(&rcv_msg.m01xx07);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_WRITE_INDEX2))   pCM->CONFIG_WRITE_INDEX2(&rcv_msg.m01xx08);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_SERIAL_REQ))     pCM->CONFIG_SERIAL_REQ(&rcv_msg.m01xx09);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_PAIR_SERIAL))    pCM->CONFIG_PAIR_SERIAL(&rcv_msg.m01xx0a);
-		else if (rcv_by11 == BY11(MSG_TYPE::CONFIG_STATUS_REQUEST)) pCM->CONFIG_STATUS_REQUEST(&rcv_msg.m01xx0e);
-
-
-	} else if (rcv_by03 == BY03(MSG_TYPE::ACK_MSG)) {
-
-		if (rcv_by10 == BY10(MSG_TYPE::AES_REQ)) {
-			/* AES request is a speciality in this section, pair or peer is sending this request to challenge the last command we had send,
-			*  we have to use the 6 byte payload and generate a SEND_AES type message (* 0x02 04 ff 11 * - AES_REQ) */
-			//dbg << "AES_REQ, ind: " << _HEX(rcv_msg.buf[17]) << ", data: " << _HEX(rcv_msg.buf+11, 6) << '\n';
-
-			aes->prep_AES_REPLY(dev_ident.HMKEY, dev_ident.HMKEY_INDEX, rcv_msg.buf + 11, snd_msg.buf);// prepare the reply
-			snd_msg.clear();																// clear send message
-			send_AES_REPLY(aes->prev_buf);													// and send it
-
-		} else if (rcv_msg.mBody.MSG_CNT == snd_msg.mBody.MSG_CNT) {
-			/* at the moment we need the ACK message only for avoiding resends, so let the send_msg struct know about
-			*  a received ACK/NACK whatever - probably we have to change this function in the future */
-
-			snd_msg.retr_cnt = 0xff;														// check if the message counter is similar and let the send function know
-		}
-
+static void msg_config_peer_add(CM_MASTER *pCM)       { pCM->CONFIG_PEER_ADD(&rcv_msg.m01xx01); }
+static void msg_config_peer_remove(CM_MASTER *pCM)    { pCM->CONFIG_PEER_REMOVE(&rcv_msg.m01xx02); }
+static void msg_config_peer_list_req(CM_MASTER *pCM)  { pCM->CONFIG_PEER_LIST_REQ(&rcv_msg.m01xx03); }
+static void msg_config_param_req(CM_MASTER *pCM)      { pCM->CONFIG_PARAM_REQ(&rcv_msg.m01xx04); }
+static void msg_config_start(CM_MASTER *pCM)          { pCM->CONFIG_START(&rcv_msg.m01xx05); }
+static void msg_config_end(CM_MASTER *pCM)            { pCM->CONFIG_END(&rcv_msg.m01xx06); }
+static void msg_config_write_index1(CM_MASTER *pCM)   { pCM->CONFIG_WRITE_INDEX1(&rcv_msg.m01xx07); }
+static void msg_config_write_index2(CM_MASTER *pCM)   { pCM->CONFIG_WRITE_INDEX2(&rcv_msg.m01xx08); }
+static void msg_config_serial_req(CM_MASTER *pCM)     { pCM->CONFIG_SERIAL_REQ(&rcv_msg.m01xx09); }
+static void msg_config_pair_serial(CM_MASTER *pCM)    { pCM->CONFIG_PAIR_SERIAL(&rcv_msg.m01xx0a); }
+static void msg_config_status_request(CM_MASTER *pCM) { pCM->CONFIG_STATUS_REQUEST(&rcv_msg.m01xx0e); }
+
+static void msg_aes_req(CM_MASTER *) {
+	/* AES request is a speciality in the ACK section, pair or peer is sending this request to challenge the last command we had send,
+	*  we have to use the 6 byte payload and generate a SEND_AES type message (* 0x02 04 ff 11 * - AES_REQ) */
+	aes->prep_AES_REPLY(dev_ident.HMKEY, dev_ident.HMKEY_INDEX, rcv_msg.buf + 11, snd_msg.buf);// prepare the reply
+	snd_msg.clear();																		// clear send message
+	hm.send_AES_REPLY(aes->prev_buf);														// and send it
+}
 
-	} else if (rcv_by03 == BY03(MSG_TYPE::AES_REPLY)) {
-		/* we received an AES_REPLY, first we tell the send function that we received an answer. as the receive flag is not cleared, we will come back again */
-		if (snd_msg.active) {
-			snd_msg.retr_cnt = 0xff;														// we received an answer to our request, no need to resend
-			return;
-		}
-		aes->check_AES_REPLY(dev_ident.HMKEY, rcv_msg.buf);									// check the data, if ok, the last message will be restored, otherwise the hasdata flag will be 0
-		return;																				// next round to work on the restored message
+static void msg_ack(CM_MASTER *) {
+	/* at the moment we need the ACK message only for avoiding resends, so let the send_msg struct know about
+	*  a received ACK/NACK whatever - probably we have to change this function in the future */
+	if (rcv_msg.mBody.MSG_CNT == snd_msg.mBody.MSG_CNT) snd_msg.retr_cnt = 0xff;			// check if the message counter is similar and let the send function know
+}
 
+static void msg_aes_reply(CM_MASTER *) {
+	/* we received an AES_REPLY, first we tell the send function that we received an answer. as the receive flag is not cleared, we will come back again */
+	if (snd_msg.active) {
+		snd_msg.retr_cnt = 0xff;															// we received an answer to our request, no need to resend
+		return;
+	}
+	aes->check_AES_REPLY(dev_ident.HMKEY, rcv_msg.buf);										// check the data, if ok, the last message will be restored, otherwise the hasdata flag will be 0
+}
 
-	} else if (rcv_by03 == BY03(MSG_TYPE::SEND_AES)) {
-		/* pair starts an key exchange, first message shows our key starting with byte 12 and the keyindex in byte 11 (-2) 
-		*  second message holds the new key starting with byte 12 and the new keyindex in byte 11 (again -2) */
-		pCM = cmm[0];
+static void msg_send_aes(CM_MASTER *) {
+	/* pair starts an key exchange, first message shows our key starting with byte 12 and the keyindex in byte 11 (-2) 
+	*  second message holds the new key starting with byte 12 and the new keyindex in byte 11 (again -2) 
+	*  check the message in the aes_key struct, returns are 0 for doesnt fit, 1 key exchange started, 2 new key received */
+	uint8_t new_key = aes->check_SEND_AES_TO_ACTOR(dev_ident.HMKEY, dev_ident.HMKEY_INDEX, rcv_msg.buf);
+	if (new_key) {
+		memcpy(dev_ident.HMKEY, aes->new_hmkey, 16);										// store the new key
+		dev_ident.HMKEY_INDEX[0] = aes->new_hmkey_index[0];
+		set_eeprom(0, sizeof(dev_ident), ((uint8_t*)&dev_ident));							// write it to the eeprom
+		ee_check.update(EE_BLOCK_IDENT);
+	}
+	hm.send_ACK();																			// send ACK
+}
 
-		/* challange the message */
-		if ((*pCM->lstC.ptr_to_val(0x08)) && (aes->active != MSG_AES::AES_REPLY_OK)) {		// check if we need AES confirmation
-			send_AES_REQ();																	// send a request
-			return;																			// nothing to do any more, wait and see
-		}
+static void msg_instruction_reset(CM_MASTER *)                 { hm.INSTRUCTION_RESET(&rcv_msg.m1104xx); }
+static void msg_instruction_enter_bootloader(CM_MASTER *)      { hm.INSTRUCTION_ENTER_BOOTLOADER(&rcv_msg.m1183xx); }
+static void msg_instruction_adaption_drive_set(CM_MASTER *)    { hm.INSTRUCTION_ADAPTION_DRIVE_SET(&rcv_msg.m1187xx); }
+static void msg_instruction_enter_bootloader2(CM_MASTER *)     { hm.INSTRUCTION_ENTER_BOOTLOADER2(&rcv_msg.m11caxx); }
+static void msg_instruction(CM_MASTER *pCM)                    { cm_call_instruction(pCM->lstC.cnl, (MSG_TYPE::E)rcv_msg.mBody.BY10, rcv_msg.buf); }
+static void msg_peer_action(CM_MASTER *pCM)                    { cm_call_peer_action(pCM->lstC.cnl, (MSG_TYPE::E)rcv_msg.mBody.MSG_TYP, rcv_msg.buf); }
 
-		/* check the message in the aes_key struct, returns are 0 for doesnt fit, 1 key exchange started, 2 new key received */
-		uint8_t new_key = aes->check_SEND_AES_TO_ACTOR(dev_ident.HMKEY, dev_ident.HMKEY_INDEX, rcv_msg.buf);
-		if (new_key) {
-			//dbg << "new idx " << aes->new_hmkey_index[0] << ", new key " << _HEX(aes->new_hmkey, 16) << '\n';
-			memcpy(dev_ident.HMKEY, aes->new_hmkey, 16);										// store the new key
-			dev_ident.HMKEY_INDEX[0] = aes->new_hmkey_index[0];
-			set_eeprom(0, sizeof(dev_ident), ((uint8_t*)&dev_ident));						// write it to the eeprom
-		}
-		send_ACK();																			// send ACK
+/*
+* @brief Message dispatch table, one line per known message. The table is sorted by by03 and within by03 the specific 
+* sub types are listed before the wildcard line (by1x 0xff) of the respective message type. A message is identified
+* by by03 and, depending on key, the sub type in byte 10 or 11. The channel module is resolved by the cnl rule and,
+* if aes is set, the message gets challenged before the handler is called.
+* The last line is the catch all of peer messages, a message with peer intent which is not listed above goes to the
+* channel module of the peer, get_dispatch() takes it if the search fails.
+*/
+#define MSG_DISPATCH(TYPE, KEY, CNL, AES, KEEP, HANDLER)  { BY03(TYPE), (KEY == MSG_KEY::BY10) ? BY10(TYPE) : (KEY == MSG_KEY::BY11) ? BY11(TYPE) : 0xff, KEY, CNL, AES, KEEP, HANDLER }
+
+constexpr s_msg_dispatch msg_dispatch[] PROGMEM = {
+	/*           message type                             key            channel rule     aes keep handler */
+	MSG_DISPATCH(MSG_TYPE::DEVICE_INFO,                    MSG_KEY::BY03, MSG_CNL::NONE,   0,  0,   0),			// not sure what to do with while received, probably nothing
+
+	MSG_DISPATCH(MSG_TYPE::CONFIG_PEER_ADD,                MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_peer_add),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_PEER_REMOVE,             MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_peer_remove),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_PEER_LIST_REQ,           MSG_KEY::BY11, MSG_CNL::BY10,   0,  0,   msg_config_peer_list_req),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_PARAM_REQ,               MSG_KEY::BY11, MSG_CNL::BY10,   0,  0,   msg_config_param_req),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_START,                   MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_start),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_END,                     MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_end),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_WRITE_INDEX1,            MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_write_index1),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_WRITE_INDEX2,            MSG_KEY::BY11, MSG_CNL::BY10,   1,  0,   msg_config_write_index2),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_SERIAL_REQ,              MSG_KEY::BY11, MSG_CNL::BY10,   0,  0,   msg_config_serial_req),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_PAIR_SERIAL,             MSG_KEY::BY11, MSG_CNL::BY10,   0,  0,   msg_config_pair_serial),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_STATUS_REQUEST,          MSG_KEY::BY11, MSG_CNL::BY10,   0,  0,   msg_config_status_request),
+	MSG_DISPATCH(MSG_TYPE::CONFIG_REQ,                     MSG_KEY::BY11, MSG_CNL::NONE,   0,  0,   0),			// unhandled config sub types
+
+	MSG_DISPATCH(MSG_TYPE::AES_REQ,                        MSG_KEY::BY10, MSG_CNL::NONE,   0,  0,   msg_aes_req),
+	MSG_DISPATCH(MSG_TYPE::ACK_MSG,                        MSG_KEY::BY10, MSG_CNL::NONE,   0,  0,   msg_ack),	// all other ACK/NACK types
+
+	MSG_DISPATCH(MSG_TYPE::AES_REPLY,                      MSG_KEY::BY03, MSG_CNL::NONE,   0,  1,   msg_aes_reply),	// next round to work on the restored message
+	MSG_DISPATCH(MSG_TYPE::SEND_AES,                       MSG_KEY::BY03, MSG_CNL::DEVICE, 1,  0,   msg_send_aes),
+	MSG_DISPATCH(MSG_TYPE::REPLY_MSG,                      MSG_KEY::BY03, MSG_CNL::NONE,   0,  0,   0),
+
+	MSG_DISPATCH(MSG_TYPE::INSTRUCTION_RESET,              MSG_KEY::BY10, MSG_CNL::BY11,   1,  0,   msg_instruction_reset),
+	MSG_DISPATCH(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER,   MSG_KEY::BY10, MSG_CNL::BY11,   1,  0,   msg_instruction_enter_bootloader),
+	MSG_DISPATCH(MSG_TYPE::INSTRUCTION_ADAPTION_DRIVE_SET, MSG_KEY::BY10, MSG_CNL::BY11,   1,  0,   msg_instruction_adaption_drive_set),
+	MSG_DISPATCH(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER2,  MSG_KEY::BY10, MSG_CNL::BY11,   1,  0,   msg_instruction_enter_bootloader2),
+	MSG_DISPATCH(MSG_TYPE::INSTRUCTION_MSG,                MSG_KEY::BY10, MSG_CNL::BY11,   1,  0,   msg_instruction),	// everything else is forwarded to the channel module
+
+	MSG_DISPATCH(MSG_TYPE::HAVE_DATA,                      MSG_KEY::BY03, MSG_CNL::NONE,   0,  0,   0),
+
+	MSG_DISPATCH(MSG_TYPE::SWITCH,                         MSG_KEY::BY03, MSG_CNL::PEER,   1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::TIMESTAMP,                      MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::REMOTE,                         MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::SENSOR_EVENT,                   MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::SWITCH_LEVEL,                   MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::SENSOR_DATA,                    MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::GAS_EVENT,                      MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::CLIMATE_EVENT,                  MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::SET_TEAM_TEMP,                  MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::THERMAL_CONTROL,                MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::POWER_EVENT_CYCLE,              MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::POWER_EVENT,                    MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+	MSG_DISPATCH(MSG_TYPE::WEATHER_EVENT,                  MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action),
+
+	{ 0xff, 0xff,                                          MSG_KEY::BY03, MSG_CNL::INTENT, 1,  0,   msg_peer_action },	// all other peer messages
+};
+#define MSG_DISPATCH_CNT  (sizeof(msg_dispatch) / sizeof(s_msg_dispatch))
+#define MSG_DISPATCH_PEER (MSG_DISPATCH_CNT - 1)
+static_assert(msg_dispatch[MSG_DISPATCH_PEER].by03 == 0xff, "msg_dispatch table needs the peer catch all as last line");
+
+/* the search in get_dispatch relies on the sort order of the table */
+constexpr uint8_t msg_dispatch_sorted_c(const s_msg_dispatch *tbl, uint8_t cnt) {
+	return (cnt < 2) ? 1 : (tbl[0].by03 <= tbl[1].by03) && msg_dispatch_sorted_c(tbl + 1, cnt - 1);
+}
+static_assert(msg_dispatch_sorted_c(msg_dispatch, MSG_DISPATCH_CNT), "msg_dispatch table is not sorted by by03");
 
+/*
+* @brief Search the dispatch table for the received message
+* Only the by03 byte is read from PROGMEM while stepping through the table, the complete line is copied on a 
+* by03 match only. As the table is sorted, the search stops on the first line with a higher by03.
+* A message with peer intent which is not listed gets the catch all line.
+* Returns 1 and the line in *line if the message is known, otherwise 0.
+*/
+uint8_t s_rcv_msg::get_dispatch(s_msg_dispatch *line) {
+	for (uint8_t i = 0; i < MSG_DISPATCH_PEER; i++) {										// the catch all line is not searched
+		uint8_t by03 = pgm_read_byte(&msg_dispatch[i].by03);								// get the message type of the line
+		if (by03 < mBody.MSG_TYP) continue;													// not there yet
+		if (by03 > mBody.MSG_TYP) break;													// sorted table, no match possible any more
+
+		memcpy_P(line, &msg_dispatch[i], sizeof(s_msg_dispatch));							// message type fits, get the line
+		if (line->by1x == 0xff) return 1;													// wildcard line of the message type
+		if (line->by1x == ((line->key == MSG_KEY::BY10) ? mBody.BY10 : mBody.BY11)) return 1;// sub type fits
+	}
+	if (intend != MSG_INTENT::PEER) return 0;
+	memcpy_P(line, &msg_dispatch[MSG_DISPATCH_PEER], sizeof(s_msg_dispatch));				// peer message which is not listed
+	return 1;
+}
 
-	} else if (rcv_by03 == BY03(MSG_TYPE::REPLY_MSG)) {
+/*
+* @brief Receive handler: Process received messages
+* Process message is called while rcv_msg.hasdata is set to TRUE. It takes all information from the rcv_msg struct.
+* The message is looked up in the msg_dispatch table, which delivers the rule to find the respective channel module,
+* if the message has to be challenged and the function to forward the request to.
+*/
+void AS::process_message(void) {
+	PRF_SCOPE(s_prf::msg_stage(rcv_msg.mBody.MSG_TYP));
+	NRG_SCOPE(NRG_CTX::RCV + s_nrg::msg_group(rcv_msg.mBody.MSG_TYP));
+	s_msg_dispatch line;																	// line of the dispatch table
+	CM_MASTER *pCM = NULL;																	// short hand to the respective channel module
+	uint8_t cnl = 0;
 
+	if (!rcv_msg.get_dispatch(&line)) {
+		DBG(AS, F("AS:message not known - please report: "), _HEX(rcv_msg.buf, rcv_msg.buf[0] + 1), '\n');
+		goto clear_process_message;
+	}
 
-	} else if (rcv_by03 == BY03(MSG_TYPE::INSTRUCTION_MSG)) {
+	/* find the channel module by the rule of the table line */
+	if (line.cnl == MSG_CNL::BY10) {
+		cnl = rcv_msg.mBody.BY10;															// config requests have the channel in byte 10
 
+	} else if (line.cnl == MSG_CNL::BY11) {
 		/* some of instruction message are device related, identification is done by the message length */
-		uint8_t mlen = rcv_msg.mBody.MSG_LEN;												// short hand to the message length
-		if (mlen == 0x0a) pCM = cmm[0];														// some messages are channel independent, identification by length
-		else pCM = cmm[rcv_by11];															// short hand to respective channel module instance
-
-		/* check if we need to challange the request */
-		if ((*pCM->lstC.ptr_to_val(0x08)) && (aes->active != MSG_AES::AES_REPLY_OK)) {		// check if we need AES confirmation
-			send_AES_REQ();																	// send a request
-			return;																			// nothing to do any more, wait and see
-		}
+		if (rcv_msg.mBody.MSG_LEN != 0x0a) cnl = rcv_msg.mBody.BY11;
 
-		/* there are four messages in this category without a channel value, this will be handled in the main module 
-		*  INSTRUCTION_RESET, INSTRUCTION_ENTER_BOOTLOADER, INSTRUCTION_ENTER_BOOTLOADER2, INSTRUCTION_ADAPTION_DRIVE_SET 
-		*  everything else is forwarded to the channel module */
-		if      (rcv_by10 == BY10(MSG_TYPE::INSTRUCTION_RESET))              INSTRUCTION_RESET(&rcv_msg.m1104xx);
-		else if (rcv_by10 == BY10(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER))   INSTRUCTION_ENTER_BOOTLOADER(&rcv_msg.m1183xx);
-		else if (rcv_by10 == BY10(MSG_TYPE::INSTRUCTION_ADAPTION_DRIVE_SET)) INSTRUCTION_ADAPTION_DRIVE_SET(&rcv_msg.m1187xx);
-		else if (rcv_by10 == BY10(MSG_TYPE::INSTRUCTION_ENTER_BOOTLOADER2))  INSTRUCTION_ENTER_BOOTLOADER2(&rcv_msg.m11caxx);
-		else pCM->instruction_msg(rcv_by10, rcv_msg.buf);
-
-
-	} else if (rcv_by03 == BY03(MSG_TYPE::HAVE_DATA)) {
-
-
-	} else if (rcv_by03 == BY03(MSG_TYPE::SWITCH)) {
-		/* to process this message we need to get check if the peer in the payload exist and 
+	} else if (line.cnl == MSG_CNL::PEER) {
+		/* to process this message we need to check if the peer in the payload exist and 
 		*  need also to find the right channel to issue the message, depending on the peer address */
-
 		memcpy(rcv_msg.peer, rcv_msg.m3Exxxx.PEER, 3);										// prepare a peer string
 		rcv_msg.peer[3] = rcv_msg.m3Exxxx.P_CNL;
 		rcv_msg.cnl = is_peer_valid(rcv_msg.peer);											// search for the peer channel
-		if (!rcv_msg.cnl) return;															// peer not found in any channel, return
-		pCM = cmm[rcv_msg.cnl];																// short hand to the respective channel module
-
-		/* check if we need to challange the request */
-		if ((*pCM->lstC.ptr_to_val(0x08)) && (aes->active != MSG_AES::AES_REPLY_OK)) {		// check if we need AES confirmation
-			send_AES_REQ();																	// send a request
-			return;																			// nothing to do any more, wait and see
-		}
-
-		/* forward to the respective channel function */
-		pCM->peer_action_msg(MSG_TYPE::SWITCH, rcv_msg.buf);
+		if (!rcv_msg.cnl) goto clear_process_message;										// peer not found in any channel
+		cnl = rcv_msg.cnl;
 
+	} else if (line.cnl == MSG_CNL::INTENT) {
+		/* it is a peer message, which was checked in get_intend, we remembered on the channel by checking validity of peer */
+		if (rcv_msg.intend != MSG_INTENT::PEER) goto clear_process_message;
+		cnl = rcv_msg.cnl;
+	}
 
-	} else if (rcv_msg.intend == MSG_INTENT::PEER) {
-		/* it is a peer message, which was checked in the receive class, so check if we need to challange
-		*  and forward the message into the respective channel module */
-		pCM = cmm[rcv_msg.cnl];																// we remembered on the channel by checking validity of peer
+	if (line.cnl != MSG_CNL::NONE) {
+		if (cnl >= cnl_max) goto clear_process_message;										// channel is out of range
+		pCM = cmm[cnl];																		// short hand to the respective channel module instance
+	}
 
-		/* check if we need to challange the request */
-		if ((*pCM->lstC.ptr_to_val(0x08)) && (aes->active != MSG_AES::AES_REPLY_OK)) {		// check if we need AES confirmation
+	/* check if we need to challange the request */
+	if (line.aes) {
+		uint8_t *AES = pCM->lstC.ptr_to_val(0x08);
+		if ((AES) && (*AES) && (aes->active != MSG_AES::AES_REPLY_OK)) {					// check if we need AES confirmation
 			send_AES_REQ();																	// send a request
 			return;																			// nothing to do any more, wait and see
 		}
-
-		/* forward to the respective channel function */
-		pCM->peer_action_msg(rcv_by03, rcv_msg.buf);
-
-
-	} else {
-		DBG(AS, F("AS:message not known - please report: "), _HEX(rcv_msg.buf, rcv_msg.buf[0] + 1), '\n');
-
 	}
 
+	/* challange done, now we can process the initial request */
+	if (line.handler) line.handler(pCM);
+	if (pCM) sched.set_cnl(cnl);															// the channel module gets a poll to work on the message
+	if (line.keep) return;																	// handler works further on the receive buffer
+
+clear_process_message:
 	rcv_msg.clear();
+}
+
+#ifdef AS_BENCH
+/* get_intend and process_message are inline, bench/bench.cpp can reach them only through these two */
+void AS::bench_get_intend(void) {
+	get_intend();
+}
 
+void AS::bench_process_message(void) {
+	process_message();
 }
+#endif
 
 
 void AS::INSTRUCTION_RESET(s_m1104xx *buf) {
@@ -521,7 +778,7 @@ void AS::snd_poll(void) {
 		* are initial send or as an answer to a received message. all necassary information are in the send struct */
 		if (isEqual(sm->mBody.RCV_ID, dev_ident.HMID, 3)) {
 			memcpy(rcv_msg.buf, sm->buf, sm->buf[0] + 1);									// copy send buffer to received buffer
-			DBG(SN, F("<i ...\n"));															// some debug, message is shown in the received string
+			TRC(SN, TRC_ID::SND_INTERN, 0, 0, 0, F("<i ...\n"));							// some debug, message is shown in the received string
 			rcv_poll();																		// get intent and so on...
 			sm->clear();																	// nothing to do any more for send, msg will processed in the receive loop
 			return;																			// and return...
@@ -541,7 +798,7 @@ void AS::snd_poll(void) {
 	/* check the retr count if there is something to send, while message timer was checked earlier */
 	if (sm->retr_cnt < sm->temp_max_retr) {													// not all sends done and timing is OK
 		uint8_t tBurst = sm->mBody.FLAG.BURST;												// get burst flag, while string will get encoded
-		com->snd_data(sm->buf, tBurst);														// send to communication module
+		NRG(NRG_CTX::SND + s_nrg::msg_group(sm->mBody.MSG_TYP), PRF(PRF_STAGE::SND_DATA, com->snd_data(sm->buf, tBurst)));// send to communication module
 		sm->retr_cnt++;																		// remember that we had send the message
 
 		if (sm->mBody.FLAG.BIDI) {															// is an ACK requested?
@@ -550,7 +807,7 @@ void AS::snd_poll(void) {
 		}
 		led.set(LED_STAT::SEND_MSG);														// fire the status led
 
-		DBG(SN, F("<- "), _HEX(sm->buf, sm->buf[0] + 1), ' ', _TIME, '\n');					// some debug
+		TRC(SN, TRC_ID::SND_MSG, 0, sm->buf, sm->buf[0] + 1, F("<- "), _HEX(sm->buf, sm->buf[0] + 1), ' ', _TIME, '\n');// some debug
 
 	} else {
 	/* if we are here, message was send one or multiple times and the timeout was raised if an ack where required */
@@ -563,7 +820,7 @@ void AS::snd_poll(void) {
 		led.set(LED_STAT::GOT_NACK);														// fire the status led
 		pom.stayAwake(100);																// and stay awake for a short while
 
-		DBG(SN, F("  timed out "), _TIME, '\n');											// some debug
+		TRC(SN, TRC_ID::SND_TIMEOUT, 0, 0, 0, F("  timed out "), _TIME, '\n');				// some debug
 	}
 }
 
@@ -1036,8 +1293,10 @@ void AS::send_WEATHER_EVENT(uint8_t bidi, CM_MASTER *channel_module, uint8_t *pt
 *        the channel number where the peer was found. Returns 0 if nothing was found.
 */
 uint8_t AS::is_peer_valid(uint8_t *peer) {
+	uint8_t dev = peer_dev.get_idx(peer);													// the HMID is searched only once in the shared device table
+	if (dev == 0xff) return 0;																// unknown device
 	for (uint8_t i = 0; i < cnl_max; i++) {													// step through all channels
-		if (cmm[i]->peerDB.get_idx(peer) != 0xff) return i;									// ask the peer table to find the peer, if found, return the cnl
+		if (cmm[i]->peerDB.get_idx(dev, peer[3]) != 0xff) return i;							// ask the peer table to find the peer, if found, return the cnl
 	}
 	return 0;																				// nothing was found, return 0
 }
@@ -12,7 +12,7 @@
 #ifndef _AS_MAIN_H
 #define _AS_MAIN_H
 
-#include "as_type_defs.h"
+#include "AS_type_defs.h"
 #include "cm_master.h"
 
 /**
@@ -36,6 +36,7 @@ public:  //---------------------------------------------------------------------
 	AS(void);																				// constructor
 	void init(void);																		// init function for the library
 	void poll(void);
+	inline void poll_due(uint8_t rcv);														// work of the main class, only if something is due
 
 
 
@@ -48,6 +49,11 @@ public:  //---------------------------------------------------------------------
 	inline void get_intend(void);															// checks the received string if addresses are known
 	inline void process_message(void);														// herein we sort out the message and forward to the respective functions
 
+#ifdef AS_BENCH
+	void bench_get_intend(void);															// the inline receive functions for bench/bench.cpp
+	void bench_process_message(void);
+#endif
+
 	inline void INSTRUCTION_RESET(s_m1104xx *buf);
 	inline void INSTRUCTION_ENTER_BOOTLOADER(s_m1183xx *buf);
 	inline void INSTRUCTION_ADAPTION_DRIVE_SET(s_m1187xx *buf);
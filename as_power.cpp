@@ -14,129 +14,103 @@
 * @brief Initialize the power module
 */
 POM::POM(uint8_t mode) {
+	setMode(mode);
 }
 
 /**
-* @brief Stay awake for specific time
+* @brief Set the power mode
+* @param mode POWER_MODE_NO_SLEEP, POWER_MODE_WAKEUP_ONBURST, POWER_MODE_WAKEUP_ONTIMER or POWER_MODE_WAKEUP_ONEXTINT
+*/
+void POM::setMode(uint8_t mode) {
+	this->mode = (mode < POWER_MODE_CNT) ? mode : POWER_MODE_NO_SLEEP;
+	burst = 0;
+	if (this->mode == POWER_MODE_NO_SLEEP) timer.set(0);									// poll() doesn't consume the timer in this mode
+}
+
+/**
+* @brief Stay awake for specific time, nothing to do while the device doesn't sleep
 * @param time in milliseconds for stay awake
 */
 void POM::stayAwake(uint16_t time) {
+	if (mode == POWER_MODE_NO_SLEEP) return;												// an armed timer would keep the scheduler due
 	if (time < timer.remain()) return;														// set new timeout only if we have to add something
 	timer.set(time);
 }
 
 /**
-* @brief Check against active flag of various modules
+* @brief Clear the sleep statistics
 */
-void POM::poll(void) {
-	timer.done();
-
-	/* poll through the timer array to identify if all timers are completed or how far the next wake up time is
-	*  timer completion means, a timer was checked with the done() function and checktime was reseted to 0, so the underlaying action was progressed */
-/*	uint32_t next_wakeup = 0;
-	uint8_t timer_active = 0;
-
-	for (uint8_t i = 0; i < timer_max; i++) {
-		uint8_t temp_status = timer_array[i]->completed();
-		//dbg << i << ':' << temp_status << ", ";
-		if (temp_status == 0) continue;														// timer not set, nothing to do
-
-		if (temp_status == 1) {																// timer active and needs to be processed by calling done() function
-			timer_active = temp_status;
-
-		}
-		else {																			// timer active and some remaining time
-			uint32_t temp_time = timer_array[i]->remain();									// get the remaining time
-			if ((!next_wakeup) || (next_wakeup > temp_time)) next_wakeup = temp_time;		// remind the remaining time if it is the next one
-
-		}
-	}*/
-
-	//dbg << timer_active << ", " << next_wakeup << '\n';
-
-
-
-	//	if (pwrMode == POWER_MODE_NO_SLEEP) return;												// no power savings, there for we can exit
-	//	if (!timer.done()) return;																// timer active, jump out
-	//if (checkWakeupPin()) return;															// wakeup pin active
-
-	// some communication still active, jump out
-	//	if ((snd_msg.active) || (list_msg.active) || (config_mode.active) || (pair_mode.active) || (cbn->button_check.armed)) return;
-
-	//	#ifdef PW_DBG																			// only if pw debug is set
-	//		dbg << '.';																			// ...and some information
-	// uint32_t fTme = getMillis();
-	//	#endif
-
-
-	//	if (pwrMode == POWER_MODE_WAKEUP_ONRADIO) {												// check communication on power mode 1
-
-	//		tmpCCBurst = com->detect_burst();
-	//		if ((tmpCCBurst) && (!chkCCBurst)) {												// burst detected for the first time
-	//			chkCCBurst = 1;																	// set the flag
-
-	//			#ifdef PW_DBG																	// only if pw debug is set
-	//				dbg << '1';																	// ...and some information
-	//			#endif
-
-	//		} else if ((tmpCCBurst) && (chkCCBurst)) {											// burst detected for the second time
-	//			chkCCBurst = 0;																	// reset the flag
-	//			stayAwake(500);																	// stay awake for some time to check if we receive a valid message
-
-	//			#ifdef PW_DBG																	// only if pw debug is set
-	//				dbg << '2';																	// ...and some information
-	//			#endif
-
-	//			return;																			// we don't want proceed further, jump out
-
-	//		} else if ((!tmpCCBurst) && (chkCCBurst)) {											// secondary test was negative, reset the flag
-	//			chkCCBurst = 0;																	// reset the flag
-
-	//			#ifdef PW_DBG																	// only if pw debug is set
-	//				dbg << '-';																	// ...and some information
-	//			#endif			
-	//		}
-	//	}
-
-	//	// if we are here, we could go sleep. set cc module idle, switch off led's and sleep
-	//	com->set_idle();																		// set communication module to idle
-	//	led->set(LED_STAT::NONE);																// switch off all led's
+void POM::clear_stat(void) {
+	memset(stat, 0, sizeof(stat));
+}
 
-	// start the respective watchdog timers
-	//	cli();
-	//	if      ((pwrMode == POWER_MODE_WAKEUP_ONRADIO) && (!chkCCBurst)) startWDG250ms();
-	//	else if ((pwrMode == POWER_MODE_WAKEUP_ONRADIO) && (chkCCBurst))  startWDG32ms();
-	//	else if  (pwrMode == POWER_MODE_WAKEUP_32MS)                      startWDG32ms();
-	//	else if  (pwrMode == POWER_MODE_WAKEUP_64MS)                      startWDG64ms();
-	//	else if  (pwrMode == POWER_MODE_WAKEUP_250MS)                     startWDG250ms();
-	//	else if  (pwrMode == POWER_MODE_WAKEUP_8000MS)                    startWDG8000ms();
+/**
+* @brief Check if we are allowed to sleep and if so, send the device to sleep. 
+* The sleep time is the longest possible watchdog period within the time the scheduler reports, the millis timer
+* gets the slept time added by the watchdog interrupt. A wake up by another interrupt, e.g. a pin change, stops the
+* watchdog and the part of the period which was slept is lost for the millis timer, the statistic counts only the
+* time the interrupt has added.
+*/
+void POM::poll(void) {
+	if (mode == POWER_MODE_NO_SLEEP) return;												// no power savings, there for we can exit
+	if (!timer.done()) return;																// stay awake timer active, jump out
 
-	// todo: move sei() to setSleep() before sleep_cpu();
-	//	sei();
+	uint32_t sleep_ms = get_sleep_time();
+	if (!sleep_ms) return;																	// something is to do, or to short for the watchdog
 
-	//	#if defined(PW_DBG)||defined(SER_DBG)||defined(SN_DBG)||defined(RV_DBG)||defined(EE_DBG)||defined(LD_DBG)||defined(CC_DBG)||defined(AS_DBG)||defined(AES_DBG)||defined(BT_DBG)||defined(TH_DBG)
-	//		Serial.flush();																		// give UART some time to send last chars
-	//	#endif
+	/* if we are here, we could go sleep. set cc module idle and start the respective watchdog timer */
+	com->set_idle();																		// set communication module to idle
+	#ifdef SER_DBG
+	Serial.flush();																			// give UART some time to send last chars
+	#endif
 
-	//	setSleep();																				// call sleep function in HAL
+	if (sleep_ms != WAITTIMER_NONE) startWDGms(sleep_ms);									// no watchdog while sleeping for ever
+	setSleepMode();
+	NRG_MCU(NRG_STATE::SLEEP);
+	setSleep();																				// call sleep function in HAL
+	NRG_MCU(NRG_STATE::ACTIVE);
 
 	/*************************
 	* Wake up at this point *
 	*************************/
-	//	if (pwrMode != POWER_MODE_WAKEUP_EXT_INT) {
-	//		stopWDG();																			// stop the watchdog
-	//	}
+	stopWDG();																				// stop the watchdog, the slept time was added by the interrupt
+	stat[mode].cnt++;
+	stat[mode].time += getWDGms();
+
+	/* in burst mode the radio is checked after every wake up, first detection needs a confirmation after a short while */
+	if (mode == POWER_MODE_WAKEUP_ONBURST) {
+		if (!com->detect_burst()) burst = 0;												// nothing in the air, continue sleeping
+		else if (!burst) burst = 1;															// burst detected for the first time, check again
+		else {																				// burst confirmed, stay awake to receive the message
+			burst = 0;
+			stayAwake(POWER_BURST_AWAKE);
+			return;
+		}
+		if (burst) return;																	// short sleep for the recheck is done in the next round
+	}
 
-	//	stayAwake(6);																			// stay awake for a very short time to get things done
+	stayAwake(POWER_WAKEUP_AWAKE);															// stay awake for a very short time to get things done
+}
 
-	//	#ifdef PW_DBG																			// only if pw debug is set
-	//		dbg << ':';// << (getMillis() -fTme) << '\n';										// ...and some information
-	//	#endif
+/**
+* @brief Longest time we are allowed to sleep
+* @return 0 if we have to stay awake, WAITTIMER_NONE to sleep until an external interrupt, otherwise ms to sleep
+*/
+uint32_t POM::get_sleep_time(void) {
+	/* some communication still active, the master waits for an answer */
+	if ((config_mode.active) || (pair_mode.active)) return 0;
 
+	snap_millis();																			// the loop took some time, the deadline is calculated on a fresh snapshot
+	uint32_t sleep_ms = sched.sleep_time();													// wake reasons and earliest waittimer
+	if (!sleep_ms) return 0;
 
+	if (mode == POWER_MODE_WAKEUP_ONBURST) {
+		uint16_t check_ms = (burst) ? POWER_BURST_RECHECK : POWER_BURST_CHECK;				// radio needs to be checked regularly
+		if (sleep_ms > check_ms) sleep_ms = check_ms;
 
+	} else if (mode == POWER_MODE_WAKEUP_ONTIMER) {
+		if (sleep_ms == WAITTIMER_NONE) sleep_ms = 8192;									// longest watchdog period, keeps the millis timer running
+	}
 
+	return (sleep_ms < 16) ? 0 : sleep_ms;													// shortest watchdog period is 16ms
 }
-
-
-
@@ -19,17 +19,48 @@
 *                              If signal recognized, wait 50ms and check again - if it is still active
 *                              Then wake up the device for some time.If no signal recognized, continue sleeping
 */
-/* POWER_MODE_WAKEUP_ONTIMER   Sleep as long as no waittimer raised an event
+/* POWER_MODE_WAKEUP_ONTIMER   Sleep as long as no waittimer raised an event, the watchdog wakes up at least every 8s 
+*                              to keep the millis timer running
 */
-/* POWER_MODE_WAKEUP_ONEXTINT  Sleep for ever until an external interrupt was triggered
+/* POWER_MODE_WAKEUP_ONEXTINT  Sleep for ever until an external interrupt was triggered, armed waittimers are still served
+*                              by the watchdog. The millis timer stands still while no waittimer is armed
 */
+#define POWER_MODE_NO_SLEEP         0
+#define POWER_MODE_WAKEUP_ONBURST   1
+#define POWER_MODE_WAKEUP_ONTIMER   2
+#define POWER_MODE_WAKEUP_ONEXTINT  3
+#define POWER_MODE_CNT              4
+
+#define POWER_BURST_CHECK           256														// ms between two burst checks
+#define POWER_BURST_RECHECK         32														// ms till a detected burst is checked again
+#define POWER_BURST_AWAKE           500														// ms to stay awake for receiving after a burst
+#define POWER_WAKEUP_AWAKE          6														// ms to stay awake after a wake up to get things done
+
+/*
+* @brief sleep statistics per power mode
+* cnt   - amount of sleep cycles
+* time  - slept time in ms, as added to the millis timer
+*/
+struct s_pom_stat {
+	uint16_t cnt;
+	uint32_t time;
+};
+
 class POM {
 public:
 	waittimer timer;
+	uint8_t   mode;																			// power mode, see POWER_MODE_*
+	uint8_t   burst;																		// a burst was detected in the previous check, next check confirms it
+	s_pom_stat stat[POWER_MODE_CNT];														// sleep statistics per power mode
 
 	POM(uint8_t mode);
+	void setMode(uint8_t mode);
 	void stayAwake(uint16_t time);
 	void poll(void);
+	void clear_stat(void);
+
+private:
+	uint32_t get_sleep_time(void);
 };
 
 #endif 
@@ -77,6 +77,7 @@ void LED::poll(void) {
 
 	if (cur_pat.line == LED_STAT::NONE) return;												// no active profile
 	if (!timer.done()) return;																// active but timer not done
+	sched.clear(WAKE_REASON::LED);
 
 	/* copy the repective line into memory */
 	s_blink_pattern tbl_line;
@@ -99,6 +100,7 @@ void LED::poll(void) {
 			cur_pat.line = LED_STAT::NONE;
 		}
 		
+		if (cur_pat.line != LED_STAT::NONE) sched.set(WAKE_REASON::LED);					// next round continues without timer
 		return;
 	}
 
@@ -12,7 +12,7 @@
 
 #include "HAL.h"
 #include "waittimer.h"
-#include "as_type_defs.h"
+#include "AS_type_defs.h"
 
 
 /* definition of blink pattern, first byte indicates the length, followed by a sequence of on, off times; values are multiplied by 10ms */
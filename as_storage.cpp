@@ -0,0 +1,550 @@
+/**
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin storage backend class ------------------------------------------------------------------------------------------
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include "newasksin.h"
+
+
+/*-- eeprom functions -----------------------------------------------------------------------------------------------------
+* writes are not done directly, they go into a small write back cache. a cache line holds EE_CACHE_LINE_SIZE bytes of the
+* eeprom and a dirty bit per byte. reads are served from the cache if the line is cached, otherwise from the backend.
+* clear_eeprom registers a clear job which is processed in the background, up to EE_CLEAR_JOBS ranges are queued.
+* reads within a pending clear range are answered with 0. clear jobs are written before the cache lines, so a write into
+* a clear range just goes into the cache line. only a line which is evicted earlier is clipped out of the clear job.
+* write back is done by write_next_eeprom, one byte or one page per call, called by the interrupt engine of the backend
+* or by poll_eeprom. flush_eeprom is the barrier which returns only when everything is written.
+* backends without write latency (page == 0) bypass the cache.
+*/
+#ifndef EE_CACHE_LINES
+#define EE_CACHE_LINES                     4												// amount of cached eeprom lines, each line takes 20 byte sram
+#endif
+#define EE_CACHE_LINE_SIZE                16												// size of a cache line, fix to 16 while dirty flags are a 16 bit mask
+#ifndef EE_CLEAR_JOBS
+#define EE_CLEAR_JOBS                      3												// amount of queued clear ranges, each takes 4 byte sram
+#endif
+
+/* the interrupt engine is stopped while the main loop works on the cache and restored afterwards */
+#define ee_engine_stop()        uint8_t ee_armed = eep->get_irq(); eep->set_irq(0);
+#define ee_engine_restore()     __asm__ __volatile__ ("" ::: "memory"); if (ee_armed) eep->set_irq(1);
+
+struct s_ee_cache_line {
+	uint16_t tag;																			// line number + 1, 0 indicates an unused cache line
+	volatile uint16_t dirty;																// one bit per byte which needs to be written back
+	uint8_t  data[EE_CACHE_LINE_SIZE];														// the cached eeprom content
+};
+static s_ee_cache_line ee_cache[EE_CACHE_LINES];
+static uint8_t ee_cache_victim;																// round robin pointer for the next line to evict
+
+struct s_ee_clear_job {
+	volatile uint16_t addr;																	// next address of the clear job
+	volatile uint16_t len;																	// remaining bytes, 0 indicates an unused job
+};
+static s_ee_clear_job ee_clear[EE_CLEAR_JOBS];
+
+/* search the cache for a specific line, returns a pointer to the line or 0 if not cached */
+static s_ee_cache_line *ee_cache_find(uint16_t tag) {
+	for (uint8_t i = 0; i < EE_CACHE_LINES; i++) {
+		if (ee_cache[i].tag == tag) return &ee_cache[i];
+	}
+	return 0;
+}
+
+/* checks if the given address range overlaps a pending clear job */
+static uint8_t ee_in_clear(uint16_t addr, uint8_t len = 1) {
+	for (uint8_t i = 0; i < EE_CLEAR_JOBS; i++) {
+		s_ee_clear_job *job = &ee_clear[i];
+		if ((job->len) && (addr < job->addr + job->len) && (job->addr < addr + len)) return 1;
+	}
+	return 0;
+}
+
+/* returns the first pending clear job or 0 if there is none */
+static s_ee_clear_job *ee_clear_next(void) {
+	for (uint8_t i = 0; i < EE_CLEAR_JOBS; i++) {
+		if (ee_clear[i].len) return &ee_clear[i];
+	}
+	return 0;
+}
+
+/* limits a write to the page boundary of the backend */
+static uint8_t ee_page_len(uint16_t addr, uint8_t len) {
+	uint8_t room = eep->page - (addr % eep->page);
+	return (len > room) ? room : len;
+}
+
+/* writes the first dirty bytes of a cache line, as much as fits into one page. returns 0 if the line was clean */
+static uint8_t ee_cache_write_chunk(s_ee_cache_line *line) {
+	uint16_t dirty = line->dirty;
+	if (!dirty) return 0;
+
+	uint8_t first = 0;
+	while (!(dirty & (1U << first))) first++;												// search the first dirty byte
+	uint16_t addr = (line->tag - 1) * EE_CACHE_LINE_SIZE;
+	uint8_t len = ee_page_len(addr + first, EE_CACHE_LINE_SIZE - first);
+
+	uint8_t last = first;																	// clean bytes in between are written as well,
+	for (uint8_t i = first; i < first + len; i++) {											// they are equal to the eeprom content
+		if (dirty & (1U << i)) last = i;
+	}
+	for (uint8_t i = first; i <= last; i++) {
+		dirty &= ~(1U << i);
+	}
+
+	eep->write(addr + first, last - first + 1, &line->data[first]);
+	NRG_EE_WRITE();
+	line->dirty = dirty;
+	return 1;
+}
+
+/* writes the next chunk of a clear job, returns 0 if there is no clear job */
+static uint8_t ee_clear_write_chunk(s_ee_clear_job *job) {
+	if ((!job) || (!job->len)) return 0;
+
+	uint8_t zero[EE_CACHE_LINE_SIZE] = {};
+	uint8_t len = ee_page_len(job->addr, (job->len > EE_CACHE_LINE_SIZE) ? EE_CACHE_LINE_SIZE : job->len);
+	eep->write(job->addr, len, zero);
+	NRG_EE_WRITE();
+	job->addr += len;
+	job->len -= len;
+	return 1;
+}
+
+/* finish a clear job in a blocking way, only needed if all clear jobs are in use */
+static void ee_drain_clear(s_ee_clear_job *job) {
+	while (job->len) {
+		if (eep->ready()) ee_clear_write_chunk(job);
+	}
+}
+
+/* returns an unused clear job, if all are in use the first one is finished in a blocking way */
+static s_ee_clear_job *ee_clear_alloc(void) {
+	for (uint8_t i = 0; i < EE_CLEAR_JOBS; i++) {
+		if (!ee_clear[i].len) return &ee_clear[i];
+	}
+	ee_drain_clear(&ee_clear[0]);
+	return &ee_clear[0];
+}
+
+/* takes the range addr till end out of the clear jobs, a job which is split in two needs a second job */
+static void ee_clear_clip(uint16_t addr, uint16_t end) {
+	for (uint8_t i = 0; i < EE_CLEAR_JOBS; i++) {
+		s_ee_clear_job *job = &ee_clear[i];
+		uint16_t job_end = job->addr + job->len;
+		if ((!job->len) || (job_end <= addr) || (end <= job->addr)) continue;
+
+		if ((job->addr < addr) && (end < job_end)) {										// range is in the middle, split the job
+			s_ee_clear_job *tail = ee_clear_alloc();
+			if (!job->len) continue;														// was the one which is finished now
+			tail->addr = end;
+			tail->len = job_end - end;
+			job->len = addr - job->addr;
+		} else if (job->addr < addr) {														// cut the end
+			job->len = addr - job->addr;
+		} else if (end < job_end) {															// cut the start
+			job->len = job_end - end;
+			job->addr = end;
+		} else job->len = 0;																// completely covered
+	}
+}
+
+/* a cache line which is written back while a clear job overlaps it, writes the cleared bytes by its own */
+static void ee_clear_takeover(s_ee_cache_line *line) {
+	if (!line->tag) return;
+	uint16_t line_addr = (line->tag - 1) * EE_CACHE_LINE_SIZE;
+	if (!ee_in_clear(line_addr, EE_CACHE_LINE_SIZE)) return;
+	for (uint8_t i = 0; i < EE_CACHE_LINE_SIZE; i++) {										// cleared bytes are 0 in the line, or new content
+		if (ee_in_clear(line_addr + i)) line->dirty |= (1U << i);
+	}
+	ee_clear_clip(line_addr, line_addr + EE_CACHE_LINE_SIZE);
+}
+
+/* get a cache line for a specific tag, clean lines are preferred, a dirty line will be written back before reuse.
+* if evict is 0, only unused or clean lines are taken and 0 is returned if there is none */
+static s_ee_cache_line *ee_cache_alloc(uint16_t tag, uint8_t evict) {
+	s_ee_cache_line *line = 0;
+	for (uint8_t i = 0; i < EE_CACHE_LINES; i++) {											// search for an unused or clean line
+		if (ee_cache[i].dirty) continue;
+		line = &ee_cache[i];
+		if (!line->tag) break;																// unused line is the best choice
+	}
+	if ((!line) && (!evict)) return 0;
+	if (!line) {																			// all lines are dirty, evict one
+		line = &ee_cache[ee_cache_victim];
+		if (++ee_cache_victim >= EE_CACHE_LINES) ee_cache_victim = 0;
+		ee_clear_takeover(line);															// the clear job must not overwrite it later
+		while (line->dirty) {																// blocking, but only if the cache is full
+			if (eep->ready()) ee_cache_write_chunk(line);
+		}
+	}
+	line->tag = tag;
+	line->dirty = 0;
+
+	uint16_t addr = (tag - 1) * EE_CACHE_LINE_SIZE;
+	while (!eep->ready());																	// serial devices are not accessible while writing
+	eep->read(addr, EE_CACHE_LINE_SIZE, line->data);
+	for (uint8_t i = 0; i < EE_CACHE_LINE_SIZE; i++) {										// bytes which are not cleared yet
+		if (ee_in_clear(addr + i)) line->data[i] = 0;
+	}
+	return line;
+}
+
+/* init the eeprom, done by the storage backend */
+void init_eeprom(void) {
+	eep->init();
+}
+
+/* read a specific eeprom address */
+void get_eeprom(uint16_t addr, uint8_t len, void *ptr) {
+	PRF_SCOPE(PRF_STAGE::EE_GET);
+	if (!eep->page) {																		// no cache needed, read directly
+		eep->read(addr, len, ptr);
+		return;
+	}
+
+	ee_engine_stop();
+	uint8_t *buf = (uint8_t*)ptr;
+	while (len) {
+		uint8_t offset = addr % EE_CACHE_LINE_SIZE;											// position within the cache line
+		uint8_t chunk = EE_CACHE_LINE_SIZE - offset;										// bytes till end of the line
+		if (chunk > len) chunk = len;
+
+		uint16_t tag = addr / EE_CACHE_LINE_SIZE + 1;
+		s_ee_cache_line *line = ee_cache_find(tag);											// check if the line is cached
+		if ((!line) && (eep->page > 1)) line = ee_cache_alloc(tag, 0);						// serial device, read ahead into a free line
+
+		if (line) memcpy(buf, &line->data[offset], chunk);									// take it from the cache
+		else {
+			while (!eep->ready());
+			eep->read(addr, chunk, buf);
+			for (uint8_t i = 0; i < chunk; i++) {											// bytes which are not cleared yet
+				if (ee_in_clear(addr + i)) buf[i] = 0;
+			}
+		}
+
+		addr += chunk; buf += chunk; len -= chunk;
+	}
+	ee_engine_restore();
+}
+
+/* write a block to a specific eeprom address */
+void set_eeprom(uint16_t addr, uint8_t len, void *ptr) {
+	PRF_SCOPE(PRF_STAGE::EE_SET);
+	if (!eep->page) {																		// no write latency, write through
+		eep->write(addr, len, ptr);
+		return;
+	}
+
+	/* content goes into the write back cache, only changed bytes are marked as dirty,
+	* the eeprom itself is written by write_next_eeprom or flush_eeprom */
+	ee_engine_stop();
+	uint8_t *buf = (uint8_t*)ptr;
+	while (len) {
+		uint8_t offset = addr % EE_CACHE_LINE_SIZE;											// position within the cache line
+		uint8_t chunk = EE_CACHE_LINE_SIZE - offset;										// bytes till end of the line
+		if (chunk > len) chunk = len;
+
+		uint16_t tag = addr / EE_CACHE_LINE_SIZE + 1;
+		s_ee_cache_line *line = ee_cache_find(tag);
+		if ((!line) && (ee_in_clear(addr - offset, EE_CACHE_LINE_SIZE))) {					// the eeprom content is not cleared yet,
+			line = ee_cache_alloc(tag, 1);													// but the bytes are 0 in a new line
+		}
+
+		if (!line) {																		// not cached, check if there is a change at all
+			uint8_t curr[EE_CACHE_LINE_SIZE];
+			while (!eep->ready());
+			eep->read(addr, chunk, curr);
+			if (memcmp(curr, buf, chunk)) line = ee_cache_alloc(tag, 1);					// something to change, get a cache line
+		}
+
+		if (line) {
+			for (uint8_t i = 0; i < chunk; i++) {
+				if (line->data[offset + i] == buf[i]) continue;								// no change, nothing to do
+				line->data[offset + i] = buf[i];
+				line->dirty |= (1U << (offset + i));										// remember to write back
+			}
+		}
+
+		addr += chunk; buf += chunk; len -= chunk;
+	}
+	sched.set(WAKE_REASON::EEPROM);															// write back is pending, see AS::poll
+	ee_engine_restore();
+}
+
+/* and clear the eeprom, registers a clear job and returns immediately */
+void clear_eeprom(uint16_t addr, uint16_t len) {
+	if (!len) return;
+
+	if (!eep->page) {																		// no write latency, write through
+		uint8_t zero[EE_CACHE_LINE_SIZE] = {};
+		while (len) {
+			uint8_t chunk = (len > EE_CACHE_LINE_SIZE) ? EE_CACHE_LINE_SIZE : len;
+			eep->write(addr, chunk, zero);
+			addr += chunk; len -= chunk;
+		}
+		return;
+	}
+
+	ee_engine_stop();
+	for (uint8_t i = 0; i < EE_CACHE_LINES; i++) {											// cached lines in the range are cleared as well
+		s_ee_cache_line *line = &ee_cache[i];
+		if (!line->tag) continue;
+		uint16_t line_addr = (line->tag - 1) * EE_CACHE_LINE_SIZE;
+		for (uint8_t j = 0; j < EE_CACHE_LINE_SIZE; j++) {
+			if ((line_addr + j < addr) || (line_addr + j >= addr + len) || (!line->data[j])) continue;
+			line->data[j] = 0;
+			line->dirty |= (1U << j);
+		}
+	}
+
+	uint16_t end = addr + len;
+	for (uint8_t i = 0; i < EE_CLEAR_JOBS; i++) {											// overlapping or adjacent jobs are merged into the new one
+		s_ee_clear_job *job = &ee_clear[i];
+		uint16_t job_end = job->addr + job->len;
+		if ((!job->len) || (end < job->addr) || (addr > job_end)) continue;
+		if (job->addr < addr) addr = job->addr;
+		if (job_end > end) end = job_end;
+		job->len = 0;
+	}
+	s_ee_clear_job *job = ee_clear_alloc();													// blocks only if all jobs are in use
+	job->addr = addr;
+	job->len = end - addr;
+	sched.set(WAKE_REASON::EEPROM);															// write back is pending, see AS::poll
+	ee_engine_restore();
+}
+
+/* writes the next pending chunk, the clear jobs first, then the cache lines which may hold new content of a cleared range.
+* returns 0 if nothing is pending, 1 if a write was started or the backend is still busy */
+uint8_t write_next_eeprom(void) {
+	s_ee_cache_line *line = 0;
+	for (uint8_t i = 0; i < EE_CACHE_LINES; i++) {
+		if (!ee_cache[i].dirty) continue;
+		line = &ee_cache[i];
+		break;
+	}
+	s_ee_clear_job *job = ee_clear_next();
+	if ((!line) && (!job)) return 0;														// nothing to do
+	if (!eep->ready()) return 1;															// backend is still busy with the last write
+
+	if (job) ee_clear_write_chunk(job);
+	else ee_cache_write_chunk(line);
+	return 1;
+}
+
+/* starts the background write back if something is pending, non blocking, returns 1 if there is still something to write */
+uint8_t poll_eeprom(void) {
+	if (!eep->page) return 0;																// write through, nothing is pending
+
+	eep->set_irq(0);
+	uint8_t pending = (ee_clear_next()) ? 1 : 0;
+	for (uint8_t i = 0; i < EE_CACHE_LINES; i++) {
+		if (ee_cache[i].dirty) pending = 1;
+	}
+	if ((pending) && (!eep->set_irq(1))) write_next_eeprom();								// no interrupt engine, one step by polling
+	return pending;
+}
+
+/* barrier, writes back everything which is pending and blocks until the last byte is written */
+void flush_eeprom(void) {
+	if (!eep->page) return;																	// write through, nothing is pending
+
+	eep->set_irq(0);																		// we do it by our own, interrupt engine not needed
+	while (write_next_eeprom());
+	while (!eep->ready());																	// wait till the last byte is in place
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- internal eeprom ------------------------------------------------------------------------------------------------------
+* byte wise write back, driven by the eeprom ready interrupt. raw access functions are defined in HAL_<vendor>.cpp
+*/
+INT_EEP::INT_EEP() {
+	size = int_eeprom_size;
+	page = 1;
+}
+
+void INT_EEP::read(uint16_t addr, uint8_t len, void *ptr) {
+	get_int_eeprom(addr, len, ptr);
+}
+
+void INT_EEP::write(uint16_t addr, uint8_t len, void *ptr) {
+	uint8_t *buf = (uint8_t*)ptr;
+	for (uint8_t i = 0; i < len; i++) {														// len is 1 while page is 1, but be on the safe side
+		while (!is_int_eeprom_ready());
+		set_int_eeprom(addr + i, buf[i]);
+	}
+}
+
+uint8_t INT_EEP::ready(void) {
+	return is_int_eeprom_ready();
+}
+
+uint8_t INT_EEP::set_irq(uint8_t enable) {
+	set_int_eeprom_irq(enable);
+	return 1;
+}
+
+uint8_t INT_EEP::get_irq(void) {
+	return get_int_eeprom_irq();
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- i2c eeprom -----------------------------------------------------------------------------------------------------------
+* 24Cxx series. up to 24C16 the word address is one byte, the upper address bits are part of the device address.
+* bigger devices have a two byte word address. after a page write the device doesn't answer till the write is done,
+* this is used by ready() to detect the end of the write (ack polling).
+*/
+#define I2C_WRITE             0
+#define I2C_READ              1
+
+I2C_EEP::I2C_EEP(uint8_t i2c_addr, uint16_t eeprom_size, uint8_t page_size) {
+	dev_addr = i2c_addr;
+	size = eeprom_size;
+	page = page_size;
+}
+
+void I2C_EEP::init(void) {
+	enable_i2c();
+}
+
+uint8_t I2C_EEP::set_addr(uint16_t addr) {
+	if (size > 2048) {																		// two byte word address
+		if (!i2c_start((dev_addr << 1) | I2C_WRITE)) return 0;
+		i2c_send_byte(addr >> 8);
+	} else {																				// block bits in the device address
+		if (!i2c_start(((dev_addr | ((addr >> 8) & 0x07)) << 1) | I2C_WRITE)) return 0;
+	}
+	i2c_send_byte(addr & 0xff);
+	return 1;
+}
+
+void I2C_EEP::read(uint16_t addr, uint8_t len, void *ptr) {
+	uint8_t *buf = (uint8_t*)ptr;
+	if (!set_addr(addr)) {																	// device not available
+		i2c_stop();
+		memset(buf, 0xff, len);
+		return;
+	}
+	uint8_t dev = (size > 2048) ? dev_addr : (dev_addr | ((addr >> 8) & 0x07));
+	i2c_start((dev << 1) | I2C_READ);														// repeated start to read
+	for (uint8_t i = 0; i < len; i++) {
+		buf[i] = i2c_read_byte(i < len - 1);												// ack all, except the last byte
+	}
+	i2c_stop();
+}
+
+void I2C_EEP::write(uint16_t addr, uint8_t len, void *ptr) {
+	uint8_t *buf = (uint8_t*)ptr;
+	if (set_addr(addr)) {
+		for (uint8_t i = 0; i < len; i++) {
+			i2c_send_byte(buf[i]);
+		}
+	}
+	i2c_stop();																				// starts the internal write cycle
+}
+
+uint8_t I2C_EEP::ready(void) {
+	uint8_t ack = i2c_start((dev_addr << 1) | I2C_WRITE);									// device answers when the write is done
+	i2c_stop();
+	return ack;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+/*-- spi fram -------------------------------------------------------------------------------------------------------------
+* FM25Cxx or MB85RSxx series, no write latency, therefor the cache is bypassed. the spi bus is shared with the
+* communication module, spi mode 0 fits both.
+*/
+#define FRAM_WREN             0x06
+#define FRAM_WRITE            0x02
+#define FRAM_READ             0x03
+
+SPI_FRAM::SPI_FRAM(uint8_t pin_cs, uint16_t fram_size) {
+	def_cs = pin_cs;
+	size = fram_size;
+	page = 0;
+}
+
+void SPI_FRAM::init(void) {
+	set_pin_output(def_cs);																	// chip select is low active
+	set_pin_high(def_cs);
+	enable_spi();
+}
+
+void SPI_FRAM::select(uint8_t opcode, uint16_t addr) {
+	set_pin_low(def_cs);
+	spi_send_byte(opcode);
+	spi_send_byte(addr >> 8);
+	spi_send_byte(addr & 0xff);
+}
+
+void SPI_FRAM::read(uint16_t addr, uint8_t len, void *ptr) {
+	uint8_t *buf = (uint8_t*)ptr;
+	select(FRAM_READ, addr);
+	for (uint8_t i = 0; i < len; i++) {
+		buf[i] = spi_send_byte(0);
+	}
+	set_pin_high(def_cs);
+}
+
+void SPI_FRAM::write(uint16_t addr, uint8_t len, void *ptr) {
+	uint8_t *buf = (uint8_t*)ptr;
+	set_pin_low(def_cs);																	// write enable latch, needed before every write
+	spi_send_byte(FRAM_WREN);
+	set_pin_high(def_cs);
+
+	select(FRAM_WRITE, addr);
+	for (uint8_t i = 0; i < len; i++) {
+		spi_send_byte(buf[i]);
+	}
+	set_pin_high(def_cs);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+
+#if !defined(__AVR__)
+/*-- file backed storage --------------------------------------------------------------------------------------------------
+* for host side tests, the content is kept in a binary file which is created with size bytes of 0xff if it doesn't exist
+*/
+FILE_EEP::FILE_EEP(const char *file_name, uint16_t file_size) {
+	name = file_name;
+	size = file_size;
+	page = 0;
+	file = 0;
+}
+
+void FILE_EEP::init(void) {
+	if (file) return;
+	file = fopen(name, "r+b");
+	if (file) return;
+
+	file = fopen(name, "w+b");																// new file, fill it like a virgin eeprom
+	for (uint16_t i = 0; i < size; i++) {
+		fputc(0xff, file);
+	}
+	fflush(file);
+}
+
+void FILE_EEP::read(uint16_t addr, uint8_t len, void *ptr) {
+	memset(ptr, 0xff, len);
+	if (!file) return;
+	fseek(file, addr, SEEK_SET);
+	fread(ptr, 1, len, file);
+}
+
+void FILE_EEP::write(uint16_t addr, uint8_t len, void *ptr) {
+	if (!file) return;
+	fseek(file, addr, SEEK_SET);
+	fwrite(ptr, 1, len, file);
+	fflush(file);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,101 @@
+/**
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin storage backend class ------------------------------------------------------------------------------------------
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#ifndef _AS_STORAGE_H
+#define _AS_STORAGE_H
+
+#include "HAL.h"
+
+
+/**
+* @short Storage backend for the eeprom functions defined in HAL.h
+*
+* The backend is selected in the user sketch, same as the communication module:
+* @code
+* INT_EEP as_eeprom;                                   // internal eeprom
+* //I2C_EEP as_eeprom(0x50, 8192, 32);                 // 24C64 on i2c address 0x50, 32 byte pages
+* //SPI_FRAM as_eeprom(pinD7, 8192);                   // FM25CL64/MB85RS64 with chip select on pinD7
+* EEP *eep = &as_eeprom;
+* @endcode
+*
+* page defines how the write back cache in as_storage.cpp works with the backend:
+* 1 - byte wise writes, the write back is done byte by byte (internal eeprom)
+* n - page wise writes, dirty bytes of a cache line are written in one page write, misses on reads fill the cache (i2c eeprom)
+* 0 - no write latency, the cache is bypassed and everything is written through (fram, file)
+*/
+class EEP {
+public:  //----------------------------------------------------------------------------------------------------------------
+	uint16_t size;																			// capacity of the storage in byte
+	uint8_t  page;																			// page size, see above
+
+	virtual void    init(void) {}															// initialize the storage hardware
+	virtual void    read(uint16_t, uint8_t, void *) {}										// read a block
+	virtual void    write(uint16_t, uint8_t, void *) {}										// start to write a block, len is within one page
+	virtual uint8_t ready(void) { return 1; }												// 1 if the previous write is done
+	virtual uint8_t set_irq(uint8_t) { return 0; }											// control the interrupt engine, 0 if there is none
+	virtual uint8_t get_irq(void) { return 0; }												// 1 if the interrupt engine is armed
+};
+
+class INT_EEP : public EEP {
+public:  //----------------------------------------------------------------------------------------------------------------
+	INT_EEP();
+
+	void    read(uint16_t addr, uint8_t len, void *ptr);
+	void    write(uint16_t addr, uint8_t len, void *ptr);
+	uint8_t ready(void);
+	uint8_t set_irq(uint8_t enable);
+	uint8_t get_irq(void);
+};
+
+class I2C_EEP : public EEP {
+public:  //----------------------------------------------------------------------------------------------------------------
+	I2C_EEP(uint8_t i2c_addr, uint16_t eeprom_size, uint8_t page_size);
+
+	void    init(void);
+	void    read(uint16_t addr, uint8_t len, void *ptr);
+	void    write(uint16_t addr, uint8_t len, void *ptr);
+	uint8_t ready(void);
+
+private:  //---------------------------------------------------------------------------------------------------------------
+	uint8_t dev_addr;																		// 7 bit i2c address of the device
+
+	uint8_t set_addr(uint16_t addr);														// start condition and word address
+};
+
+class SPI_FRAM : public EEP {
+public:  //----------------------------------------------------------------------------------------------------------------
+	SPI_FRAM(uint8_t pin_cs, uint16_t fram_size);
+
+	void    init(void);
+	void    read(uint16_t addr, uint8_t len, void *ptr);
+	void    write(uint16_t addr, uint8_t len, void *ptr);
+
+private:  //---------------------------------------------------------------------------------------------------------------
+	uint8_t def_cs;																			// chip select pin
+
+	void    select(uint8_t opcode, uint16_t addr);											// chip select, opcode and address
+};
+
+#if !defined(__AVR__)
+#include <stdio.h>
+
+class FILE_EEP : public EEP {
+public:  //----------------------------------------------------------------------------------------------------------------
+	FILE_EEP(const char *file_name, uint16_t file_size);
+
+	void    init(void);
+	void    read(uint16_t addr, uint8_t len, void *ptr);
+	void    write(uint16_t addr, uint8_t len, void *ptr);
+
+private:  //---------------------------------------------------------------------------------------------------------------
+	const char *name;
+	FILE *file;
+};
+#endif
+
+#endif
@@ -0,0 +1,196 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin benchmarks -----------------------------------------------------------------------------------------------------
+*  cycles of the hot paths of the library. the firmware runs under simavr, counts the cycles of every routine with timer1
+*  at F_CPU and writes one line per routine on the simavr console:
+*    bench <name> <avg cycles> <min cycles> <max cycles> <calls>
+*  after a first line with the mcu and the config of the build (BENCH_NAME), F_CPU and the cycles of the empty call:
+*    bench_start <mcu>-<config> <f_cpu> <cycles>
+*  the cycles are without the call of an empty function through the same pointer. timer0 and the eeprom interrupt are off
+*  while the benchmarks are running, only the overflow of timer1 is counted. see the Makefile for the table and the
+*  comparison with the baseline.
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include "00_debug-flag.h"
+#include <newasksin.h>
+#include "register.h"
+
+#include <avr/sleep.h>
+#include <avr_mcu_section.h>																// simavr, console and the mcu for run_avr
+
+AVR_MCU(F_CPU, BENCH_MCU);
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+#define BENCH_CALLS        32																// calls per routine
+
+
+/*-- console and cycle counter ------------------------------------------------------------------------------------------
+* simavr prints the characters written to GPIOR0 line by line on its console
+*/
+class BENCH_CON : public Print {
+public:
+	size_t write(uint8_t c) {
+		GPIOR0 = c;
+		return 1;
+	}
+};
+static BENCH_CON con;
+
+static volatile uint16_t cyc_ovf;
+
+ISR(TIMER1_OVF_vect) {
+	cyc_ovf++;
+}
+
+static void cyc_init(void) {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);																		// no prescaler, one tick per cycle
+	TCNT1 = 0;
+	TIFR1 = _BV(TOV1);
+	TIMSK1 = _BV(TOIE1);
+}
+
+static uint32_t cyc_get(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t lo = TCNT1, hi = cyc_ovf;
+	if ((TIFR1 & _BV(TOV1)) && (lo < 0x8000)) hi++;											// wrapped, but the interrupt is still pending
+	SREG = sreg;
+	return ((uint32_t)hi << 16) | lo;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- the routines -------------------------------------------------------------------------------------------------------
+* every benchmark has a prepare function which is not measured and a run function which is measured
+*/
+static uint8_t       frame[28];
+static uint8_t       block[16];
+static uint8_t       key[16] = { 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10, };
+static aes128_ctx_t  ctx;
+static uint16_t      crc;
+static uint8_t       reg_addr;
+static uint8_t       peer[4];
+static volatile uint8_t result;
+
+/* DEVICE_INFO of the dimmer, the longest frame the device sends */
+static const uint8_t dev_info[] PROGMEM = { 0x1A,0x01,0x84,0x00,0x33,0x12,0x35,0x00,0x00,0x00,0x29,0x00,0x67,0x48,0x42,0x64,0x69,0x6D,0x6D,0x65,0x72,0x33,0x35,0x00,0x41,0x01,0x00, };
+/* CONFIG_STATUS_REQUEST of the master for channel 1 */
+static const uint8_t status_req[] PROGMEM = { 0x0B,0x11,0xA0,0x01,0x63,0x19,0x64,0x33,0x12,0x35,0x01,0x0E, };
+static const uint8_t master[3] = { 0x63,0x19,0x64, };
+
+static void prep_none(void) { }
+static void run_none(void) { }
+
+static void prep_frame(void) { memcpy_P(frame, dev_info, sizeof(dev_info)); }
+static void run_hm_encode(void) { hm_encode(frame); }
+static void run_hm_decode(void) { hm_decode(frame); }
+
+static void run_aes128_init(void) { aes128_init(key, &ctx); }
+static void prep_block(void) { aes128_init(key, &ctx); memcpy(block, key, 16); }
+static void run_aes128_enc(void) { aes128_enc(block, &ctx); }
+static void run_aes128_dec(void) { aes128_dec(block, &ctx); }
+
+static void prep_crc16(void) { crc = 0xffff; }
+static void run_crc16(void) { crc = crc16(crc, 0xA5); }
+
+static void prep_ptr_to_val(void) { reg_addr = pgm_read_byte(&cmm[1]->lstC.reg[cmm[1]->lstC.len - 1]); }	// last register, longest search
+static void run_ptr_to_val(void) { result = *cmm[1]->lstC.ptr_to_val(reg_addr); }
+
+static void prep_get_idx(void) { memcpy(peer, cmm[1]->peerDB.get_peer(cmm[1]->peerDB.used - 1), 4); }	// last peer of the channel
+static void run_get_idx(void) { result = cmm[1]->peerDB.get_idx(peer); }
+
+static void prep_rcv(void) {
+	memcpy_P(rcv_msg.buf, status_req, sizeof(status_req));
+	snd_msg.active = MSG_ACTIVE::NONE;
+}
+static void run_get_intend(void) { hm.bench_get_intend(); }
+static void prep_process(void) { prep_rcv(); hm.bench_get_intend(); }
+static void run_process(void) { hm.bench_process_message(); }
+
+struct s_bench {
+	const char *name;
+	void (*prep)(void);
+	void (*run)(void);
+};
+
+static const s_bench bench[] = {
+	{ "hm_encode",          prep_frame,      run_hm_encode, },
+	{ "hm_decode",          prep_frame,      run_hm_decode, },
+	{ "aes128_init",        prep_none,       run_aes128_init, },
+	{ "aes128_enc",         prep_block,      run_aes128_enc, },
+	{ "aes128_dec",         prep_block,      run_aes128_dec, },
+	{ "crc16",              prep_crc16,      run_crc16, },
+	{ "ptr_to_val",         prep_ptr_to_val, run_ptr_to_val, },
+	{ "peer_get_idx",       prep_get_idx,    run_get_idx, },
+	{ "get_intend",         prep_rcv,        run_get_intend, },
+	{ "process_message",    prep_process,    run_process, },
+};
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/* calls the routine BENCH_CALLS times, the prepare function is called before every call and not measured */
+static void measure(const s_bench *b, uint32_t offset, uint32_t *avg, uint32_t *min, uint32_t *max) {
+	uint32_t sum = 0;
+	*min = 0xffffffff;
+	*max = 0;
+	for (uint8_t i = 0; i < BENCH_CALLS; i++) {
+		b->prep();
+		uint32_t start = cyc_get();
+		b->run();
+		uint32_t cycles = cyc_get() - start;
+		cycles = (cycles > offset) ? cycles - offset : 0;
+		sum += cycles;
+		if (cycles < *min) *min = cycles;
+		if (cycles > *max) *max = cycles;
+	}
+	*avg = (sum + BENCH_CALLS / 2) / BENCH_CALLS;
+}
+
+/* the device as it runs after a pairing, a master and a channel with all peers used */
+static void bench_device(void) {
+	init_millis_timer0();
+	hm.init();
+	memcpy(dev_operate.MAID, master, 3);
+
+	uint8_t p[4] = { 0x11, 0x22, 0x30, 0x01, };
+	for (uint8_t i = 0; i < cmm[1]->peerDB.max; i++, p[2]++) cmm[1]->peerDB.set_peer(i, p);
+	while (get_int_eeprom_irq());															// the eeprom queue is written
+
+	TIMSK0 = 0;																				// nothing else may count
+}
+
+void setup() {
+	bench_device();
+	cyc_init();
+	sei();
+
+	uint32_t avg, min, max, offset;
+	const s_bench none = { "none", prep_none, run_none, };
+	measure(&none, 0, &offset, &min, &max);													// the call itself and cyc_get()
+
+	con << F("bench_start ") << BENCH_NAME << ' ' << F_CPU << ' ' << offset << '\n';
+	for (uint8_t i = 0; i < sizeof(bench) / sizeof(bench[0]); i++) {
+		measure(&bench[i], offset, &avg, &min, &max);
+		con << F("bench ") << bench[i].name << ' ' << avg << ' ' << min << ' ' << max << ' ' << BENCH_CALLS << '\n';
+	}
+	con << F("bench_end\n");
+
+	cli();																					// simavr ends the run on a sleep with interrupts off
+	sleep_enable();
+	sleep_cpu();
+}
+
+void loop() {
+}
+
+
+/* the dimmer of register.h needs them, there is no pwm in the benchmarks */
+void CM_DIMMER::init_dimmer(uint8_t virtual_group, uint8_t virtual_channel, uint8_t channel) {
+}
+
+void CM_DIMMER::switch_dimmer(uint8_t virtual_group, uint8_t virtual_channel, uint8_t channel, uint8_t status, uint8_t pwm_multi) {
+}
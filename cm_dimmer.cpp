@@ -105,6 +105,8 @@ void CM_DIMMER::cm_poll(void) {
 	/* tr11 poll */
 	if (tr11.active) poll_tr11();															// poll if something is to do
 
+	/* stay in the poll while something is running or to send */
+	sched.mark_cnl(lstC.cnl, (cms.sm_active) || (tr11.active) || (cms.msg_type) || (cms.value != cms.set_value));
 }
 
 void CM_DIMMER::info_config_change(uint8_t channel) {
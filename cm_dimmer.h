@@ -27,11 +27,11 @@ static uint8_t pwm_multiplier;															// define a byte for the pwm multip
 
 
 /* list 1/3 definition for dimmer channel module */
-const uint8_t cm_dimmer_ChnlReg[] PROGMEM = { 0x08,0x30,0x32,0x34,0x35,0x56,0x57,0x58,0x59, };
-const uint8_t cm_dimmer_ChnlDef[] PROGMEM = { 0x00,0x06,0x50,0x4b,0x50,0x00,0x24,0x01,0x01, };
+constexpr uint8_t cm_dimmer_ChnlReg[] PROGMEM = { 0x08,0x30,0x32,0x34,0x35,0x56,0x57,0x58,0x59, };
+constexpr uint8_t cm_dimmer_ChnlDef[] PROGMEM = { 0x00,0x06,0x50,0x4b,0x50,0x00,0x24,0x01,0x01, };
 
-const uint8_t cm_dimmer_PeerReg[] PROGMEM = { 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x26,0x27,0x28,0x29,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c,0x8d,0x8e,0x8f,0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa6,0xa7,0xa8,0xa9, };
-const uint8_t cm_dimmer_PeerDef[] PROGMEM = { 0x00,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x00,0x11,0x11,0x11,0x20,0x00,0x14,0xc8,0x0a,0x05,0x05,0x00,0xc8,0x0a,0x0a,0x04,0x04,0x00,0x11,0x11,0x11,0x00,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x00,0x11,0x11,0x11,0x20,0x00,0x14,0xc8,0x0a,0x05,0x05,0x00,0xc8,0x0a,0x0a,0x04,0x04,0x00,0x11,0x11,0x11, };
+constexpr uint8_t cm_dimmer_PeerReg[] PROGMEM = { 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x26,0x27,0x28,0x29,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c,0x8d,0x8e,0x8f,0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa6,0xa7,0xa8,0xa9, };
+constexpr uint8_t cm_dimmer_PeerDef[] PROGMEM = { 0x00,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x00,0x11,0x11,0x11,0x20,0x00,0x14,0xc8,0x0a,0x05,0x05,0x00,0xc8,0x0a,0x0a,0x04,0x04,0x00,0x11,0x11,0x11,0x00,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x00,0x11,0x11,0x11,0x20,0x00,0x14,0xc8,0x0a,0x05,0x05,0x00,0xc8,0x0a,0x0a,0x04,0x04,0x00,0x11,0x11,0x11, };
 
 
 /* dimmer channel module specific enums */
@@ -257,17 +257,18 @@ public:  //---------------------------------------------------------------------
 
 	/* function definition for dimmer module */
 	CM_DIMMER(const uint8_t peer_max, uint8_t virtual_channel = 0, uint8_t virtual_group = 0);// constructor
+	CM_DEF_TYPE(cm_dimmer_ChnlReg, cm_dimmer_ChnlDef, cm_dimmer_PeerReg, cm_dimmer_PeerDef);	// line of cm_def[] in the user sketch
 
 	s_cm_status cms;																		// defined in type_defs, holds current status and set_satatus
 
-	virtual void cm_init(void);																// init function, called after AS initialisation
-	virtual void cm_poll(void);																// poll function, driven by HM loop
+	CM_VIRTUAL void cm_init(void);															// init function, called after AS initialisation
+	CM_VIRTUAL void cm_poll(void);															// poll function, driven by HM loop
 
-	virtual void info_config_change(uint8_t channel);										// list1 on registered channel had changed
-	virtual void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
+	CM_VIRTUAL void info_config_change(uint8_t channel);									// list1 on registered channel had changed
+	CM_VIRTUAL void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
 
-	virtual void instruction_msg(MSG_TYPE::E type, uint8_t *buf);							// consolidation of ~10 virtual function definitions
-	virtual void peer_action_msg(MSG_TYPE::E type, uint8_t *buf);							// consolidation of ~10 virtual function definitions
+	CM_VIRTUAL void instruction_msg(MSG_TYPE::E type, uint8_t *buf);						// consolidation of ~10 virtual function definitions
+	CM_VIRTUAL void peer_action_msg(MSG_TYPE::E type, uint8_t *buf);						// consolidation of ~10 virtual function definitions
 	
 
 	/* receive functions to handle requests forwarded by AS:processMessage
@@ -23,6 +23,10 @@
 *
 * Has to be defined within the channel module or externally from the class
 */
+extern const uint8_t cm_maintenance_ChnlLen;
+extern const uint8_t cm_maintenance_ChnlReg[];
+extern const uint8_t cm_maintenance_ChnlDef[];
+extern uint8_t cm_maintenance_ChnlVal[];
 
 class CM_MAINTENANCE : public CM_MASTER {
 
@@ -30,8 +34,16 @@ public:
 	
 	CM_MAINTENANCE(const uint8_t peer_max);													// constructor
 
-	virtual void info_config_change(uint8_t channel);										// list1 on registered channel had changed
-	virtual void cm_poll(void);																// poll function, driven by HM loop
+	/* line of cm_def[], the registers are defined in the user sketch, the compiler needs them before the call */
+	static constexpr s_cm_def cm_def_c(uint8_t peer_max) {
+		return { cm_maintenance_ChnlReg, cm_maintenance_ChnlDef, cm_maintenance_ChnlLen, 0, 0, 0, peer_max };
+	}
+	static constexpr uint8_t cm_def_fits(const s_cm_def &def) {
+		return cm_def_same_c(def, cm_def_c(def.peer_max));
+	}
+
+	CM_VIRTUAL void info_config_change(uint8_t channel);									// list1 on registered channel had changed
+	CM_VIRTUAL void cm_poll(void);															// poll function, driven by HM loop
 
 };
 
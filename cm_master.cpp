@@ -13,6 +13,7 @@
 //public://------------------------------------------------------------------------------------------------------------------
 CM_MASTER::CM_MASTER(const uint8_t peer_max) {
 	peerDB.max = peer_max;
+	peerDB.cnl = cnl_max;																	// records in the peer pool are tagged with the channel
 
 	lstC.cnl = cnl_max;																		// set the channel to the lists
 	lstP.cnl = cnl_max++;
@@ -24,16 +25,25 @@ CM_MASTER::CM_MASTER(const uint8_t peer_max) {
 */
 void CM_MASTER::init(void) {
 	DBG(CM, F("CM"), lstC.cnl, F(":INIT\n"));
-	cm_init();																				// init the virtual poll function
+	cm_call_init(lstC.cnl);																	// init function of the channel module
+	sched.set_cnl(lstC.cnl);																// first poll in any case
 }
 
+#ifndef CM_STATIC
 /*
-* @brief init is called by main init function,
-* the function here can cover all initialization of channel master modules
+* @brief Poll the channel modules which are flagged in the scheduler, a byte without flags skips 8 channels at once
 */
-void CM_MASTER::poll(void) {
-	cm_poll();																				// poll the virtual poll function 
+void cm_call_poll(void) {
+	for (uint8_t i = 0; i < (cm_def_cnt + 7) >> 3; i++) {
+		uint8_t bits = sched_cnl[i];
+		if (!bits) continue;
+		sched_cnl[i] = 0;																	// the channel modules flag themselves again
+		for (uint8_t cnl = i << 3; bits; cnl++, bits >>= 1) {
+			if (bits & 1) PRF(s_prf::cnl_stage(cnl), NRG(s_nrg::cnl_ctx(cnl), cmm[cnl]->cm_poll()));
+		}
+	}
 }
+#endif
 
 
 /* 
@@ -102,9 +112,8 @@ void CM_MASTER::CONFIG_PEER_ADD(s_m01xx01 *buf) {
 		uint8_t idx = peerDB.get_idx(temp_peer);											// search if we have already the peer in the database
 		if (idx == 0xff) idx = peerDB.get_free_slot();										// not in the in the database, search a free slot
 
-		if (idx != 0xff) {																	// free slot available
-			peerDB.set_peer(idx, temp_peer);												// write the peer into the database
-			request_peer_defaults(idx, buf);												// ask the channel module to load the defaults
+		if ((idx != 0xff) && (peerDB.set_peer(idx, temp_peer))) {							// free slot available and device table not full
+			cm_call_peer_defaults(lstC.cnl, idx, buf);										// ask the channel module to load the defaults
 			ret_byte++;																		// increase success
 		}
 	}
@@ -119,21 +128,22 @@ void CM_MASTER::CONFIG_PEER_ADD(s_m01xx01 *buf) {
 * request is forwarded by the AS:processMessage function
 */
 void CM_MASTER::CONFIG_PEER_REMOVE(s_m01xx02 *buf) {
-	uint8_t temp_peer[4];																	// temp byte array to load peer addresses
 	uint8_t ret_byte = 0;																	// prepare a placeholder for success reporting
+	uint8_t dev = peer_dev.get_idx(buf->PEER_ID);											// device index in the shared table, compare the HMID only once
+	if (config_mode.commit) process_config_commit();										// slot indexes of the channel are moving while removing
 
 	for (uint8_t i = 0; i < 2; i++) {														// standard gives 2 peer channels
 		if (!buf->PEER_CNL[i]) continue;													// if the current peer channel is empty, go to the next entry
 
-		memcpy(temp_peer, buf->PEER_ID, 3);													// copy the peer address into the temp array
-		temp_peer[3] = buf->PEER_CNL[i];													// write the peer channel byte into the array
-		uint8_t idx = peerDB.get_idx(temp_peer);											// find the peer in the database
+		uint8_t idx = peerDB.get_idx(dev, buf->PEER_CNL[i]);								// find the peer in the database
 
 		if (idx != 0xff) {																	// found it
 			peerDB.clear_peer(idx);															// delete the peer in the database
+			peer_idx_release(this, idx);													// pending jobs of the channel are following the moved slots
 			ret_byte++;																		// increase success
 		}
 	}
+	if (ret_byte) peer_dev_release(dev);													// clear the device if no other channel needs it
 	DBG(CM, F("CM"), lstC.cnl, F(":CONFIG_PEER_REMOVE- cnl:"), buf->MSG_CNL, F(", peer:"), _HEX(buf->PEER_ID, 3), F(", CNL_A:"), _HEX(buf->PEER_CNL[0]), F(", CNL_B:"), _HEX(buf->PEER_CNL[1]), '\n');
 	hm.check_send_ACK_NACK(ret_byte);
 }
@@ -199,15 +209,18 @@ void CM_MASTER::CONFIG_PARAM_REQ(s_m01xx04 *buf) {
 */
 void CM_MASTER::CONFIG_START(s_m01xx05 *buf) {
 	s_config_mode *cm = &config_mode;														// short hand to config mode struct
+	if (cm->commit) process_config_commit();												// previous session is not committed yet, needs list and idx_peer
 	cm->list = list[buf->PARAM_LIST];														// short hand to the list table
 	cm->idx_peer = peerDB.get_idx(buf->PEER_ID);											// try to get the peer index
+	cm->stage_clear();																		// start with an empty stage
 
-	if ((cm->list) && (cm->idx_peer != 0xff)) {												// list and peer index found
+	if ((cm->list) && (cm->idx_peer != 0xff) && (cm->list->len <= config_stage_len)) {		// list and peer index found, list fits into the stage
 		cm->timer.set(5000);																// set timeout time, otherwise the channel will be open for write forever
 		cm->active = 1;																		// set active
 		hm.send_ACK();																		// send back that everything is ok
 		// TODO: set message id flag to config in send module
 	} else {
+		cm->active = 0;																		// no session, CONFIG_END will not commit
 		hm.send_NACK();																	// something wrong
 	}
 	DBG(CM, F("CM"), lstC.cnl, F(":CONFIG_START- cnl:"), buf->MSG_CNL, '/', cm->list->cnl, F(", lst:"), buf->PARAM_LIST, '/', cm->list->lst, F(", peer:"), _HEX(buf->PEER_ID, 4), F(", idx:"), cm->idx_peer, '\n');
@@ -223,14 +236,10 @@ void CM_MASTER::CONFIG_START(s_m01xx05 *buf) {
 void CM_MASTER::CONFIG_END(s_m01xx06 *buf) {
 	s_config_mode *cm = &config_mode;														// short hand to config mode struct
 	cm->timer.set(0);																		// clear the timer
+	if (cm->active) cm->commit = 1;															// staged pairs are committed by AS::poll when the ACK is out
 	cm->active = 0;																			// clear the flag
 
 	hm.send_ACK();																			// send back that everything is ok
-
-	if (cm->list->lst < 2) {
-		lstC.load_list(cm->idx_peer);														// reload list0 or 1
-		inform_config_change(lstC.cnl);														// inform the channel module on a change of list0 or 1
-	}
 	// TODO: remove message id flag to config in send module
 	DBG(CM, F("CM"), lstC.cnl, F(":CONFIG_END- cnl:"), buf->MSG_CNL, '\n');
 }
@@ -253,11 +262,14 @@ void CM_MASTER::CONFIG_WRITE_INDEX1(s_m01xx07 *buf) {
 void CM_MASTER::CONFIG_WRITE_INDEX2(s_m01xx08 *buf) {
 	s_config_mode *cm = &config_mode;														// short hand to config mode struct
 
-	if (cm->active)  {																		// check if config is active, channel fit is checked in AS
-		cm->list->write_array(buf->DATA, buf->MSG_LEN - 11, cm->idx_peer);					// write the array into the list
-		hm.send_ACK();																		// we are fine
+	if (cm->active) {																		// check if config is active, channel fit is checked in AS
+		cm->stage_array(buf->DATA, buf->MSG_LEN - 11);
+		hm.send_ACK();																		// staged, we are fine
 		DBG(CM, F("CM"), lstC.cnl, F(":CONFIG_WRITE_INDEX2- cnl:"), buf->MSG_CNL, F(", lst:"), cm->list->lst, F(", idx:"), cm->idx_peer, '\n');
-	} else hm.send_NACK();
+	} else {
+		if (!cm->commit) cm->stage_clear();													// poison the session, a finished session keeps its stage
+		hm.send_NACK();
+	}
 }
 
 /*
@@ -381,6 +393,15 @@ void process_send_status_poll(s_cm_status *cm, uint8_t cnl) {
 
 
 //- channel master related helpers ----------------------------------------------------------------------------------------
+
+s_peer_dev peer_dev;																		// peer devices, shared by all channels
+s_peer_pool peer_pool;																		// peers and list3/4 of all channels
+s_ee_check ee_check;																		// crc's of the eeprom blocks
+
+static struct {
+	uint16_t ee_addr;																		// eeprom address of the config journal
+	uint8_t  max;																			// max content length, size of the biggest list
+} cm_journal;
 /*
 * @brief Prepare defaults and read the defaults from the eeprom in the channel module space.
 *        We have to read only list0 or list 1 content, while list 3 or list 4 is read while received a peer message.
@@ -395,22 +416,432 @@ uint16_t cm_prep_default(uint16_t ee_start_addr) {
 
 		cmm[i]->lstC.ee_addr = ee_start_addr;												// write the eeprom address in the channel list
 		ee_start_addr += cmm[i]->lstC.len;													// create new address by adding the length of the list before
-		cmm[i]->lstP.ee_addr = ee_start_addr;												// write the eeprom address in the peer list
-		ee_start_addr += (cmm[i]->lstP.len * cmm[i]->peerDB.max);							// create new address by adding the length of the list before but while peer list, multiplied by the amount of possible peers
+		cmm[i]->lstP.ee_addr = 0;															// peer lists are stored in the peer pool
 
 		// defaults loaded in the AS module init, on every time start
 		DBG(CM, F("CMX:PREP_DEFAULTS- cnl:"), cmm[i]->lstC.cnl, F(", lst:"), cmm[i]->lstC.lst, F(", len:"), cmm[i]->lstC.len, F(", data:"), _HEX(cmm[i]->lstC.val, cmm[i]->lstC.len), '\n');
 		//dbg << F("list_ptr: ") << (uint16_t)cmm[i]->list[0] << F(", ") << (uint16_t)cmm[i]->list[1] << F(", ") << (uint16_t)cmm[i]->list[2] << F(", ") << (uint16_t)cmm[i]->list[3] << F(", ") << (uint16_t)cmm[i]->list[4] << F(", ") << (uint16_t)cmm[i]->list[5] << F(", ") << '\n';
 	}
 
-	for (uint8_t i = 0; i < cnl_max; i++) {													// step through all channels
-		cmm[i]->peerDB.ee_addr = ee_start_addr;												// write eeprom address into the peer table
-		ee_start_addr += cmm[i]->peerDB.max * 4;											// create nwe eeprom start address depending on the space for max peers are used
-	}
+	cm_journal.max = config_stage_len;														// journal needs the size of the biggest list, calculated by the compiler
+
+	peer_pool.ee_addr = ee_start_addr;														// peers and their lists of all channels
+	peer_pool.size = peer_pool_size;
+	ee_start_addr += peer_pool.size;
+	peer_pool.ee_move = ee_start_addr;														// move markers of the pool compaction
+	ee_start_addr += 2 * sizeof(s_pool_move);
+
+	peer_dev.max = peer_dev_max;															// shared peer device table behind the peer pool
+	peer_dev.ee_addr = ee_start_addr;
+	ee_start_addr += peer_dev.max * 3;
+
+	cm_journal.ee_addr = ee_start_addr;														// config journal
+	ee_start_addr += sizeof(s_cm_journal_hdr) + cm_journal.max;
+
+	ee_check.ee_addr = ee_start_addr;														// crc table of the fixed blocks is the last one
+	ee_start_addr += (EE_BLOCK_LIST + cnl_max) * 2;
 
 	return ee_start_addr;
 }
 
+/*
+* @brief Commits the staged values of a config session. The new list content is written to the journal
+* first, afterwards to the list itself and then the journal is invalidated. A power loss in between is repaired by
+* cm_journal_recover() at the next start, so the list is written completely or not at all.
+* Called by AS::poll when the ACK of CONFIG_END is sent, while the eeprom barriers are blocking.
+*/
+void process_config_commit(void) {
+	s_config_mode *cm = &config_mode;														// short hand to config mode struct
+	if (!cm->commit) return;
+	cm->commit = 0;
+
+	s_list_table *list = cm->list;
+	list->load_list(cm->idx_peer);															// current content of the list
+	cm->stage_apply();																		// apply the staged values
+	cm->stage_clear();
+
+	uint16_t addr = list->get_ee_addr(cm->idx_peer);
+	s_cm_journal_hdr hdr = { list->len, addr, cm_journal_crc(addr, list->len, list->val) };
+	set_eeprom(cm_journal.ee_addr + sizeof(hdr), list->len, list->val);						// journal content
+	set_eeprom(cm_journal.ee_addr, sizeof(hdr), &hdr);										// and header
+	flush_eeprom();																			// journal has to be complete before the list is touched
+	list->save_list(cm->idx_peer);
+	flush_eeprom();																			// list is in place
+	clear_eeprom(cm_journal.ee_addr, 1);													// journal is not needed anymore
+
+	if (list->lst < 2) inform_config_change(list->cnl);										// inform the channel module on a change of list0 or 1
+	DBG(CM, F("CMX:CONFIG_COMMIT- cnl:"), list->cnl, F(", lst:"), list->lst, F(", addr:"), addr, F(", crc:"), hdr.crc, '\n');
+}
+
+/*
+* @brief Checks the config journal on startup, a valid journal indicates a commit which was interrupted,
+* the journal content is copied into the list.
+*/
+void cm_journal_recover(void) {
+	s_cm_journal_hdr hdr;
+	get_eeprom(cm_journal.ee_addr, sizeof(hdr), &hdr);
+	if ((!hdr.len) || (hdr.len > cm_journal.max)) return;									// no journal
+
+	uint16_t crc = cm_journal_crc(hdr.addr, hdr.len, 0);									// header part of the crc
+	for (uint8_t i = 0; i < hdr.len; i++) {													// verify the content byte by byte
+		uint8_t b;
+		get_eeprom(cm_journal.ee_addr + sizeof(hdr) + i, 1, &b);
+		crc = crc16(crc, b);
+	}
+	if (crc == hdr.crc) {
+		for (uint8_t i = 0; i < hdr.len; i++) {												// copy the journal into the list
+			uint8_t b;
+			get_eeprom(cm_journal.ee_addr + sizeof(hdr) + i, 1, &b);
+			set_eeprom(hdr.addr + i, 1, &b);
+		}
+		flush_eeprom();
+		ee_check.update_addr(hdr.addr);														// list was written without its crc
+	}
+	clear_eeprom(cm_journal.ee_addr, 1);													// journal is done
+	DBG(CM, F("CMX:JOURNAL_RECOVER- addr:"), hdr.addr, F(", len:"), hdr.len, F(", valid:"), (crc == hdr.crc), '\n');
+}
+
+/*
+* @brief Invalidates the config journal, needed on first time start
+*/
+void cm_journal_clear(void) {
+	clear_eeprom(cm_journal.ee_addr, 1);
+}
+
+/* crc over target address, length and content of a journal entry, without buf only the header part is calculated */
+uint16_t cm_journal_crc(uint16_t addr, uint8_t len, uint8_t *buf) {
+	uint16_t crc = crc16(crc16(crc16(0xffff, addr >> 8), addr & 0xff), len);
+	for (uint8_t i = 0; (buf) && (i < len); i++) {
+		crc = crc16(crc, buf[i]);
+	}
+	return crc;
+}
+
+/*
+* @brief Counts the records per channel and finds the end of the peer pool. Has to be called on every start,
+* after the eeprom content is checked or cleared and before the channel modules are initialized.
+*/
+void s_peer_pool::init(void) {
+	for (uint8_t i = 0; i < cnl_max; i++) cmm[i]->peerDB.used = 0;
+
+	used = 0;
+	while (used < size) {																	// walk through the records
+		uint8_t cnl;
+		get_eeprom(ee_addr + used, 1, &cnl);
+		if (!is_rec_cnl(cnl)) break;														// empty channel byte marks the end
+		uint8_t len = get_rec_len(cnl);
+		if (used + len > size) break;
+		s_peer_table *pt = &cmm[cnl]->peerDB;
+		if (pt->used < pt->max) pt->used++;													// records above peer_max are not reachable by idx
+		used += len;
+	}
+	DBG(CM, F("CMX:PEER_POOL- used:"), used, F(", size:"), size, '\n');
+}
+
+void s_peer_pool::clear_all(void) {
+	clear_eeprom(ee_addr, size);
+	clear_eeprom(ee_move, 2 * sizeof(s_pool_move));
+	ee_check.clear_verified();
+	used = 0;
+}
+
+/* the channel byte is read from the eeprom, it has to be checked before cmm[] is accessed with it */
+uint8_t s_peer_pool::is_rec_cnl(uint8_t cnl) {
+	return ((cnl) && (cnl < cnl_max) && (cmm[cnl]->lstP.lst != 255));
+}
+
+/* a record is the header with channel, device index + 1 and peer channel, followed by the list3/4 of the channel and the crc */
+uint8_t s_peer_pool::get_rec_len(uint8_t cnl) {
+	return 4 + cmm[cnl]->lstP.len;
+}
+
+uint8_t s_peer_pool::get_rec_nr(uint16_t addr) {
+	uint8_t cnl, nr = 0;
+	uint16_t rec = ee_addr;
+	for (; rec < addr; rec += get_rec_len(cnl), nr++) {
+		get_eeprom(rec, 1, &cnl);
+		if (!is_rec_cnl(cnl)) return 0xff;
+	}
+	return (rec == addr) ? nr : 0xff;
+}
+
+uint16_t s_peer_pool::get_rec_addr(uint8_t cnl, uint8_t idx) {
+	uint8_t rec_cnl;
+	for (uint16_t addr = ee_addr; addr < ee_addr + used; addr += get_rec_len(rec_cnl)) {
+		get_eeprom(addr, 1, &rec_cnl);
+		if (!is_rec_cnl(rec_cnl)) break;
+		if ((rec_cnl == cnl) && (!idx--)) return addr;
+	}
+	return 0;
+}
+
+/* the record is reserved only, header is written by the peer table */
+uint16_t s_peer_pool::alloc(uint8_t cnl) {
+	uint8_t len = get_rec_len(cnl);
+	if (used + len > size) return 0;
+	uint16_t addr = ee_addr + used;
+	used += len;
+	return addr;
+}
+
+/* compaction, all records behind the removed one are moved down and the freed space at the end is cleared */
+void s_peer_pool::release(uint16_t addr, uint8_t len) {
+	pool_move(addr, len, ee_addr + used, 0);
+	used -= len;
+	ee_check.clear_verified();																// record numbers behind the hole have changed
+}
+
+/* a compaction was interrupted if one of the markers is valid, the one with the higher hole is the newer one.
+*  the end of the records is unknown, the move runs to the end of the pool */
+void s_peer_pool::recover(void) {
+	s_pool_move mv[2];
+	get_eeprom(ee_move, sizeof(mv), mv);
+	uint8_t slot = 2;
+	for (uint8_t i = 0; i < 2; i++) {
+		if ((!mv[i].len) || (mv[i].crc != pool_move_crc(mv[i].hole, mv[i].len))) continue;
+		if ((mv[i].hole < ee_addr) || (mv[i].hole + mv[i].len > ee_addr + size)) continue;
+		if ((slot == 2) || (mv[i].hole > mv[slot].hole)) slot = i;
+	}
+	if (slot == 2) {																		// nothing to do
+		if (!isEmpty(mv, sizeof(mv))) clear_eeprom(ee_move, sizeof(mv));					// but a torn clear of the markers
+		return;
+	}
+	pool_move(mv[slot].hole, mv[slot].len, ee_addr + size, slot ^ 1);
+	DBG(CM, F("CMX:PEER_POOL_RECOVER- hole:"), mv[slot].hole, F(", len:"), mv[slot].len, '\n');
+}
+
+uint8_t pool_move_crc(uint16_t hole, uint8_t len) {
+	return crc16(crc16(crc16(0xffff, hole >> 8), hole & 0xff), len) & 0xff;
+}
+
+/*
+* @brief Moves the content behind the hole down by len byte and clears the freed space at the end. The move is done
+* in steps of not more than len byte, so a step does not overwrite its own source and can be repeated. After every
+* step the new hole is written alternating into one of the two move markers, a torn marker leaves the other one valid.
+* flush_eeprom() is the barrier between the content and the marker, a compaction blocks until it is written.
+*/
+void pool_move(uint16_t hole, uint8_t len, uint16_t end, uint8_t slot) {
+	uint8_t buf[16];
+	for (;;) {
+		s_pool_move mv = { hole, len, pool_move_crc(hole, len) };
+		set_eeprom(peer_pool.ee_move + slot * sizeof(mv), sizeof(mv), &mv);
+		flush_eeprom();																		// marker has to be in place before the step overwrites the source
+		slot ^= 1;
+		if (hole + len >= end) break;
+
+		uint8_t step = ((uint16_t)(end - hole - len) > len) ? len : (end - hole - len);
+		for (uint8_t i = 0; i < step; i += sizeof(buf)) {
+			uint8_t cnt = ((uint8_t)(step - i) > sizeof(buf)) ? sizeof(buf) : (step - i);
+			get_eeprom(hole + len + i, cnt, buf);
+			set_eeprom(hole + i, cnt, buf);
+		}
+		hole += step;
+		flush_eeprom();																		// step is done before the marker moves on
+	}
+	clear_eeprom(hole, len);
+	flush_eeprom();
+	clear_eeprom(peer_pool.ee_move + slot * sizeof(s_pool_move), sizeof(s_pool_move));		// compaction is done, the older marker first,
+	flush_eeprom();																			// it points to a step which is not repeatable anymore
+	clear_eeprom(peer_pool.ee_move + (slot ^ 1) * sizeof(s_pool_move), sizeof(s_pool_move));
+}
+
+uint8_t s_peer_pool::is_dev_used(uint8_t dev) {
+	uint8_t x[2];
+	for (uint16_t addr = ee_addr; addr < ee_addr + used; addr += get_rec_len(x[0])) {
+		get_eeprom(addr, 2, x);
+		if (!is_rec_cnl(x[0])) break;
+		if (x[1] == dev + 1) return 1;
+	}
+	return 0;
+}
+
+/*
+* @brief Integrity check of the eeprom blocks, see s_ee_check
+*/
+static uint16_t ee_block_crc(uint16_t crc, uint16_t addr, uint16_t len) {
+	uint8_t buf[16];
+	while (len) {																			// eeprom is read in small chunks
+		uint8_t cnt = (len > sizeof(buf)) ? sizeof(buf) : len;
+		get_eeprom(addr, cnt, buf);
+		for (uint8_t i = 0; i < cnt; i++) crc = crc16(crc, buf[i]);
+		addr += cnt; len -= cnt;
+	}
+	return crc;
+}
+
+uint16_t s_ee_check::calc(uint8_t block) {
+	if (block == EE_BLOCK_IDENT) return ee_block_crc(0xffff, 0, sizeof(s_dev_ident));
+	if (block == EE_BLOCK_PEER_DEV) return ee_block_crc(0xffff, peer_dev.ee_addr, peer_dev.max * 3);
+	s_list_table *list = &cmm[block - EE_BLOCK_LIST]->lstC;
+	return ee_block_crc(0xffff, list->ee_addr, list->len);
+}
+
+void s_ee_check::update(uint8_t block) {
+	uint16_t crc = calc(block);
+	set_eeprom(ee_addr + (block * 2), 2, &crc);
+}
+
+uint8_t s_ee_check::verify(uint8_t block) {
+	uint16_t crc;
+	get_eeprom(ee_addr + (block * 2), 2, &crc);
+	if (crc == calc(block)) return 1;
+
+	error = 1;
+	DBG(CM, F("CMX:EE_CHECK- block:"), block, F(" corrupted\n"));
+
+	if (block == EE_BLOCK_IDENT) {															// HMID, serial and key from PROGMEM, magic stays
+		get_eeprom(0, sizeof(dev_ident), &dev_ident);
+		memcpy_P(((uint8_t*)&dev_ident) + 2, HMSerialData, sizeof(dev_ident) - 2);
+		set_eeprom(0, sizeof(dev_ident), &dev_ident);
+		update(block);
+
+	} else if (block == EE_BLOCK_PEER_DEV) {												// peer devices are unknown, remove all peers
+		peer_pool.clear_all();
+		peer_dev.clear_all();
+		peer_pool.init();
+
+	} else {																				// list0/1 of the channel from PROGMEM
+		uint8_t cnl = block - EE_BLOCK_LIST;
+		cmm[cnl]->lstC.load_default();
+		cmm[cnl]->lstC.save_list();
+		inform_config_change(cnl);
+	}
+	return 0;
+}
+
+uint8_t s_ee_check::calc_rec(uint16_t addr, uint8_t len) {
+	return ee_block_crc(0xffff, addr, len) & 0xff;
+}
+
+void s_ee_check::update_rec(uint16_t addr, uint8_t len) {
+	uint8_t crc = calc_rec(addr, len);
+	set_eeprom(addr + len, 1, &crc);
+	set_verified(peer_pool.get_rec_nr(addr), 0);
+}
+
+/* force is set by poll(), load_list() skips the crc of a record which was verified since its last write */
+uint8_t s_ee_check::verify_rec(uint16_t addr, uint8_t cnl, uint8_t force) {
+	s_list_table *list = &cmm[cnl]->lstP;
+	uint8_t nr = peer_pool.get_rec_nr(addr);
+	if ((!force) && (nr < ee_check_rec_cnt) && (ee_check_rec[nr >> 3] & (1 << (nr & 7)))) return 1;
+
+	uint8_t crc;
+	get_eeprom(addr + 3 + list->len, 1, &crc);
+	if (crc == calc_rec(addr, 3 + list->len)) {
+		set_verified(nr, 1);
+		return 1;
+	}
+
+	error = 1;
+	DBG(CM, F("CMX:EE_CHECK- cnl:"), cnl, F(", rec:"), addr, F(" corrupted\n"));
+
+	for (uint8_t i = 0; i < list->len; i++) {												// list3/4 from PROGMEM, the value array could be in use
+		uint8_t b = _PGM_BYTE(list->def[i]);
+		set_eeprom(addr + 3 + i, 1, &b);
+	}
+	update_rec(addr, 3 + list->len);
+	return 0;
+}
+
+void s_ee_check::set_verified(uint8_t nr, uint8_t value) {
+	if (nr >= ee_check_rec_cnt) return;														// unknown record or more records than expected
+	if (value) ee_check_rec[nr >> 3] |= 1 << (nr & 7);
+	else ee_check_rec[nr >> 3] &= ~(1 << (nr & 7));
+}
+
+void s_ee_check::clear_verified(void) {
+	memset(ee_check_rec, 0, (ee_check_rec_cnt + 7) / 8);
+}
+
+void s_ee_check::update_addr(uint16_t addr) {
+	for (uint8_t i = 0; i < cnl_max; i++) {													// list0/1 of a channel
+		s_list_table *list = &cmm[i]->lstC;
+		if ((addr >= list->ee_addr) && (addr < list->ee_addr + list->len)) {
+			update(EE_BLOCK_LIST + i);
+			return;
+		}
+	}
+	uint8_t cnl;
+	for (uint16_t rec = peer_pool.ee_addr; rec < peer_pool.ee_addr + peer_pool.used; rec += peer_pool.get_rec_len(cnl)) {
+		get_eeprom(rec, 1, &cnl);															// or a record in the peer pool
+		if (!peer_pool.is_rec_cnl(cnl)) return;
+		if ((addr >= rec) && (addr < rec + peer_pool.get_rec_len(cnl))) {
+			update_rec(rec, peer_pool.get_rec_len(cnl) - 1);
+			return;
+		}
+	}
+}
+
+/* checks one block per call, fixed blocks first, followed by the records in the peer pool */
+void s_ee_check::poll(void) {
+	if (!timer.done()) return;
+	timer.set(EE_CHECK_TIME);
+
+	uint8_t ok = 1;
+	if (next < EE_BLOCK_LIST + cnl_max) {
+		ok = verify(next++);
+
+	} else {
+		uint16_t rec = peer_pool.ee_addr, cnt = next - EE_BLOCK_LIST - cnl_max;
+		uint8_t cnl = 0;
+		while (rec < peer_pool.ee_addr + peer_pool.used) {									// search the record by its number
+			get_eeprom(rec, 1, &cnl);
+			if (!peer_pool.is_rec_cnl(cnl)) break;											// corrupted channel byte, the walk ends here
+			if (!cnt--) break;
+			rec += peer_pool.get_rec_len(cnl);
+		}
+		if (rec >= peer_pool.ee_addr + peer_pool.used) next = 0;							// all done, start from begin
+		else if (!peer_pool.is_rec_cnl(cnl)) {
+			ok = 0;
+			next = 0;
+		} else {
+			ok = verify_rec(rec, cnl, 1);
+			next++;
+		}
+	}
+	if (!ok) led.set(LED_STAT::EEPROM_ERROR);
+}
+
+/*
+* @brief Clears a device in the shared peer device table if it is not referenced by any channel anymore.
+* Called after a peer was removed from a channel.
+*/
+void peer_dev_release(uint8_t dev) {
+	if ((dev == 0xff) || (peer_pool.is_dev_used(dev))) return;								// unknown device or still in use
+	peer_dev.clear(dev);
+	DBG(CM, F("CMX:PEER_DEV_RELEASE- idx:"), dev, '\n');
+}
+
+/*
+* @brief Removing a peer moves the following slots of the channel one index down. A pending list answer, peer message
+* or config session of the channel is moved with them, the ones which are addressing the removed slot are cancelled.
+*/
+void peer_idx_release(CM_MASTER *pCM, uint8_t idx) {
+	s_list_msg *lm = &list_msg;
+	if ((lm->active == LIST_ANSWER::PARAM_RESPONSE_PAIRS) && (lm->list == &pCM->lstP)) {
+		if (lm->peer_idx == idx) lm->active = LIST_ANSWER::NONE;
+		else if (lm->peer_idx > idx) lm->peer_idx--;
+	}
+
+	s_peer_msg *pm = &peer_msg;
+	if ((pm->active) && (pm->peerDB == &pCM->peerDB)) {
+		for (uint8_t i = idx; i + 1 < pCM->peerDB.max; i++) {								// slot bits behind the removed one move down
+			if (pm->get_slot(i + 1)) pm->set_slot(i);
+			else pm->clear_slot(i);
+		}
+		pm->clear_slot(pCM->peerDB.max - 1);
+		if (pm->slot_cnt > idx) pm->slot_cnt--;
+	}
+
+	s_config_mode *cm = &config_mode;
+	if ((cm->active) && (cm->list == &pCM->lstP)) {
+		if (cm->idx_peer == idx) {															// session of the removed peer, no commit
+			cm->active = 0;
+			cm->stage_clear();
+		} else if (cm->idx_peer > idx) cm->idx_peer--;
+	}
+}
+
 /*
 * @brief Calculates and returns the crc number for all channel module lists.
 * This information is needed for the first time check. Within this check, we compare a stored
@@ -450,9 +881,8 @@ uint16_t crc16(uint16_t crc, uint8_t a) {
 }
 
 void inform_config_change(uint8_t channel) {
-	for (uint8_t i = 0; i < cnl_max; i++) {
-		cmm[i]->info_config_change(channel);												// inform the channel module on a change of list0 or 1
-	}
+	cm_call_config_change(channel);															// inform the channel modules on a change of list0 or 1
+	for (uint8_t i = 0; i < cnl_max; i++) sched.set_cnl(i);									// and give them a poll to adapt
 }
 //-------------------------------------------------------------------------------------------------------------------------
 
@@ -11,8 +11,29 @@
 #define _CM_MASTER_H
 
 #include "HAL.h"
-#include "as_type_defs.h"
+#include "AS_type_defs.h"
+
+/*
+* @brief Remove the double slash to compose the channel modules at compile time instead of calling them through the
+*        virtual functions of CM_MASTER. The channel modules are listed in the user sketch as a CM_DEVICE type and
+*        CM_STATIC_DISPATCH(type) creates the cm_call_ functions, see at the end of this file. Channel iteration is then
+*        unrolled and every call goes directly to the function of the respective channel module class.
+*        Saves per channel module class a vtable in RAM and a vtable pointer per instance, and the linker can drop the
+*        CM_MASTER functions a device doesn't use. Host build, 4 channels: text -5.6k, data -248, bss -128 byte, no
+*        measurable change of the call time. AVR numbers are not measured yet, see CONFIGS in bench/Makefile.
+*        CM_STATIC changes the CM_MASTER class, so library and sketch have to be compiled with the same setting. A
+*        #define in the .ino doesn't reach the library sources, so either remove the double slash here or hand it over
+*        as build flag: platformio.ini build_flags = -DCM_STATIC, arduino-cli compile --build-property
+*        compiler.cpp.extra_flags=-DCM_STATIC, host/Makefile make DEFINES=-DCM_STATIC. A mismatch doesn't link, the
+*        cm_call_ functions are then missing or defined twice.
+*/
+//#define CM_STATIC
 
+#ifdef CM_STATIC
+#define CM_VIRTUAL
+#else
+#define CM_VIRTUAL  virtual
+#endif
 
 
 namespace STA_INFO {
@@ -52,21 +73,20 @@ public://-----------------------------------------------------------------------
 	CM_MASTER(const uint8_t peer_max);														// constructor
 
 	void init(void);																		// init function, called after AS initialisation
-	void poll(void);																		// poll function, driven by HM loop
 
 
-	virtual void cm_init(void);																// init function for channel modules to overwrite
-	virtual void cm_poll(void);																// poll function for channel modules to overwrite
+	CM_VIRTUAL void cm_init(void);															// init function for channel modules to overwrite
+	CM_VIRTUAL void cm_poll(void);															// poll function for channel modules to overwrite
 
-	virtual void info_config_change(uint8_t channel);										// list1 on registered channel had changed
-	virtual void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
+	CM_VIRTUAL void info_config_change(uint8_t channel);									// list1 on registered channel had changed
+	CM_VIRTUAL void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
 
 	/* virtual declaration for cmRemote channel module. make pin configuration and button event accessible */
 	//virtual void cm_init_pin(uint8_t PINBIT, volatile uint8_t *DDREG, volatile uint8_t *PORTREG, volatile uint8_t *PINREG, uint8_t PCINR, uint8_t PCIBYTE, volatile uint8_t *PCICREG, volatile uint8_t *PCIMASK, uint8_t PCIEREG, uint8_t VEC) {}
-	virtual void button_action(uint8_t event);
+	CM_VIRTUAL void button_action(uint8_t event);
 
-	virtual void instruction_msg(MSG_TYPE::E type, uint8_t *buf);							// consolidation of ~10 virtual function definitions
-	virtual void peer_action_msg(MSG_TYPE::E type, uint8_t *buf);							// consolidation of ~10 virtual function definitions
+	CM_VIRTUAL void instruction_msg(MSG_TYPE::E type, uint8_t *buf);						// consolidation of ~10 virtual function definitions
+	CM_VIRTUAL void peer_action_msg(MSG_TYPE::E type, uint8_t *buf);						// consolidation of ~10 virtual function definitions
 
 
 
@@ -163,12 +183,192 @@ public://-----------------------------------------------------------------------
 void process_send_status_poll(s_cm_status *cm, uint8_t cnl);								// helper function to send status messages
 
 uint16_t cm_prep_default(uint16_t ee_start_addr);											// prepare the defaults incl eeprom address mapping
+void peer_dev_release(uint8_t dev);															// clear a peer device which is not used by any channel
+void peer_idx_release(CM_MASTER *pCM, uint8_t idx);											// follow the moved slots of a removed peer in pending jobs
+void pool_move(uint16_t hole, uint8_t len, uint16_t end, uint8_t slot);						// journaled compaction of the peer pool
+uint8_t pool_move_crc(uint16_t hole, uint8_t len);											// crc of a pool move marker
 
 uint16_t cm_calc_crc(void);																	// calculate the crc for lists in the modules
 uint16_t crc16_P(uint16_t crc, uint8_t len, const uint8_t *buf);							// calculates the crc for a PROGMEM byte array
 uint16_t crc16(uint16_t crc, uint8_t a);													// calculates the crc for a given byte
 
+/* config journal, a commit of a config session is written here first, see process_config_commit() */
+struct s_cm_journal_hdr {
+	uint8_t  len;																			// length of the content, 0 if the journal is empty
+	uint16_t addr;																			// target address of the content
+	uint16_t crc;																			// crc over addr, len and content
+};
+
+void process_config_commit(void);															// commit the staged config session
+void cm_journal_recover(void);																// finish an interrupted commit on startup
+void cm_journal_clear(void);																// invalidate the journal, first time start
+uint16_t cm_journal_crc(uint16_t addr, uint8_t len, uint8_t *buf);							// crc of a journal entry
+
+/*
+* @brief Compile time description of a channel module, needed to calculate the eeprom layout and the magic crc
+* by the compiler instead of walking through all list definitions on every start. The array of descriptions has to
+* be defined in the user sketch in the same order as cmm[], list arrays referenced here need to be constexpr.
+* A line is taken from the channel module type, e.g. CM_DIMMER::cm_def_c(peer_max), the instance gets its peer_max
+* by CM_PEER_MAX(type, cnl) - the compiler stops there if cm_def[cnl] does not describe the type.
+* CM_DEF_C describes a channel without peer list (cm_maintenance), CM_DEF a channel with lstC and lstP.
+*/
+struct s_cm_def {
+	const uint8_t *c_reg;																	// lstC register and defaults
+	const uint8_t *c_def;
+	uint8_t c_len;
+	const uint8_t *p_reg;																	// lstP register and defaults, 0 if not available
+	const uint8_t *p_def;
+	uint8_t p_len;
+	uint8_t peer_max;																		// amount of possible peers
+};
+#define CM_DEF_C(c_reg, c_def, peer_max)               { c_reg, c_def, sizeof(c_reg), 0, 0, 0, peer_max }
+#define CM_DEF(c_reg, c_def, p_reg, p_def, peer_max)   { c_reg, c_def, sizeof(c_reg), p_reg, p_def, sizeof(p_reg), peer_max }
+#define CM_DEF_CNT(cm_def)                             (sizeof(cm_def) / sizeof(s_cm_def))
+
+/* same lists in both descriptions, peer_max is not compared */
+constexpr uint8_t cm_def_same_c(const s_cm_def &a, const s_cm_def &b) {
+	return (a.c_reg == b.c_reg) && (a.c_def == b.c_def) && (a.c_len == b.c_len) && (a.p_reg == b.p_reg) && (a.p_def == b.p_def) && (a.p_len == b.p_len);
+}
+
+/* in the class declaration of a channel module with lstC and lstP, its line of cm_def[] and the check of it */
+#define CM_DEF_TYPE(c_reg, c_def, p_reg, p_def) \
+	static constexpr s_cm_def cm_def_c(uint8_t peer_max) { return CM_DEF(c_reg, c_def, p_reg, p_def, peer_max); } \
+	static constexpr uint8_t cm_def_fits(const s_cm_def &def) { return cm_def_same_c(def, cm_def_c(def.peer_max)); }
+
+/* peer_max of a channel module instance taken from cm_def[] in the user sketch, evaluated by the compiler as template
+*  argument, a line which does not fit to the type ends in the call of a function which is not constexpr */
+uint8_t cm_def_does_not_fit_the_channel_module(void);										// not defined, see CM_PEER_MAX()
+template <typename T> constexpr uint8_t cm_peer_max_c(const s_cm_def &def) {
+	return (T::cm_def_fits(def)) ? def.peer_max : cm_def_does_not_fit_the_channel_module();
+}
+template <uint8_t V> struct s_cm_peer_max {
+	static const uint8_t value = V;
+};
+#define CM_PEER_MAX(type, cnl)                         s_cm_peer_max<cm_peer_max_c<type>(cm_def[cnl])>::value
+
+/* constexpr versions of crc16 and crc16_P, same polynom and start value, C++11 allows only a single return statement */
+constexpr uint16_t crc16_bit_c(uint16_t crc, uint8_t bits) {
+	return (bits) ? crc16_bit_c((crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1), bits - 1) : crc;
+}
+constexpr uint16_t crc16_c(uint16_t crc, uint8_t a) {
+	return crc16_bit_c(crc ^ a, 8);
+}
+constexpr uint16_t crc16_P_c(uint16_t crc, uint8_t len, const uint8_t *buf) {
+	return (len) ? crc16_P_c(crc16_c(crc, *buf), len - 1, buf + 1) : crc;
+}
+
+/* crc of a single list, registers, defaults and the amount of peers - same sequence as in cm_calc_crc() */
+constexpr uint16_t cm_list_crc_c(uint16_t crc, const uint8_t *reg, const uint8_t *def, uint8_t len, uint8_t peer_max) {
+	return crc16_c(crc16_P_c(crc16_P_c(crc, len, reg), len, def), peer_max);
+}
+
+/* magic crc over all channel modules, lstC is always a lower list number than lstP */
+constexpr uint16_t cm_layout_crc_c(const s_cm_def *cm, uint8_t cnt, uint16_t crc = 0) {
+	return (cnt) ? cm_layout_crc_c(cm + 1, cnt - 1, (cm->p_len) ?
+		cm_list_crc_c(cm_list_crc_c(crc, cm->c_reg, cm->c_def, cm->c_len, cm->peer_max), cm->p_reg, cm->p_def, cm->p_len, cm->peer_max) :
+		cm_list_crc_c(crc, cm->c_reg, cm->c_def, cm->c_len, cm->peer_max)) : crc;
+}
+
+/* biggest list, needed for the size of the config journal and the config stage */
+constexpr uint8_t cm_journal_max_c(const s_cm_def *cm, uint8_t cnt, uint8_t max = 0) {
+	return (cnt) ? cm_journal_max_c(cm + 1, cnt - 1, (cm->c_len > max) ? ((cm->p_len > cm->c_len) ? cm->p_len : cm->c_len) : ((cm->p_len > max) ? cm->p_len : max)) : max;
+}
+
+/* eeprom space needed by the channel modules, lstC per channel, the peer pool and its move markers, the peer device
+*  table with 3 byte per device, the config journal and the crc table, the same order as cm_prep_default() - add
+*  sizeof(s_dev_ident) for the start address and as_ring_size of the ring stores. Peers and list3/4 are taking their space
+*  from the pool */
+constexpr uint16_t cm_lists_size_c(const s_cm_def *cm, uint8_t cnt) {
+	return (cnt) ? cm->c_len + cm_lists_size_c(cm + 1, cnt - 1) : 0;
+}
+constexpr uint16_t cm_layout_size_c(const s_cm_def *cm, uint8_t cnt, uint8_t dev_max, uint16_t pool_size) {
+	return cm_lists_size_c(cm, cnt) + pool_size + 2 * sizeof(s_pool_move) + dev_max * 3 + sizeof(s_cm_journal_hdr) + cm_journal_max_c(cm, cnt) + (EE_BLOCK_LIST + cnt) * 2;
+}
+
+/* amount of peers of all channels, the most records the peer pool can hold, to size ee_check_rec[] in the user sketch */
+constexpr uint16_t cm_peer_cnt_c(const s_cm_def *cm, uint8_t cnt) {
+	return (cnt) ? ((cm->p_len) ? cm->peer_max : 0) + cm_peer_cnt_c(cm + 1, cnt - 1) : 0;
+}
+
+/* space of one peer in the pool, record header, list3/4 and crc, to size peer_pool_size in the user sketch */
+#define CM_POOL_REC(p_reg)                             (4 + sizeof(p_reg))
+
 void inform_config_change(uint8_t channel);													// inform all channel modules that a list0/1 had changed
+
+
+/*
+* @brief Calls into the channel modules, the library uses only these functions. With virtual channel modules they are
+* forwarded via cmm[], with CM_STATIC they are created by CM_STATIC_DISPATCH() in the user sketch.
+* cm_call_poll() polls only the channels flagged in sched_cnl[], the flag is taken before cm_poll() is called. A channel
+* module has to flag itself again in cm_poll() as long as it has work to do (state machine, status to send, armed timer).
+* Channels are flagged by the library on init, on a config change, on a message to the channel and on a pin change.
+*/
+extern CM_MASTER *cmm[];
+extern uint8_t cnl_max;
+
+#ifdef CM_STATIC
+void cm_call_init(uint8_t cnl);
+void cm_call_poll(void);																	// poll the flagged channel modules
+void cm_call_config_change(uint8_t channel);												// inform all channel modules
+void cm_call_peer_defaults(uint8_t cnl, uint8_t idx, s_m01xx01 *buf);
+void cm_call_instruction(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf);
+void cm_call_peer_action(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf);
+
+#else
+inline void cm_call_init(uint8_t cnl) { cmm[cnl]->cm_init(); }
+void cm_call_poll(void);																	// poll the flagged channel modules
+inline void cm_call_config_change(uint8_t channel) { for (uint8_t i = 0; i < cnl_max; i++) cmm[i]->info_config_change(channel); }
+inline void cm_call_peer_defaults(uint8_t cnl, uint8_t idx, s_m01xx01 *buf) { cmm[cnl]->request_peer_defaults(idx, buf); }
+inline void cm_call_instruction(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { cmm[cnl]->instruction_msg(type, buf); }
+inline void cm_call_peer_action(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { cmm[cnl]->peer_action_msg(type, buf); }
+#endif
+
+/*
+* @brief Compile time composition of the channel modules, needed for CM_STATIC. CM_CNL() takes a channel module instance
+* of the user sketch, CM_DEVICE holds them in the same order as cmm[]. The recursion resolves the channel number at
+* compile time, loops over all channels are unrolled and the calls are going to the class of the instance, not to a vtable.
+* button_action() is not listed as it is called by the channel module itself.
+*
+* CM_MAINTENANCE cm_maintenance(0);
+* CM_DIMMER cm_dimmer1(5, 0, 0);
+* CM_MASTER *cmm[2] = { &cm_maintenance, &cm_dimmer1, };
+* typedef CM_DEVICE<CM_CNL(cm_maintenance), CM_CNL(cm_dimmer1)> cm_device;
+* CM_STATIC_DISPATCH(cm_device);
+*/
+template <typename T, T &M> struct s_cm_cnl {
+	static T &cm(void) { return M; }
+};
+#define CM_CNL(instance)                               s_cm_cnl<decltype(instance), instance>
+
+template <uint8_t I, typename... C> struct s_cm_chain {
+	static void init(uint8_t) {}
+	static void poll(void) {}
+	static void config_change(uint8_t) {}
+	static void peer_defaults(uint8_t, uint8_t, s_m01xx01 *) {}
+	static void instruction(uint8_t, MSG_TYPE::E, uint8_t *) {}
+	static void peer_action(uint8_t, MSG_TYPE::E, uint8_t *) {}
+};
+
+template <uint8_t I, typename C, typename... N> struct s_cm_chain<I, C, N...> {
+	typedef s_cm_chain<I + 1, N...> next;
+	static void init(uint8_t cnl) { if (cnl == I) C::cm().cm_init(); else next::init(cnl); }
+	static void poll(void) { if (sched.take_cnl(I)) PRF(s_prf::cnl_stage(I), NRG(s_nrg::cnl_ctx(I), C::cm().cm_poll())); next::poll(); }
+	static void config_change(uint8_t channel) { C::cm().info_config_change(channel); next::config_change(channel); }
+	static void peer_defaults(uint8_t cnl, uint8_t idx, s_m01xx01 *buf) { if (cnl == I) C::cm().request_peer_defaults(idx, buf); else next::peer_defaults(cnl, idx, buf); }
+	static void instruction(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { if (cnl == I) C::cm().instruction_msg(type, buf); else next::instruction(cnl, type, buf); }
+	static void peer_action(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { if (cnl == I) C::cm().peer_action_msg(type, buf); else next::peer_action(cnl, type, buf); }
+};
+
+template <typename... C> using CM_DEVICE = s_cm_chain<0, C...>;
+
+#define CM_STATIC_DISPATCH(device) \
+	void cm_call_init(uint8_t cnl) { device::init(cnl); } \
+	void cm_call_poll(void) { device::poll(); } \
+	void cm_call_config_change(uint8_t channel) { device::config_change(channel); } \
+	void cm_call_peer_defaults(uint8_t cnl, uint8_t idx, s_m01xx01 *buf) { device::peer_defaults(cnl, idx, buf); } \
+	void cm_call_instruction(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { device::instruction(cnl, type, buf); } \
+	void cm_call_peer_action(uint8_t cnl, MSG_TYPE::E type, uint8_t *buf) { device::peer_action(cnl, type, buf); }
+
 //- -----------------------------------------------------------------------------------------------------------------------
 
 
@@ -74,6 +74,7 @@ void CM_REMOTE::cm_init() {
 	if (button_check.configured) {
 		register_PCINT(def_key);															// register the pin interrupt
 		button_ref.status = check_PCINT(def_key, 0);										// get the latest information
+		button_check.level = button_ref.status & 1;											// an edge 2 ends in 0, 3 in 1
 		DBG(RE, F("pin:"), def_key);
 
 	} else {
@@ -95,6 +96,11 @@ void CM_REMOTE::cm_poll(void) {
 	if (!button_check.configured) return;													// if port is not configured, poll makes no sense
 	button_ref.status = check_PCINT(def_key, 1);											// check if an interrupt had happened
 
+	/* stay in the poll while a pin change is debounced or the button is armed, otherwise the pin change interrupt
+	*  flags the channel again, see AS::poll() */
+	if (button_ref.status > 1) button_check.level = button_ref.status & 1;					// an edge 2 ends in 0, 3 in 1
+	sched.mark_cnl(lstC.cnl, (button_ref.status != button_check.level) || (button_check.armed));
+
 	/* button was just pressed, start for every option */
 	if (button_ref.status == 2) {
 		timer.set(byteTimeCvt(l1->LONG_PRESS_TIME));										// set timer to detect a long
@@ -141,9 +147,7 @@ void CM_REMOTE::cm_poll(void) {
 	
 	/* button is not pressed for a longer time, clean up */
 	if (button_ref.status == 1) {	
-		button_check = {};
-		button_check.configured = 1;
-		//button_check.armed = button_check.last_long = button_check.last_short = 0;
+		button_check.armed = button_check.last_long = button_check.last_short = 0;			// configured and level stay
 		DBG(RE, F("RE"), lstC.cnl, F(":CM_POLL-\t\treleased, timeout "), _TIME, '\n');
 	}
 }
@@ -12,11 +12,11 @@
 #include "cm_master.h"
 
 
-const uint8_t cm_remote_ChnlReg[] PROGMEM = { 0x04,0x08,0x09, };
-const uint8_t cm_remote_ChnlDef[] PROGMEM = { 0x40,0x00,0x00, };
+constexpr uint8_t cm_remote_ChnlReg[] PROGMEM = { 0x04,0x08,0x09, };
+constexpr uint8_t cm_remote_ChnlDef[] PROGMEM = { 0x40,0x00,0x00, };
 
-const uint8_t cm_remote_PeerReg[] PROGMEM = { 0x01, };
-const uint8_t cm_remote_PeerDef[] PROGMEM = { 0x00, };
+constexpr uint8_t cm_remote_PeerReg[] PROGMEM = { 0x01, };
+constexpr uint8_t cm_remote_PeerDef[] PROGMEM = { 0x00, };
 
 
 class CM_REMOTE : public CM_MASTER {
@@ -49,7 +49,8 @@ private:  //--------------------------------------------------------------------
 		uint8_t armed            : 1;														// if this is set to 1, poll function should be entered
 		uint8_t last_short       : 1;														// if the last key press was a short to detect a double short
 		uint8_t last_long        : 1;														// if the last keypress was a long to detect a double long
-	    uint8_t                  : 4;
+		uint8_t level            : 1;														// debounced pin level, 0 pressed, 1 released
+	    uint8_t                  : 3;
 	} button_check;
 	
 	struct s_button_ref {
@@ -69,11 +70,12 @@ public:  //---------------------------------------------------------------------
 
 	CM_REMOTE(const uint8_t peer_max, uint8_t pin_key);										// constructor
 	CM_REMOTE(const uint8_t peer_max);														// constructor, without pin
-	virtual void cm_init();																	// overwrite the init function in cmMaster
+	CM_DEF_TYPE(cm_remote_ChnlReg, cm_remote_ChnlDef, cm_remote_PeerReg, cm_remote_PeerDef);	// line of cm_def[] in the user sketch
+	CM_VIRTUAL void cm_init();																// overwrite the init function in cmMaster
 
-	virtual void cm_poll(void);																// poll function, driven by HM loop
+	CM_VIRTUAL void cm_poll(void);															// poll function, driven by HM loop
 
-	virtual void button_action(uint8_t event);
+	CM_VIRTUAL void button_action(uint8_t event);
 
 };
 
@@ -76,6 +76,8 @@ void cm_switch::adjustStatus(void) {
 }
 
 void cm_switch::cm_poll(void) {
+	/* stay in the poll while something is running or to send, a change in this poll is followed by one more poll */
+	sched.mark_cnl(lstC.cnl, (cms.msg_type) || (cms.value != cms.set_value) || (!cms.sm_delay.done()) || (tr11.active) || (tr40.cur != tr40.nxt));
 
 	process_send_status_poll(&cms, lstC.cnl);											// check if there is some status to send, function call in cmMaster.cpp
 	adjustStatus();																			// check if something is to be set on the Relay channel
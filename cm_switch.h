@@ -12,11 +12,11 @@
 #include "cm_master.h"
 
 
-const uint8_t cm_switch_ChnlReg[] PROGMEM = { 0x08, };
-const uint8_t cm_switch_ChnlDef[] PROGMEM = { 0x00, };
+constexpr uint8_t cm_switch_ChnlReg[] PROGMEM = { 0x08, };
+constexpr uint8_t cm_switch_ChnlDef[] PROGMEM = { 0x00, };
 
-const uint8_t cm_switch_PeerReg[] PROGMEM = { 0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c, };
-const uint8_t cm_switch_PeerDef[] PROGMEM = { 0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x01,0x44,0x44,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x21,0x44,0x44, };
+constexpr uint8_t cm_switch_PeerReg[] PROGMEM = { 0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c, };
+constexpr uint8_t cm_switch_PeerDef[] PROGMEM = { 0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x01,0x44,0x44,0x00,0x00,0x32,0x64,0x00,0xff,0x00,0xff,0x21,0x44,0x44, };
 
 
 #define NOT_USED 255
@@ -107,6 +107,7 @@ private:  //--------------------------------------------------------------------
 public:  //----------------------------------------------------------------------------------------------------------------
 
 	cm_switch(const uint8_t peer_max);														// constructor
+	CM_DEF_TYPE(cm_switch_ChnlReg, cm_switch_ChnlDef, cm_switch_PeerReg, cm_switch_PeerDef);	// line of cm_def[] in the user sketch
 
 	struct s_tr11 {
 		uint8_t  active;																	// trigger 11 active
@@ -125,9 +126,9 @@ public:  //---------------------------------------------------------------------
 
 	inline void adjustStatus(void);															// setting of relay status
 
-	virtual void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
+	CM_VIRTUAL void request_peer_defaults(uint8_t idx, s_m01xx01 *buf);						// add peer channel defaults to list3/4
 
-	virtual void cm_poll(void);																// poll function, driven by HM loop
+	CM_VIRTUAL void cm_poll(void);															// poll function, driven by HM loop
 	virtual void set_toggle(void);															// toggle the module initiated by config button
 
 	/* receive functions to handle requests forwarded by AS:processMessage
@@ -1,8 +1,6 @@
 #ifndef _REGISTER_H
 #define _REGISTER_H
 
-static waittimer *timer_array[25];
-
 /*
 *  @brief libraries needed to run AskSin library, everything is defined within the newasksin.h file
 */
@@ -14,7 +12,7 @@ static waittimer *timer_array[25];
 *  @brief definition of all classes which are necassary to run asksin
 */
 //NO_AES as_aes;														//   60 byte flash,  69 byte sram
-HAS_AES as_aes;															// 2826 byte flash, 277 byte sram
+HAS_AES as_aes;															// 2826 byte flash, 461 byte sram
 AES *aes = &as_aes;
 	
 CC1101 as_cc1101(pinB3, pinB2, pinB1, pinB0, pinB5);					//  546 byte flash, 124 byte sram; sparkfun micro(32U4)
@@ -22,6 +20,12 @@ CC1101 as_cc1101(pinB3, pinB2, pinB1, pinB0, pinB5);					//  546 byte flash, 124
 //CC1101 as_cc1101(pinB4, pinB3, pinB5, pinB2, pinD2);					//  546 byte flash, 124 byte sram; atmega328
 COM *com = &as_cc1101;
 
+const uint16_t as_eeprom_size = int_eeprom_size;						// capacity of the backend below, 8192 for the 24C64 or FM25CL64
+INT_EEP as_eeprom;														// internal eeprom
+//I2C_EEP as_eeprom(0x50, as_eeprom_size, 32);							// 24C64 on i2c address 0x50, 32 byte pages
+//SPI_FRAM as_eeprom(pinD7, as_eeprom_size);							// FM25CL64 with chip select on pinD7
+EEP *eep = &as_eeprom;
+
 NO_BAT as_bat;															//   34 byte flash,  22 byte sram
 //INT_BAT as_bat(3600000, 30);											//  176 byte flash,  22 byte sram
 //EXT_BAT as_bat(3600000, 30, pinD7, pinC6, 10, 45);					//  386 byte flash,  56 byte sram
@@ -34,25 +38,37 @@ LED led(pinF4, pinF5);													//  150 byte flash,  51 byte sram; sparkfun m
 //LED led(pinF5, pinF6);												//  150 byte flash,  51 byte sram; radino(32U4)
 //LED led(pinD6, pinD4);												//  150 byte flash,  51 byte sram; atmega328
 
-POM pom(0);
+POM pom(POWER_MODE_NO_SLEEP);
 
 
 /*
 *  @brief cm_maintenance requires this declaration in the user sketch to make registers flexible
 */
-const uint8_t cm_maintenance_ChnlReg[] PROGMEM = { 0x02,0x08,0x0a,0x0b,0x0c,0x15,0x18,0x1E,0x71, };
-const uint8_t cm_maintenance_ChnlDef[] PROGMEM = { 0x80,0x00,0x00,0x00,0x00,0xFF,0x00,0x01,0x84, };
+constexpr uint8_t cm_maintenance_ChnlReg[] PROGMEM = { 0x02,0x08,0x0a,0x0b,0x0c,0x15,0x18,0x1E,0x71, };
+constexpr uint8_t cm_maintenance_ChnlDef[] PROGMEM = { 0x80,0x00,0x00,0x00,0x00,0xFF,0x00,0x01,0x84, };
 uint8_t cm_maintenance_ChnlVal[sizeof(cm_maintenance_ChnlReg)];
 const uint8_t cm_maintenance_ChnlLen = sizeof(cm_maintenance_ChnlReg);
 
 
 /*
-*  @brief definition of the device functionallity per channel
+*  @brief description of the channel modules, one line per channel module in the same order as cmm[], taken from
+*  the type of the channel module, peer_max is the limit of peers per channel
+*/
+constexpr s_cm_def cm_def[] PROGMEM = {
+	CM_MAINTENANCE::cm_def_c(0),
+	CM_DIMMER::cm_def_c(5),
+	CM_DIMMER::cm_def_c(2),
+	CM_DIMMER::cm_def_c(1),
+};
+
+
+/*
+*  @brief definition of the device functionallity per channel, peer_max is taken from cm_def[] above
 */
-CM_MAINTENANCE cm_maintenance(0);								//   24 byte flash, 124 byte sram
-CM_DIMMER cm_dimmer1(5, 0, 0);									// 7332 byte flash, 330 byte sram - further 256 byte flash, 173 byte sram
-CM_DIMMER cm_dimmer2(2, 1, 0);
-CM_DIMMER cm_dimmer3(1, 2, 0);
+CM_MAINTENANCE cm_maintenance(CM_PEER_MAX(CM_MAINTENANCE, 0));	//   24 byte flash, 124 byte sram
+CM_DIMMER cm_dimmer1(CM_PEER_MAX(CM_DIMMER, 1), 0, 0);			// 7332 byte flash, 330 byte sram - further 256 byte flash, 173 byte sram
+CM_DIMMER cm_dimmer2(CM_PEER_MAX(CM_DIMMER, 2), 1, 0);
+CM_DIMMER cm_dimmer3(CM_PEER_MAX(CM_DIMMER, 3), 2, 0);
 
 CM_MASTER *cmm[4] = {
 	&cm_maintenance,
@@ -60,6 +76,50 @@ CM_MASTER *cmm[4] = {
 	&cm_dimmer2,
 	&cm_dimmer3,
 };
+static_assert(CM_DEF_CNT(cm_def) == sizeof(cmm) / sizeof(cmm[0]), "cm_def[] needs one line per channel module of cmm[]");
+
+/*
+*  @brief compile time composition of the channel modules, used if CM_STATIC is defined in cm_master.h or as build flag, same order as cmm[]
+*/
+#ifdef CM_STATIC
+typedef CM_DEVICE<CM_CNL(cm_maintenance), CM_CNL(cm_dimmer1), CM_CNL(cm_dimmer2), CM_CNL(cm_dimmer3)> cm_device;
+CM_STATIC_DISPATCH(cm_device);
+#endif
+
+
+/*
+*  @brief amount of different peer devices, the HMID of a peer device is stored only once for all channels
+*  peers and their list3/4 of all channels are sharing the peer pool, peer_max in cm_def[] is the limit per channel
+*/
+const uint8_t peer_dev_max = 8;
+const uint16_t peer_pool_size = 10 * CM_POOL_REC(cm_dimmer_PeerReg);
+
+
+/*
+*  @brief eeprom layout and magic crc of the channel modules, calculated by the compiler from cm_def[], the ring stores
+*  of the library are placed behind them
+*/
+const uint8_t cm_def_cnt = CM_DEF_CNT(cm_def);
+const uint16_t cm_layout_crc = cm_layout_crc_c(cm_def, CM_DEF_CNT(cm_def));
+static_assert(sizeof(s_dev_ident) + cm_layout_size_c(cm_def, CM_DEF_CNT(cm_def), peer_dev_max, peer_pool_size) + as_ring_size <= as_eeprom_size, "channel modules and ring stores do not fit into the eeprom");
+
+/*
+*  @brief staged values of a config session, sized by the biggest lstC/lstP of the channel modules
+*/
+const uint8_t config_stage_len = cm_journal_max_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t config_stage[CONFIG_STAGE_SIZE(config_stage_len)];
+
+/*
+*  @brief verified bit per record of the peer pool, the pool holds not more records than peers of all channels
+*/
+const uint8_t ee_check_rec_cnt = cm_peer_cnt_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t ee_check_rec[(ee_check_rec_cnt + 7) / 8];
+
+/*
+*  @brief pending work bit per channel module for the scheduler
+*/
+uint8_t sched_cnl[(CM_DEF_CNT(cm_def) + 7) / 8];
+
 
 
 /*
@@ -14,12 +14,18 @@
 *  @brief definition of all classes which are necassary to run asksin
 */
 //NO_AES as_aes;														//   60 byte flash,  69 byte sram
-HAS_AES as_aes;															// 2826 byte flash, 277 byte sram
+HAS_AES as_aes;															// 2826 byte flash, 461 byte sram
 AES *aes = &as_aes;
 
 CC1101 as_cc1101(pinB4, pinB3, pinB5, pinB2, pinD2);					//  546 byte flash, 124 byte sram
 COM *com = &as_cc1101;
 
+const uint16_t as_eeprom_size = int_eeprom_size;						// capacity of the backend below, 8192 for the 24C64 or FM25CL64
+INT_EEP as_eeprom;														// internal eeprom
+//I2C_EEP as_eeprom(0x50, as_eeprom_size, 32);							// 24C64 on i2c address 0x50, 32 byte pages
+//SPI_FRAM as_eeprom(pinD7, as_eeprom_size);							// FM25CL64 with chip select on pinD7
+EEP *eep = &as_eeprom;
+
 CBN as_cbn(1, pinB0);													//   80 byte flash,  25 byte sram
 CBN *cbn = &as_cbn;
 
@@ -38,22 +44,37 @@ POM *pom = &as_pom;
 /*
 *  @brief cm_maintenance requires this declaration in the user sketch to make registers flexible
 */
-const uint8_t cm_maintenance_ChnlReg[] PROGMEM = { 0x02,0x08,0x0a,0x0b,0x0c,0x12, };
-const uint8_t cm_maintenance_ChnlDef[] PROGMEM = { 0x80,0x01,0x00,0x00,0x00,0x69, };
+constexpr uint8_t cm_maintenance_ChnlReg[] PROGMEM = { 0x02,0x08,0x0a,0x0b,0x0c,0x12, };
+constexpr uint8_t cm_maintenance_ChnlDef[] PROGMEM = { 0x80,0x01,0x00,0x00,0x00,0x69, };
 uint8_t cm_maintenance_ChnlVal[sizeof(cm_maintenance_ChnlReg)];
 const uint8_t cm_maintenance_ChnlLen = sizeof(cm_maintenance_ChnlReg);
 
 
 /*
-*  @brief definition of the device functionallity per channel
+*  @brief description of the channel modules, one line per channel module in the same order as cmm[], taken from
+*  the type of the channel module, peer_max is the limit of peers per channel
+*/
+constexpr s_cm_def cm_def[] PROGMEM = {
+	CM_MAINTENANCE::cm_def_c(0),
+	CM_REMOTE::cm_def_c(10),
+	CM_REMOTE::cm_def_c(10),
+	CM_REMOTE::cm_def_c(10),
+	CM_REMOTE::cm_def_c(10),
+	CM_REMOTE::cm_def_c(10),
+	CM_REMOTE::cm_def_c(10),
+};
+
+
+/*
+*  @brief definition of the device functionallity per channel, peer_max is taken from cm_def[] above
 */
-CM_MAINTENANCE cm_maintenance(0);										//   24 byte flash, 124 byte sram
-CM_REMOTE cm_remote1(10, pinC0);										//  827 byte flash, 100 byte sram
-CM_REMOTE cm_remote2(10, pinC1);
-CM_REMOTE cm_remote3(10, pinC2);
-CM_REMOTE cm_remote4(10, pinC3);
-CM_REMOTE cm_remote5(10, pinC4);
-CM_REMOTE cm_remote6(10, pinC5); 
+CM_MAINTENANCE cm_maintenance(CM_PEER_MAX(CM_MAINTENANCE, 0));			//   24 byte flash, 124 byte sram
+CM_REMOTE cm_remote1(CM_PEER_MAX(CM_REMOTE, 1), pinC0);					//  827 byte flash, 100 byte sram
+CM_REMOTE cm_remote2(CM_PEER_MAX(CM_REMOTE, 2), pinC1);
+CM_REMOTE cm_remote3(CM_PEER_MAX(CM_REMOTE, 3), pinC2);
+CM_REMOTE cm_remote4(CM_PEER_MAX(CM_REMOTE, 4), pinC3);
+CM_REMOTE cm_remote5(CM_PEER_MAX(CM_REMOTE, 5), pinC4);
+CM_REMOTE cm_remote6(CM_PEER_MAX(CM_REMOTE, 6), pinC5);
 
 CM_MASTER *cmm[7] = {
 	&cm_maintenance,
@@ -64,6 +85,42 @@ CM_MASTER *cmm[7] = {
 	&cm_remote5,
 	&cm_remote6,
 };
+static_assert(CM_DEF_CNT(cm_def) == sizeof(cmm) / sizeof(cmm[0]), "cm_def[] needs one line per channel module of cmm[]");
+
+
+
+/*
+*  @brief amount of different peer devices, the HMID of a peer device is stored only once for all channels
+*  peers and their list3/4 of all channels are sharing the peer pool, peer_max in cm_def[] is the limit per channel
+*/
+const uint8_t peer_dev_max = 16;
+const uint16_t peer_pool_size = 40 * CM_POOL_REC(cm_remote_PeerReg);
+
+
+/*
+*  @brief eeprom layout and magic crc of the channel modules, calculated by the compiler from cm_def[], the ring stores
+*  of the library are placed behind them
+*/
+const uint8_t cm_def_cnt = CM_DEF_CNT(cm_def);
+const uint16_t cm_layout_crc = cm_layout_crc_c(cm_def, CM_DEF_CNT(cm_def));
+static_assert(sizeof(s_dev_ident) + cm_layout_size_c(cm_def, CM_DEF_CNT(cm_def), peer_dev_max, peer_pool_size) + as_ring_size <= as_eeprom_size, "channel modules and ring stores do not fit into the eeprom");
+
+/*
+*  @brief staged values of a config session, sized by the biggest lstC/lstP of the channel modules
+*/
+const uint8_t config_stage_len = cm_journal_max_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t config_stage[CONFIG_STAGE_SIZE(config_stage_len)];
+
+/*
+*  @brief verified bit per record of the peer pool, the pool holds not more records than peers of all channels
+*/
+const uint8_t ee_check_rec_cnt = cm_peer_cnt_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t ee_check_rec[(ee_check_rec_cnt + 7) / 8];
+
+/*
+*  @brief pending work bit per channel module for the scheduler
+*/
+uint8_t sched_cnl[(CM_DEF_CNT(cm_def) + 7) / 8];
 
 
 
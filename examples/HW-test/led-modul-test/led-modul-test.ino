@@ -21,6 +21,7 @@ void setup() {
 }
 
 void loop() {
+	snap_millis();																			// the led timer works on the loop snapshot, hm.poll() is not called here
 	led->poll();																			// poll the module
 
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+//- load library's --------------------------------------------------------------------------------------------------------
+#include <newasksin.h>																		// ask sin framework
+#include "waittimer.h"
+
+#define BENCH_CALLS    50000																// calls per measurement
+#define BENCH_TIMERS   24																	// done() calls in one loop of a typical device
+
+waittimer xtimer[BENCH_TIMERS];
+volatile uint32_t sink;																		// keeps the compiler from removing the reads
+
+
+void setup() {
+
+/* intent of this sketch is to measure what the loop snapshot of the millis timer saves.
+*  get_millis() needs an atomic block per call, get_loop_millis() reads the snapshot which AS::poll() takes once per loop.
+*  the timer itself is used for the measurement, so please check first with the timer-test sketch that it is working */
+	init_millis_timer0();																	// init and start the timer
+
+	_delay_ms(400);																			// some delay untill the usb port is settled
+	Serial.begin(57600);
+	dbg << F("\n\nthis is a test sketch of the Newasksin library to measure the loop snapshot of the millis timer...\n\n");
+
+	uint32_t fresh = bench_fresh();
+	uint32_t loop = bench_loop();
+	dbg << F("get_millis():      ") << fresh << F(" cycles per call\n");
+	dbg << F("get_loop_millis(): ") << loop << F(" cycles per call\n");
+
+	for (uint8_t i = 0; i < BENCH_TIMERS; i++) {											// arm the timers far in the future, done() has to compare the time
+		xtimer[i].set(3600000);
+	}
+	dbg << F("done() of ") << BENCH_TIMERS << F(" timers: ") << bench_timers() << F(" cycles, saved per loop: ") << (fresh - loop) * BENCH_TIMERS << F(" cycles\n");
+}
+
+void loop() {
+}
+
+
+/* - measure the calls against the millis timer, the result is in cpu cycles per call ------------------------------------
+*/
+uint32_t bench_fresh(void) {
+	uint32_t start = get_millis();
+	for (uint16_t i = 0; i < BENCH_CALLS; i++) {
+		sink = get_millis();
+	}
+	return (get_millis() - start) * (F_CPU / 1000) / BENCH_CALLS;
+}
+
+uint32_t bench_loop(void) {
+	uint32_t start = get_millis();
+	for (uint16_t i = 0; i < BENCH_CALLS; i++) {
+		sink = get_loop_millis();
+	}
+	return (get_millis() - start) * (F_CPU / 1000) / BENCH_CALLS;
+}
+
+uint32_t bench_timers(void) {
+	uint32_t start = get_millis();
+	for (uint16_t i = 0; i < BENCH_CALLS / BENCH_TIMERS; i++) {
+		snap_millis();																		// what AS::poll() does once per loop
+		for (uint8_t j = 0; j < BENCH_TIMERS; j++) {
+			sink = xtimer[j].done();
+		}
+	}
+	return (get_millis() - start) * (F_CPU / 1000) / (BENCH_CALLS / BENCH_TIMERS);
+}
@@ -28,6 +28,7 @@ void setup() {
 }
 
 void loop() {
+	snap_millis();																			// waittimer works on the loop snapshot, hm.poll() is not called here
 
 	if (loop_counter == 60) {
 		dbg << "x " << get_millis() << '\n';
@@ -0,0 +1,49 @@
+//- debug functionallity --------------------------------------------------------------------------------------------------
+#include "00_debug-flag.h"
+
+
+//- load library's --------------------------------------------------------------------------------------------------------
+#include <newasksin.h>																		// ask sin framework
+#include "register.h"																		// configuration sheet
+
+
+/*
+* the sketch of the host build, same as a .ino of the examples. the hardware setup is replaced by handing over the
+* cc1101 pins to the register model, the dimmer output is reported as '@<ms> pwm <cnl> <status>' line instead of
+* driving a timer.
+*/
+
+//- arduino functions -----------------------------------------------------------------------------------------------------
+void setup() {
+	// - Hardware setup ---------------------------------------
+	host_cc1101.attach(pinB2, pinB4, pinD2);												// csl, miso and gdo0 as in the CC1101 constructor
+
+	// - AskSin related ---------------------------------------
+	DBG_START(SER, F("HM_LC_Dim1PWM host\n"));
+	DBG(SER, F(LIB_VERSION_STRING));
+	init_millis_timer0();																	// init timer0
+	hm.init();																				// init the asksin framework
+}
+
+void loop() {
+	// - AskSin related ---------------------------------------
+	hm.poll();																				// poll the homematic main loop
+}
+
+
+//- user functions --------------------------------------------------------------------------------------------------------
+void CM_DIMMER::init_dimmer(uint8_t virtual_group, uint8_t virtual_channel, uint8_t channel) {
+	DBG(SER, F("initDim- vrt_grp: "), virtual_group, F(", vrt_cnl: "), virtual_channel, F(", cnl: "), channel, '\n');
+}
+
+void CM_DIMMER::switch_dimmer(uint8_t, uint8_t, uint8_t channel, uint8_t status, uint8_t) {
+	static uint8_t last[8];																	// status + 1 per channel, only changes are reported
+	if (last[channel & 7] == status + 1) return;
+	last[channel & 7] = status + 1;
+	dbg << '@' << get_millis() << F(" pwm ") << channel << ' ' << status << '\n';
+}
+
+/* power mode of the register model, set by the pom command of the host script */
+void host_set_power_mode(uint8_t mode) {
+	pom.setMode(mode);
+}
@@ -0,0 +1,316 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin host driver ----------------------------------------------------------------------------------------------------
+*  main() of the host build. runs setup() and loop() of host_device.cpp on the simulated hardware of HAL_host.cpp and
+*  plays the outside world from a script. everything happens in the virtual clock, a day of device time takes seconds.
+*
+*  usage: asksin_host [-e eeprom file] [-t run time ms] [-l loop time us] [-i hmid] [-n] [-r log file] [script file]
+*    -e  the internal eeprom is loaded from the file and written back, without it every run starts with a virgin eeprom
+*    -t  end of the run in ms of the virtual clock, default 60000
+*    -l  time which one loop() takes in the virtual clock, default 100us
+*    -i  HMID as 6 hex digits, taken over by firstTimeStart() in register.h instead of the one in HMSerialData
+*    -n  node of the radio medium in host_net.cpp, see below, there is no script then
+*    -r  replays a debug log of the examples instead of a script, see host_replay.cpp, the HMID is the one of the log
+*        device if there is no -i, the run ends after the last frame
+*
+*  script, one event per line: <time ms> <command> [parameter], +<ms> is relative to the event before, # is a comment
+*    rx <hex bytes>       frame for the device, decoded and with length byte like the m> lines of the debug output
+*    pin <B0..F7> <0|1>   drive an input pin, 'pin B0 0' presses the config button
+*    adc <value>          raw value of the ADC, 10 bit
+*    carrier <0|1>        carrier sense of the CC1101, a burst in the air
+*    ser <text>           characters for the serial console
+*    pom <mode>           power mode of the device, see POWER_MODE_* in as_power.h, 'ser p' prints the sleep statistics
+*    end                  end of the run
+*
+*  output is the serial output of the device, frames sent by the device are reported as '@<ms> tx <hex bytes>',
+*  received frames as '@<ms> rx <hex bytes>' and lost ones, while the CC1101 was not in RX mode, as '@<ms> lost'.
+*
+*  as node the device gets its commands from the medium on fd 3 and answers on fd 4, one line each:
+*    s <us>                   run till the virtual clock reaches us, answered with 'd', frames sent meanwhile are reported
+*                             before as 't <start us> <end us> <burst> <hex bytes>', start and end of the frame on the air
+*    r <id> <rssi> <hex>      frame at the antenna, answered with 'l <id>' if the CC1101 was not in RX mode
+*    p <B0..F7> <0|1>         drive an input pin
+*    c <0|1>                  carrier sense
+*    q                        end of the run
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include "HAL.h"
+#include "host_replay.h"
+
+#include <ctype.h>
+#include <time.h>
+
+
+void setup(void);
+void loop(void);
+void serialEventRun(void);																	// as_analyze.h, called by the arduino core after loop()
+void host_set_power_mode(uint8_t mode);														// host_device.cpp, pom command of the script
+
+
+/*-- script handling ------------------------------------------------------------------------------------------------------
+* the next event is read when the previous one was processed, so the script can be of any length
+*/
+static FILE    *script;
+static uint32_t ev_time;																	// time of the next event
+static char     ev_line[256];																// and the rest of the line
+static uint8_t  ev_valid;
+static uint8_t  quit;
+
+static FILE    *net_in, *net_out;															// commands of the medium and the answers, -n
+static uint8_t  replay;																		// -r
+static uint32_t loop_us = 100;
+
+static void print_hex(uint8_t *buf, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) printf(" %02X", buf[i]);
+}
+
+static uint8_t parse_hex(const char *str, uint8_t *buf, uint8_t max) {
+	uint8_t len = 0, nibble = 0, val = 0;
+	for (; *str && len < max; str++) {
+		if (!isxdigit((unsigned char)*str)) continue;										// spaces are optional
+		val = (val << 4) | (isdigit((unsigned char)*str) ? *str - '0' : (toupper((unsigned char)*str) - 'A' + 10));
+		if (++nibble == 2) {
+			buf[len++] = val;
+			nibble = val = 0;
+		}
+	}
+	return len;
+}
+
+static uint8_t parse_pin(const char *str) {
+	if ((str[0] == 'p') && (str[1] == 'i') && (str[2] == 'n')) str += 3;					// pinB0 or B0
+	char port = toupper((unsigned char)str[0]);
+	if ((port < 'B') || (port > 'F') || (str[1] < '0') || (str[1] > '7')) return 0xff;
+	return (port - 'B') * 8 + (str[1] - '0');
+}
+
+static void read_event(void) {
+	char line[sizeof(ev_line) + 16];
+	ev_valid = 0;
+	while ((script) && (fgets(line, sizeof(line), script))) {
+		char *str = line;
+		while (isspace((unsigned char)*str)) str++;
+		if ((!*str) || (*str == '#')) continue;
+
+		uint8_t relative = (*str == '+');
+		if (relative) str++;
+		char *end;
+		uint32_t time = strtoul(str, &end, 10);
+		ev_time = (relative) ? ev_time + time : time;
+
+		while (isspace((unsigned char)*end)) end++;
+		size_t len = strcspn(end, "\r\n");
+		end[len] = 0;
+		strncpy(ev_line, end, sizeof(ev_line) - 1);
+		ev_valid = 1;
+		return;
+	}
+}
+
+static void do_event(void) {
+	char cmd[16] = "";
+	int pos = 0;
+	sscanf(ev_line, "%15s %n", cmd, &pos);
+	const char *arg = ev_line + pos;
+
+	if (!strcmp(cmd, "rx")) {
+		uint8_t buf[64];
+		uint8_t len = parse_hex(arg, buf, sizeof(buf));
+		if ((!len) || (buf[0] + 1 != len)) {
+			printf("@%u script error, length byte doesn't fit: %s\n", get_millis(), ev_line);
+			return;
+		}
+		printf("@%u rx", get_millis()); print_hex(buf, len); printf("\n");
+		if (!host_cc1101.receive(buf, 0x20)) printf("@%u lost\n", get_millis());
+
+	} else if (!strcmp(cmd, "pin")) {
+		char name[8];
+		int level = 0;
+		uint8_t pin = (sscanf(arg, "%7s %d", name, &level) == 2) ? parse_pin(name) : 0xff;
+		if (pin == 0xff) printf("@%u script error, unknown pin: %s\n", get_millis(), ev_line);
+		else host_set_pin(pin, level);
+
+	} else if (!strcmp(cmd, "adc")) {
+		host_set_adc(atoi(arg));
+
+	} else if (!strcmp(cmd, "carrier")) {
+		host_cc1101.carrier = atoi(arg) ? 1 : 0;
+
+	} else if (!strcmp(cmd, "ser")) {
+		host_serial_input(arg);
+
+	} else if (!strcmp(cmd, "pom")) {
+		host_set_power_mode(atoi(arg));
+
+	} else if (!strcmp(cmd, "end")) {
+		quit = 1;
+
+	} else {
+		printf("@%u script error, unknown command: %s\n", get_millis(), ev_line);
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/* every frame which is sent by the device */
+static void on_tx(uint8_t *buf, uint8_t burst) {
+	if (net_out) {
+		fprintf(net_out, "t %llu %llu %u", (unsigned long long)host_cc1101.tx_start, (unsigned long long)host_cc1101.tx_end, burst);
+		for (uint8_t i = 0; i <= buf[0]; i++) fprintf(net_out, " %02X", buf[i]);
+		fprintf(net_out, "\n");
+		return;
+	}
+	printf("@%u tx", get_millis()); print_hex(buf, buf[0] + 1); printf("%s\n", (burst) ? " burst" : "");
+	if (replay) replay_tx(buf);
+}
+
+/* one turn of the main loop, like the arduino core does it */
+static void run_loop(void) {
+	loop();
+	serialEventRun();
+	host_irq();
+	host_advance(loop_us);
+}
+
+
+/*-- node of the radio medium ---------------------------------------------------------------------------------------------
+* the medium keeps all nodes in lockstep, the device runs only while a step command is processed. snd_data() busy waits
+* till the frame is sent, so the clock of a node can be ahead of the step, it runs again when the medium caught up.
+*/
+static void run_node(void) {
+	char line[256];
+	while (fgets(line, sizeof(line), net_in)) {
+		if (line[0] == 's') {
+			uint64_t until = strtoull(line + 1, 0, 10);
+			host_set_sleep_limit(until / 1000);
+			while (host_get_us() < until) run_loop();
+			fprintf(net_out, "d\n");
+			fflush(net_out);
+
+		} else if (line[0] == 'r') {
+			char *str;
+			unsigned long id = strtoul(line + 1, &str, 10);
+			uint8_t rssi = strtoul(str, &str, 10);
+			uint8_t buf[64];
+			uint8_t len = parse_hex(str, buf, sizeof(buf));
+			if ((!len) || (buf[0] + 1 != len) || (!host_cc1101.receive(buf, rssi))) fprintf(net_out, "l %lu\n", id);
+
+		} else if (line[0] == 'p') {
+			char name[8];
+			int level = 0;
+			uint8_t pin = (sscanf(line + 1, "%7s %d", name, &level) == 2) ? parse_pin(name) : 0xff;
+			if (pin != 0xff) host_set_pin(pin, level);
+
+		} else if (line[0] == 'c') {
+			host_cc1101.carrier = atoi(line + 1) ? 1 : 0;
+
+		} else if (line[0] == 'q') {
+			break;
+		}
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- replay of a log ------------------------------------------------------------------------------------------------------
+* like the script loop, but every loop() pass is timed with the host clock for the cpu time per frame
+*/
+static uint64_t host_cpu_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run_replay(uint32_t run_ms) {
+	while (get_millis() < run_ms) {
+		uint32_t due = replay_poll();
+		if (due == REPLAY_DONE) break;
+		host_set_sleep_limit((due < run_ms) ? due : run_ms);
+		uint64_t start = host_cpu_ns();
+		run_loop();
+		replay_loop_done(host_cpu_ns() - start);
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+int main(int argc, char **argv) {
+	const char *eep_file = 0, *replay_file = 0;
+	uint32_t run_ms = 0;
+	uint8_t node = 0;
+
+	int i;
+	for (i = 1; i < argc; i++) {
+		if ((!strcmp(argv[i], "-e")) && (i + 1 < argc)) eep_file = argv[++i];
+		else if ((!strcmp(argv[i], "-t")) && (i + 1 < argc)) run_ms = strtoul(argv[++i], 0, 10);
+		else if ((!strcmp(argv[i], "-l")) && (i + 1 < argc)) loop_us = strtoul(argv[++i], 0, 10);
+		else if ((!strcmp(argv[i], "-i")) && (i + 1 < argc) && (parse_hex(argv[i + 1], host_hmid, 3) == 3)) i++;
+		else if (!strcmp(argv[i], "-n")) node = 1;
+		else if ((!strcmp(argv[i], "-r")) && (i + 1 < argc)) replay_file = argv[++i];
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [-e eeprom file] [-t run time ms] [-l loop time us] [-i hmid] [-n] [-r log file] [script file]\n", argv[0]);
+			return 1;
+		} else break;
+	}
+	if (i < argc) {
+		script = fopen(argv[i], "r");
+		if (!script) {
+			fprintf(stderr, "can't open script %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (replay_file) {
+		if (!replay_open(replay_file, host_hmid)) {
+			fprintf(stderr, "can't open log %s\n", replay_file);
+			return 1;
+		}
+		replay = 1;
+	}
+	if (!run_ms) run_ms = (replay) ? 0xffffffff : 60000;									// without -t a replay ends with the log
+	if ((eep_file) && (!host_open_eeprom(eep_file))) {
+		fprintf(stderr, "can't open eeprom file %s\n", eep_file);
+		return 1;
+	}
+
+	if (node) {
+		net_in = fdopen(3, "r");
+		net_out = fdopen(4, "w");
+		if ((!net_in) || (!net_out)) {
+			fprintf(stderr, "node without connection to the medium, fd 3 and 4\n");
+			return 1;
+		}
+	}
+
+	host_cc1101.on_tx = on_tx;
+	read_event();
+	setup();
+
+	if (node) {
+		run_node();
+		Serial.flush();
+		return 0;
+	}
+
+	if (replay) {
+		run_replay(run_ms);
+		Serial.flush();
+		replay_report();
+		return 0;
+	}
+
+	while ((!quit) && (get_millis() < run_ms)) {
+		while ((ev_valid) && (ev_time <= get_millis()) && (!quit)) {						// everything which is due
+			do_event();
+			read_event();
+		}
+		host_set_sleep_limit((ev_valid) && (ev_time < run_ms) ? ev_time : run_ms);			// a sleeping device wakes up for the next event
+		run_loop();
+	}
+
+	Serial.flush();
+	printf("@%u end, %u frames sent, %u received\n", get_millis(), host_cc1101.tx_cnt, host_cc1101.rx_cnt);
+	return 0;
+}
@@ -0,0 +1,809 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin host radio medium ----------------------------------------------------------------------------------------------
+*  runs a network of asksin_host nodes against one virtual radio medium and a scripted central. every node is a process
+*  of its own, the library keeps its state in globals, so every node has its own AS, cmm[], eeprom image and HMID.
+*  the medium keeps all nodes in lockstep, steps of the quantum in the virtual clock, and decides at the end of every frame
+*  who received it. the medium models
+*    - the air time at 10kBaud, 0.8ms per byte plus preamble, sync and crc, and 360ms more for a burst
+*    - the RSSI by distance, log distance path loss from the positions of the nodes, below the sensitivity a frame is lost
+*    - collisions, a frame survives an overlapping one only if it is RF_CAPTURE_DB stronger
+*    - half duplex, a node which is sending at the same time doesn't hear a frame
+*    - random packet loss per link
+*    - carrier sense, the nodes see a burst or a frame in the air like the CC1101 does
+*  the central answers frames which request an ACK, pairs the nodes and sends commands with retries, one after another
+*  like a CCU does, an ACK or INFO with the counter of the command ends it. at the end the latency of the commands, the retries and the channel utilization are reported.
+*
+*  usage: asksin_net [-t run time ms] [-q quantum us] [-l loop time us] [-p loss %] [-s seed] [-o dir] [-x node] [-v] [script]
+*    -t  end of the run in ms of the virtual clock, default 60000
+*    -q  step of the lockstep, frames are delivered at the next step after their end, default 1000us
+*    -l  time which one loop() takes in the nodes, default 100us
+*    -p  random loss of a frame per link in percent, default 0
+*    -s  seed of the random loss, the same seed gives the same run
+*    -o  directory for the serial output of the nodes, node<n>.log, and their eeprom images, node<n>.eep
+*    -x  the node executable, default asksin_host next to asksin_net
+*    -v  every frame on the air with the receivers which lost it
+*
+*  script, setup lines first, then one event per line: <time ms> <command>, +<ms> is relative to the event before
+*    nodes <count> [hmid]             amount of nodes, HMID of the first one, the others count up, default 10 and 331201
+*    central <hmid>                   HMID of the central, default 631964
+*    pos <node|central> <x> <y>       position in m, default is a grid with 4m spacing in front of the central
+*    pair <node|all>                  press the config button, the central pairs the node, all presses them 1s apart
+*    pin <node|all> <B0..F7> <0|1>    drive an input pin of the node
+*    send <node|all> [from <hmid>] <hex bytes>   command of the central, flag, type and payload, with from the central
+*                                     plays a remote with this HMID. an answer is awaited if the BIDI flag is set
+*    peer <node|all> <cnl> <hmid|node|central> <peer cnl>   add a peer to a channel of the node
+*    end                              end of the run
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+
+#define NET_MAX_NODES      100																// nodes without the central
+#define NET_MAX_AIR        512																// frames in the window of the medium
+#define NET_MAX_CMD        1024																// command queue of the central
+#define NET_MAX_PIN        256																// pending pin changes
+#define NET_MAX_LATENCY    100000															// latency samples
+
+#define AIR_US_PER_BYTE    800																// 10kBaud
+#define AIR_OVERHEAD       10																// preamble 4, sync 4, crc 2 byte
+#define AIR_BURST_US       360000															// wake up burst in front of the frame
+#define AIR_KEEP_US        2000000															// frames are kept for the checks of later ones
+
+#define RF_TX_DBM          10.0																// PATABLE 0xC3
+#define RF_LOSS_1M         40.0																// path loss at 1m, 868MHz
+#define RF_LOSS_EXP        3.0																// path loss exponent, indoor
+#define RF_SENS_DBM        -104.0															// sensitivity at 10kBaud
+#define RF_CAPTURE_DB      10.0																// a stronger frame survives a collision
+
+#define CCU_ACK_DELAY_US   20000															// the central answers with an ACK
+#define CCU_ACK_TIMEOUT_US 300000															// and waits for one before it sends again
+#define CCU_MAX_SEND       3																// sends of a command
+#define CCU_CMD_GAP_US     50000															// between two commands of the queue
+#define CCU_PAIR_WINDOW_US 20000000															// pairing mode after a button press
+#define CCU_PAIR_STAGGER   1000																// ms between the nodes of 'pair all'
+#define CBN_PRESS_US       150000															// short press of the config button
+
+#define BIDI               0x20
+#define BURST              0x10
+
+
+enum { LOST_RANGE, LOST_COLLISION, LOST_DEAF, LOST_NO_RX, LOST_RANDOM, LOST_CNT, LOST_NONE = 0xff };
+static const char *lost_name[LOST_CNT] = { "range", "collision", "deaf", "no rx", "random", };
+
+struct s_net_node {
+	pid_t    pid;
+	FILE     *to, *from;																	// commands to the node and its answers
+	uint8_t  hmid[3];
+	double   x, y;																			// position in m
+	uint8_t  carrier;																		// last carrier state sent to the node
+	uint64_t pair_until;																	// the central pairs the node till then
+	uint8_t  last_tx[64];																	// a frame sent again is a retry
+	uint32_t tx, retr, rx, lost[LOST_CNT];													// rx and lost count the frames addressed to the node
+	uint64_t air_us;																		// own time on the air
+};
+
+struct s_air_frame {
+	uint32_t id;
+	uint8_t  from, to;																		// node index, 0 is the central, 0xff broadcast to nodes
+	uint8_t  delivered;
+	uint64_t start, end;																	// on the air
+	uint8_t  buf[64];																		// decoded, buf[0] is the length
+};
+
+struct s_ccu_cmd {
+	uint8_t  node;
+	uint8_t  from[3];																		// sender, the central or a virtual remote
+	uint8_t  len;
+	uint8_t  buf[48];																		// flag, type and payload
+};
+
+struct s_pin_chg {
+	uint64_t time;
+	uint8_t  node, pin, level;
+};
+
+
+static s_net_node   node[NET_MAX_NODES + 1];												// node[0] is the central
+static uint8_t      node_cnt = 10;
+static uint8_t      node_pos_set[NET_MAX_NODES + 1];
+static s_air_frame  air[NET_MAX_AIR];
+static uint16_t     air_cnt;
+static uint32_t     air_id;
+static uint64_t     air_busy_until, air_busy_us;											// channel utilization, union of all frames
+static uint32_t     air_frames, air_lost[LOST_CNT];
+
+static uint64_t     run_us = 60000000;
+static uint32_t     quantum_us = 1000;
+static double       loss;
+static uint8_t      verbose;
+static uint8_t      quit;
+
+
+/*-- helpers ------------------------------------------------------------------------------------------------------------ */
+static uint8_t parse_hex(const char *str, uint8_t *buf, uint8_t max) {
+	uint8_t len = 0, nibble = 0, val = 0;
+	for (; *str && len < max; str++) {
+		if (!isxdigit((unsigned char)*str)) continue;
+		val = (val << 4) | (isdigit((unsigned char)*str) ? *str - '0' : (toupper((unsigned char)*str) - 'A' + 10));
+		if (++nibble == 2) {
+			buf[len++] = val;
+			nibble = val = 0;
+		}
+	}
+	return len;
+}
+
+static void print_hex(FILE *f, uint8_t *buf, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) fprintf(f, " %02X", buf[i]);
+}
+
+static const char *node_name(uint8_t idx) {
+	static char name[4][8];
+	static uint8_t sel;
+	sel = (sel + 1) & 3;
+	if (idx == 0) return "ccu";
+	if (idx == 0xff) return "all";
+	snprintf(name[sel], sizeof(name[sel]), "n%u", idx);
+	return name[sel];
+}
+
+/* node index by HMID, 0 is the central, 0xff for a broadcast or an unknown device */
+static uint8_t node_by_hmid(uint8_t *hmid) {
+	for (uint8_t i = 0; i <= node_cnt; i++) {
+		if (!memcmp(node[i].hmid, hmid, 3)) return i;
+	}
+	return 0xff;
+}
+
+/* rssi in dBm at the receiver, log distance path loss */
+static double rf_rssi(uint8_t from, uint8_t to) {
+	double dx = node[from].x - node[to].x, dy = node[from].y - node[to].y;
+	double dist = sqrt(dx * dx + dy * dy);
+	if (dist < 1) dist = 1;
+	return RF_TX_DBM - RF_LOSS_1M - 10 * RF_LOSS_EXP * log10(dist);
+}
+
+/* rssi register of the CC1101, 0.5dB steps with an offset of 74 */
+static uint8_t rf_rssi_reg(double dbm) {
+	int reg = (int)((dbm + 74) * 2);
+	if (reg > 127) reg = 127;
+	if (reg < -128) reg = -128;
+	return (uint8_t)reg;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- nodes --------------------------------------------------------------------------------------------------------------
+* every node is an asksin_host -n, the medium talks to it through a pipe on fd 3 and gets the answers on fd 4
+*/
+static uint8_t node_start(uint8_t idx, const char *exe, const char *dir, uint32_t loop_us) {
+	int to[2], from[2];
+	if ((pipe2(to, O_CLOEXEC)) || (pipe2(from, O_CLOEXEC))) return 0;
+
+	char hmid[8], loop[12], log_name[256], eep_name[256];
+	snprintf(hmid, sizeof(hmid), "%02X%02X%02X", node[idx].hmid[0], node[idx].hmid[1], node[idx].hmid[2]);
+	snprintf(loop, sizeof(loop), "%u", loop_us);
+	snprintf(log_name, sizeof(log_name), "%s/node%u.log", (dir) ? dir : ".", idx);
+	snprintf(eep_name, sizeof(eep_name), "%s/node%u.eep", (dir) ? dir : ".", idx);
+
+	pid_t pid = fork();
+	if (pid < 0) return 0;
+	if (!pid) {
+		int in = fcntl(to[0], F_DUPFD, 10), out = fcntl(from[1], F_DUPFD, 10);				// out of the way of 3 and 4
+		dup2(in, 3);
+		dup2(out, 4);
+		close(in);
+		close(out);
+		int log = open((dir) ? log_name : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (log >= 0) dup2(log, 1);
+		if (dir) execl(exe, exe, "-n", "-i", hmid, "-l", loop, "-e", eep_name, (char*)0);
+		else execl(exe, exe, "-n", "-i", hmid, "-l", loop, (char*)0);
+		fprintf(stderr, "can't start node %s\n", exe);
+		_exit(1);
+	}
+
+	close(to[0]);
+	close(from[1]);
+	node[idx].pid = pid;
+	node[idx].to = fdopen(to[1], "w");
+	node[idx].from = fdopen(from[0], "r");
+	return (node[idx].to) && (node[idx].from);
+}
+
+static void node_stop(uint8_t idx) {
+	fprintf(node[idx].to, "q\n");
+	fclose(node[idx].to);
+	fclose(node[idx].from);
+	waitpid(node[idx].pid, 0, 0);
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- the medium ---------------------------------------------------------------------------------------------------------- */
+static void ccu_receive(s_air_frame *f, uint64_t now);
+
+/* a frame goes on the air, from is the node index, 0 is the central */
+static void air_add(uint8_t from, uint64_t start, uint64_t end, uint8_t *buf) {
+	if ((air_cnt >= NET_MAX_AIR) || (buf[0] > 60)) {
+		fprintf(stderr, "medium overflow, frame of %s dropped\n", node_name(from));
+		return;
+	}
+	s_air_frame *f = &air[air_cnt++];
+	f->id = ++air_id;
+	f->from = from;
+	f->to = node_by_hmid(buf + 7);
+	if ((f->to == 0xff) && (from)) f->to = 0;												// the central is the one who listens to broadcasts of nodes
+	f->delivered = 0;
+	f->start = start;
+	f->end = end;
+	memcpy(f->buf, buf, buf[0] + 1);
+
+	air_frames++;
+	node[from].tx++;
+	node[from].air_us += end - start;
+	if ((from) && (buf[2] & BIDI) && (!memcmp(node[from].last_tx, buf, buf[0] + 1))) node[from].retr++;	// same frame again, no ACK came
+	memcpy(node[from].last_tx, buf, buf[0] + 1);
+
+	if (start >= air_busy_until) air_busy_us += end - start;
+	else if (end > air_busy_until) air_busy_us += end - air_busy_until;
+	if (end > air_busy_until) air_busy_until = end;
+}
+
+/* why the receiver doesn't get the frame, LOST_NONE if it does */
+static uint8_t air_check(s_air_frame *f, uint8_t rcv) {
+	double rssi = rf_rssi(f->from, rcv);
+	if (rssi < RF_SENS_DBM) return LOST_RANGE;
+
+	for (uint16_t i = 0; i < air_cnt; i++) {
+		s_air_frame *g = &air[i];
+		if ((g == f) || (g->start >= f->end) || (g->end <= f->start)) continue;				// no overlap
+		if (g->from == rcv) return LOST_DEAF;												// half duplex
+		double other = rf_rssi(g->from, rcv);
+		if ((other >= RF_SENS_DBM) && (rssi < other + RF_CAPTURE_DB)) return LOST_COLLISION;
+	}
+
+	if ((loss) && (rand() < loss / 100 * RAND_MAX)) return LOST_RANDOM;
+	return LOST_NONE;
+}
+
+static void air_lost_at(s_air_frame *f, uint8_t rcv, uint8_t why) {
+	if (f->to != rcv) return;																// only the destination counts
+	node[rcv].lost[why]++;
+	air_lost[why]++;
+}
+
+/* frames which ended are delivered, everything which overlaps them is known, the nodes report their frames in the step
+*  where the transmission starts */
+static void air_deliver(uint64_t now) {
+	for (uint16_t i = 0; i < air_cnt; i++) {
+		s_air_frame *f = &air[i];
+		if ((f->delivered) || (f->end > now)) continue;
+		f->delivered = 1;
+
+		if (verbose) {
+			printf("@%llu.%03llu %s>%s", (unsigned long long)(f->start / 1000), (unsigned long long)(f->start % 1000), node_name(f->from), node_name(f->to));
+			print_hex(stdout, f->buf, f->buf[0] + 1);
+		}
+
+		for (uint8_t rcv = 0; rcv <= node_cnt; rcv++) {
+			if (rcv == f->from) continue;
+			uint8_t why = air_check(f, rcv);
+			if (why != LOST_NONE) {
+				air_lost_at(f, rcv, why);
+				if ((verbose) && (f->to == rcv)) printf(" [lost, %s]", lost_name[why]);
+				continue;
+			}
+			if (f->to == rcv) node[rcv].rx++;
+
+			if (!rcv) {
+				ccu_receive(f, now);
+				continue;
+			}
+			fprintf(node[rcv].to, "r %u %u", f->id, rf_rssi_reg(rf_rssi(f->from, rcv)));
+			print_hex(node[rcv].to, f->buf, f->buf[0] + 1);
+			fprintf(node[rcv].to, "\n");
+		}
+		if (verbose) printf("\n");
+	}
+}
+
+/* a node reported a frame which was lost because the CC1101 was not in RX mode */
+static void air_no_rx(uint8_t rcv, uint32_t id) {
+	for (uint16_t i = 0; i < air_cnt; i++) {
+		if (air[i].id != id) continue;
+		if (air[i].to == rcv) node[rcv].rx--;
+		air_lost_at(&air[i], rcv, LOST_NO_RX);
+		if (verbose) printf("@%llu %s lost frame of %s, not in rx\n", (unsigned long long)(air[i].end / 1000), node_name(rcv), node_name(air[i].from));
+		return;
+	}
+}
+
+/* a frame or a burst in the air which the node can hear */
+static uint8_t air_carrier(uint8_t rcv, uint64_t now) {
+	for (uint16_t i = 0; i < air_cnt; i++) {
+		s_air_frame *f = &air[i];
+		if ((f->from == rcv) || (f->start > now) || (f->end <= now)) continue;
+		if (rf_rssi(f->from, rcv) >= RF_SENS_DBM) return 1;
+	}
+	return 0;
+}
+
+/* delivered frames are kept till nothing can overlap them any more */
+static void air_cleanup(uint64_t now) {
+	uint16_t keep = 0;
+	for (uint16_t i = 0; i < air_cnt; i++) {
+		if ((air[i].delivered) && (air[i].end + AIR_KEEP_US < now)) continue;
+		if (keep != i) air[keep] = air[i];
+		keep++;
+	}
+	air_cnt = keep;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- the central ----------------------------------------------------------------------------------------------------------
+* sends the commands of the queue one after another, waits for the ACK and sends again after a timeout. frames of the
+* nodes which request an ACK get one, a DEVICE_INFO of a node in pairing mode starts the config of the master id.
+*/
+static struct {
+	uint8_t   cnt;																			// message counter
+	uint64_t  busy_until;																	// own frame on the air
+	s_ccu_cmd queue[NET_MAX_CMD];
+	uint16_t  head, tail;
+
+	s_ccu_cmd cur;																			// the command which waits for its ACK
+	uint8_t   cur_active, cur_send, cur_cnt;
+	uint64_t  cur_first, cur_timeout;
+	uint64_t  next_cmd;
+
+	uint8_t   ack[NET_MAX_NODES][12];														// pending ACKs
+	uint64_t  ack_due[NET_MAX_NODES];
+	uint8_t   ack_cnt;
+
+	uint32_t  sent, acked, failed, retries;
+	uint32_t  latency[NET_MAX_LATENCY];														// us till the ACK
+	uint32_t  lat_cnt;
+} ccu;
+
+static void ccu_queue(uint8_t idx, const uint8_t *from, const uint8_t *buf, uint8_t len) {
+	if ((uint16_t)(ccu.tail + 1) % NET_MAX_CMD == ccu.head) {
+		fprintf(stderr, "command queue of the central is full\n");
+		return;
+	}
+	s_ccu_cmd *cmd = &ccu.queue[ccu.tail];
+	cmd->node = idx;
+	memcpy(cmd->from, (from) ? from : node[0].hmid, 3);
+	cmd->len = (len > sizeof(cmd->buf)) ? sizeof(cmd->buf) : len;
+	memcpy(cmd->buf, buf, cmd->len);
+	ccu.tail = (ccu.tail + 1) % NET_MAX_CMD;
+}
+
+static void ccu_tx(uint8_t *buf, uint64_t now) {
+	uint64_t end = now + (uint64_t)(buf[0] + 1 + AIR_OVERHEAD) * AIR_US_PER_BYTE;
+	if (buf[2] & BURST) end += AIR_BURST_US;
+	ccu.busy_until = end;
+	air_add(0, now, end, buf);
+}
+
+/* len, cnt, flag, type, sender, receiver and payload */
+static void ccu_tx_cmd(uint64_t now) {
+	uint8_t buf[64];
+	buf[0] = 7 + ccu.cur.len;
+	buf[1] = ccu.cur_cnt;
+	buf[2] = ccu.cur.buf[0];
+	buf[3] = ccu.cur.buf[1];
+	memcpy(buf + 4, ccu.cur.from, 3);
+	memcpy(buf + 7, node[ccu.cur.node].hmid, 3);
+	memcpy(buf + 10, ccu.cur.buf + 2, ccu.cur.len - 2);
+	ccu_tx(buf, now);
+	ccu.cur_send++;
+	ccu.cur_timeout = ccu.busy_until + CCU_ACK_TIMEOUT_US;
+}
+
+/* listen before talk, the central waits for a free channel */
+static void ccu_poll(uint64_t now) {
+	if ((now < ccu.busy_until) || (air_carrier(0, now))) return;
+
+	for (uint8_t i = 0; i < ccu.ack_cnt; i++) {												// ACKs first
+		if (ccu.ack_due[i] > now) continue;
+		ccu_tx(ccu.ack[i], now);
+		ccu.ack_cnt--;
+		memmove(ccu.ack[i], ccu.ack[i + 1], (ccu.ack_cnt - i) * sizeof(ccu.ack[0]));
+		memmove(&ccu.ack_due[i], &ccu.ack_due[i + 1], (ccu.ack_cnt - i) * sizeof(ccu.ack_due[0]));
+		return;
+	}
+
+	if (ccu.cur_active) {
+		if (now < ccu.cur_timeout) return;
+		if (ccu.cur_send < CCU_MAX_SEND) {
+			ccu.retries++;
+			node[0].retr++;
+			ccu_tx_cmd(now);
+			return;
+		}
+		ccu.failed++;
+		ccu.cur_active = 0;
+		ccu.next_cmd = now + CCU_CMD_GAP_US;
+		if (verbose) printf("@%llu ccu command to %s failed\n", (unsigned long long)(now / 1000), node_name(ccu.cur.node));
+		return;
+	}
+
+	if ((ccu.head == ccu.tail) || (now < ccu.next_cmd)) return;
+	ccu.cur = ccu.queue[ccu.head];
+	ccu.head = (ccu.head + 1) % NET_MAX_CMD;
+	ccu.cur_cnt = ccu.cnt++;
+	ccu.cur_send = 0;
+	ccu.cur_first = now;
+	ccu.sent++;
+	ccu_tx_cmd(now);
+
+	ccu.cur_active = (ccu.cur.buf[0] & BIDI) ? 1 : 0;
+	if (!ccu.cur_active) ccu.next_cmd = ccu.busy_until + CCU_CMD_GAP_US;
+}
+
+static void ccu_pair(uint8_t idx) {
+	const uint8_t *id = node[0].hmid;
+	uint8_t start[] = { 0xA0, 0x01, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, };			// CONFIG_START, cnl 0, list 0
+	uint8_t write[] = { 0xA0, 0x01, 0x00, 0x08, 0x02, 0x01, 0x0A, id[0], 0x0B, id[1], 0x0C, id[2], };	// CONFIG_WRITE_INDEX, master id
+	uint8_t end[]   = { 0xA0, 0x01, 0x00, 0x06, };											// CONFIG_END
+	ccu_queue(idx, 0, start, sizeof(start));
+	ccu_queue(idx, 0, write, sizeof(write));
+	ccu_queue(idx, 0, end, sizeof(end));
+}
+
+static void ccu_receive(s_air_frame *f, uint64_t now) {
+	uint8_t *buf = f->buf;
+	uint8_t idx = f->from;
+	if (f->to) return;																		// not for the central
+
+	if ((ccu.cur_active) && (idx == ccu.cur.node) && (buf[1] == ccu.cur_cnt)) {				// answer with the counter of the command, ACK or INFO
+		if (ccu.lat_cnt < NET_MAX_LATENCY) ccu.latency[ccu.lat_cnt++] = (uint32_t)(f->end - ccu.cur_first);
+		ccu.acked++;
+		ccu.cur_active = 0;
+		ccu.next_cmd = now + CCU_CMD_GAP_US;
+	}
+
+	if ((buf[3] == 0x00) && (now <= node[idx].pair_until)) {								// DEVICE_INFO in pairing mode
+		node[idx].pair_until = 0;
+		ccu_pair(idx);
+	}
+
+	if ((buf[2] & BIDI) && (!memcmp(buf + 7, node[0].hmid, 3)) && (ccu.ack_cnt < NET_MAX_NODES)) {
+		uint8_t *ack = ccu.ack[ccu.ack_cnt];
+		ack[0] = 0x0A; ack[1] = buf[1]; ack[2] = 0x80; ack[3] = 0x02;
+		memcpy(ack + 4, node[0].hmid, 3);
+		memcpy(ack + 7, buf + 4, 3);
+		ack[10] = 0x00;
+		ccu.ack_due[ccu.ack_cnt++] = now + CCU_ACK_DELAY_US;
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- script handling ------------------------------------------------------------------------------------------------------
+* setup lines are taken before the nodes start, events are read one after another like in host_main.cpp
+*/
+static FILE    *script;
+static uint32_t ev_time;
+static char     ev_line[256];
+static uint8_t  ev_valid;
+
+static s_pin_chg pin_chg[NET_MAX_PIN];
+static uint16_t  pin_cnt;
+
+static uint8_t parse_node(const char *str, const char **end) {
+	while (isspace((unsigned char)*str)) str++;
+	uint8_t idx = 0xfe;
+	if (!strncmp(str, "all", 3)) idx = 0xff, str += 3;
+	else if (!strncmp(str, "central", 7)) idx = 0, str += 7;
+	else if (isdigit((unsigned char)*str)) {
+		char *e;
+		unsigned long n = strtoul(str, &e, 10);
+		if ((n >= 1) && (n <= node_cnt)) idx = n;
+		str = e;
+	}
+	if (end) *end = str;
+	return idx;
+}
+
+static void pin_add(uint64_t time, uint8_t idx, uint8_t pin, uint8_t level) {
+	if (pin_cnt >= NET_MAX_PIN) return;
+	pin_chg[pin_cnt].time = time;
+	pin_chg[pin_cnt].node = idx;
+	pin_chg[pin_cnt].pin = pin;
+	pin_chg[pin_cnt++].level = level;
+}
+
+static void pin_poll(uint64_t now) {
+	for (uint16_t i = 0; i < pin_cnt; ) {
+		if (pin_chg[i].time > now) {
+			i++;
+			continue;
+		}
+		fprintf(node[pin_chg[i].node].to, "p pin%c%u %u\n", 'B' + pin_chg[i].pin / 8, pin_chg[i].pin % 8, pin_chg[i].level);
+		pin_chg[i] = pin_chg[--pin_cnt];
+	}
+}
+
+static void do_setup(const char *line) {
+	char cmd[16] = "";
+	int pos = 0;
+	sscanf(line, "%15s %n", cmd, &pos);
+	const char *arg = line + pos;
+	uint8_t hmid[3];
+
+	if (!strcmp(cmd, "nodes")) {
+		char *end;
+		unsigned long cnt = strtoul(arg, &end, 10);
+		node_cnt = (cnt > NET_MAX_NODES) ? NET_MAX_NODES : (uint8_t)cnt;
+		if (parse_hex(end, hmid, 3) == 3) memcpy(node[1].hmid, hmid, 3);
+
+	} else if ((!strcmp(cmd, "central")) && (parse_hex(arg, hmid, 3) == 3)) {
+		memcpy(node[0].hmid, hmid, 3);
+
+	} else if (!strcmp(cmd, "pos")) {
+		const char *end;
+		uint8_t idx = parse_node(arg, &end);
+		double x, y;
+		if ((idx > NET_MAX_NODES) || (sscanf(end, "%lf %lf", &x, &y) != 2)) fprintf(stderr, "script error: %s\n", line);
+		else node[idx].x = x, node[idx].y = y, node_pos_set[idx] = 1;
+
+	} else {
+		fprintf(stderr, "script error: %s\n", line);
+	}
+}
+
+static void read_event(void) {
+	char line[sizeof(ev_line) + 16];
+	ev_valid = 0;
+	while ((script) && (fgets(line, sizeof(line), script))) {
+		char *str = line;
+		while (isspace((unsigned char)*str)) str++;
+		str[strcspn(str, "\r\n#")] = 0;
+		if (!*str) continue;
+		if (isalpha((unsigned char)*str)) {													// setup line
+			if (air_id) fprintf(stderr, "setup line after the start ignored: %s\n", str);
+			else do_setup(str);
+			continue;
+		}
+
+		uint8_t relative = (*str == '+');
+		if (relative) str++;
+		char *end;
+		uint32_t time = strtoul(str, &end, 10);
+		ev_time = (relative) ? ev_time + time : time;
+		while (isspace((unsigned char)*end)) end++;
+		strncpy(ev_line, end, sizeof(ev_line) - 1);
+		ev_valid = 1;
+		return;
+	}
+}
+
+static void do_event(uint64_t now) {
+	char cmd[16] = "";
+	int pos = 0;
+	sscanf(ev_line, "%15s %n", cmd, &pos);
+	const char *arg;
+	uint8_t idx = parse_node(ev_line + pos, &arg);
+	uint8_t first = (idx == 0xff) ? 1 : idx, last = (idx == 0xff) ? node_cnt : idx;
+	if ((strcmp(cmd, "end")) && ((idx == 0) || (idx == 0xfe))) {
+		fprintf(stderr, "@%u script error, unknown node: %s\n", ev_time, ev_line);
+		return;
+	}
+
+	if (!strcmp(cmd, "pair")) {
+		for (uint8_t i = first; i <= last; i++) {
+			uint64_t press = now + (uint64_t)(i - first) * CCU_PAIR_STAGGER * 1000;
+			pin_add(press, i, 0, 0);														// config button on B0
+			pin_add(press + CBN_PRESS_US, i, 0, 1);
+			node[i].pair_until = press + CCU_PAIR_WINDOW_US;
+		}
+
+	} else if (!strcmp(cmd, "pin")) {
+		char name[8];
+		int level = 0;
+		if ((sscanf(arg, "%7s %d", name, &level) != 2) || (toupper((unsigned char)name[0]) < 'B') || (toupper((unsigned char)name[0]) > 'F')) {
+			fprintf(stderr, "@%u script error, unknown pin: %s\n", ev_time, ev_line);
+			return;
+		}
+		for (uint8_t i = first; i <= last; i++) pin_add(now, i, (toupper((unsigned char)name[0]) - 'B') * 8 + (name[1] - '0') % 8, level ? 1 : 0);
+
+	} else if (!strcmp(cmd, "send")) {
+		uint8_t from[3], buf[48];
+		uint8_t remote = 0;
+		while (isspace((unsigned char)*arg)) arg++;
+		if ((!strncmp(arg, "from", 4)) && (parse_hex(arg + 4, from, 3) == 3)) {				// a virtual remote, its HMID is the sender
+			remote = 1;
+			arg = strpbrk(arg + 5, " \t");
+			if (!arg) arg = "";
+		}
+		uint8_t len = parse_hex(arg, buf, sizeof(buf));
+		if (len < 2) {
+			fprintf(stderr, "@%u script error, flag and type are needed: %s\n", ev_time, ev_line);
+			return;
+		}
+		for (uint8_t i = first; i <= last; i++) ccu_queue(i, (remote) ? from : 0, buf, len);
+
+	} else if (!strcmp(cmd, "peer")) {
+		unsigned int cnl, pcnl;
+		char name[16];
+		uint8_t peer[3];
+		if (sscanf(arg, "%u %15s %u", &cnl, name, &pcnl) != 3) name[0] = 0;
+		uint8_t pidx = ((strlen(name) == 6) && (parse_hex(name, peer, 3) == 3)) ? 0xff : parse_node(name, 0);	// HMID, node number or central
+		if (pidx <= node_cnt) memcpy(peer, node[pidx].hmid, 3);
+		else if (pidx != 0xff) {
+			fprintf(stderr, "@%u script error, unknown peer: %s\n", ev_time, ev_line);
+			return;
+		}
+		uint8_t buf[] = { 0xA0, 0x01, (uint8_t)cnl, 0x01, peer[0], peer[1], peer[2], (uint8_t)pcnl, 0x00, };	// CONFIG_PEER_ADD
+		for (uint8_t i = first; i <= last; i++) ccu_queue(i, 0, buf, sizeof(buf));
+
+	} else if (!strcmp(cmd, "end")) {
+		quit = 1;
+
+	} else {
+		fprintf(stderr, "@%u script error, unknown command: %s\n", ev_time, ev_line);
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- report ------------------------------------------------------------------------------------------------------------- */
+static int cmp_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void report(uint64_t now) {
+	printf("\nrun %llu ms, %u nodes, quantum %u us, loss %.1f %%\n", (unsigned long long)(now / 1000), node_cnt, quantum_us, loss);
+	printf("air: %u frames, %llu ms on the air, utilization %.1f %%\n", air_frames, (unsigned long long)(air_busy_us / 1000), (now) ? 100.0 * air_busy_us / now : 0);
+	printf("lost at the destination:");
+	for (uint8_t i = 0; i < LOST_CNT; i++) printf(" %s %u,", lost_name[i], air_lost[i]);
+	printf("\n");
+
+	printf("central: %u commands, %u acked, %u failed, %u retries\n", ccu.sent, ccu.acked, ccu.failed, ccu.retries);
+	if (ccu.lat_cnt) {
+		qsort(ccu.latency, ccu.lat_cnt, sizeof(ccu.latency[0]), cmp_u32);
+		#define LAT_P(p) (ccu.latency[(ccu.lat_cnt - 1) * p / 100] / 1000.0)
+		printf("latency ms: min %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", LAT_P(0), LAT_P(50), LAT_P(90), LAT_P(99), LAT_P(100));
+		#undef LAT_P
+
+		static const uint32_t bound[] = { 50, 100, 200, 500, 1000, 2000, };
+		uint32_t bucket[sizeof(bound) / sizeof(bound[0]) + 1] = { 0, };
+		for (uint32_t i = 0; i < ccu.lat_cnt; i++) {
+			uint8_t b = 0;
+			while ((b < sizeof(bound) / sizeof(bound[0])) && (ccu.latency[i] >= bound[b] * 1000)) b++;
+			bucket[b]++;
+		}
+		printf("latency histogram:");
+		for (uint8_t b = 0; b < sizeof(bucket) / sizeof(bucket[0]); b++) {
+			if (b < sizeof(bound) / sizeof(bound[0])) printf(" <%u %u,", bound[b], bucket[b]);
+			else printf(" >=%u %u\n", bound[b - 1], bucket[b]);
+		}
+	}
+
+	printf("\nnode  hmid      x      y     tx  retr     rx  range  coll  deaf  norx  rand  air ms  duty %%\n");
+	for (uint8_t i = 0; i <= node_cnt; i++) {
+		s_net_node *n = &node[i];
+		printf("%-4s  %02X%02X%02X %6.1f %6.1f %6u %5u %6u %6u %5u %5u %5u %5u %7llu %6.2f\n", node_name(i), n->hmid[0], n->hmid[1], n->hmid[2],
+			n->x, n->y, n->tx, n->retr, n->rx, n->lost[LOST_RANGE], n->lost[LOST_COLLISION], n->lost[LOST_DEAF], n->lost[LOST_NO_RX],
+			n->lost[LOST_RANDOM], (unsigned long long)(n->air_us / 1000), (now) ? 100.0 * n->air_us / now : 0);
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+int main(int argc, char **argv) {
+	uint32_t loop_us = 100;
+	uint32_t seed = 1;
+	const char *dir = 0;
+	char exe[512];
+
+	const char *slash = strrchr(argv[0], '/');												// asksin_host next to asksin_net
+	snprintf(exe, sizeof(exe), "%.*sasksin_host", (slash) ? (int)(slash - argv[0] + 1) : 0, argv[0]);
+
+	int i;
+	for (i = 1; i < argc; i++) {
+		if ((!strcmp(argv[i], "-t")) && (i + 1 < argc)) run_us = strtoull(argv[++i], 0, 10) * 1000;
+		else if ((!strcmp(argv[i], "-q")) && (i + 1 < argc)) quantum_us = strtoul(argv[++i], 0, 10);
+		else if ((!strcmp(argv[i], "-l")) && (i + 1 < argc)) loop_us = strtoul(argv[++i], 0, 10);
+		else if ((!strcmp(argv[i], "-p")) && (i + 1 < argc)) loss = atof(argv[++i]);
+		else if ((!strcmp(argv[i], "-s")) && (i + 1 < argc)) seed = strtoul(argv[++i], 0, 10);
+		else if ((!strcmp(argv[i], "-o")) && (i + 1 < argc)) dir = argv[++i];
+		else if ((!strcmp(argv[i], "-x")) && (i + 1 < argc)) snprintf(exe, sizeof(exe), "%s", argv[++i]);
+		else if (!strcmp(argv[i], "-v")) verbose = 1;
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [-t run time ms] [-q quantum us] [-l loop time us] [-p loss %%] [-s seed] [-o dir] [-x node] [-v] [script]\n", argv[0]);
+			return 1;
+		} else break;
+	}
+	if (!quantum_us) quantum_us = 1000;
+	if (i < argc) {
+		script = fopen(argv[i], "r");
+		if (!script) {
+			fprintf(stderr, "can't open script %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	node[0].hmid[0] = 0x63; node[0].hmid[1] = 0x19; node[0].hmid[2] = 0x64;
+	node[1].hmid[0] = 0x33; node[1].hmid[1] = 0x12; node[1].hmid[2] = 0x01;
+	read_event();																			// takes the setup lines
+	srand(seed);
+	signal(SIGPIPE, SIG_IGN);
+
+	uint8_t width = 1;
+	while (width * width < node_cnt) width++;
+	for (uint8_t n = 1; n <= node_cnt; n++) {
+		uint32_t id = ((uint32_t)node[1].hmid[0] << 16 | node[1].hmid[1] << 8 | node[1].hmid[2]) + n - 1;
+		node[n].hmid[0] = id >> 16; node[n].hmid[1] = id >> 8; node[n].hmid[2] = id;
+		if (!node_pos_set[n]) {																// grid in front of the central
+			node[n].x = ((n - 1) % width - (width - 1) / 2.0) * 4;
+			node[n].y = ((n - 1) / width + 1) * 4;
+		}
+		if (!node_start(n, exe, dir, loop_us)) {
+			fprintf(stderr, "can't start node %u\n", n);
+			return 1;
+		}
+	}
+
+	uint64_t now;
+	for (now = 0; (now < run_us) && (!quit); now += quantum_us) {
+		while ((ev_valid) && ((uint64_t)ev_time * 1000 <= now) && (!quit)) {				// everything which is due
+			do_event(now);
+			read_event();
+		}
+		pin_poll(now);
+		air_deliver(now);
+		ccu_poll(now);
+		for (uint8_t n = 1; n <= node_cnt; n++) {
+			uint8_t carrier = air_carrier(n, now);
+			if (carrier != node[n].carrier) fprintf(node[n].to, "c %u\n", carrier);
+			node[n].carrier = carrier;
+		}
+		air_cleanup(now);
+
+		for (uint8_t n = 1; n <= node_cnt; n++) {											// all nodes run the step in parallel
+			fprintf(node[n].to, "s %llu\n", (unsigned long long)(now + quantum_us));
+			fflush(node[n].to);
+		}
+		for (uint8_t n = 1; n <= node_cnt; n++) {
+			char line[256];
+			while (fgets(line, sizeof(line), node[n].from)) {
+				if (line[0] == 'd') break;
+				if (line[0] == 'l') air_no_rx(n, strtoul(line + 1, 0, 10));
+				if (line[0] == 't') {
+					char *str;
+					uint64_t start = strtoull(line + 1, &str, 10);
+					uint64_t end = strtoull(str, &str, 10);
+					strtoul(str, &str, 10);													// burst, the air time tells it already
+					uint8_t buf[64];
+					uint8_t len = parse_hex(str, buf, sizeof(buf));
+					if ((len) && (len == buf[0] + 1)) air_add(n, start, end, buf);
+				}
+			}
+			if (feof(node[n].from)) {
+				fprintf(stderr, "node %u ended\n", n);
+				quit = 1;
+			}
+		}
+	}
+	air_deliver(now);
+
+	for (uint8_t n = 1; n <= node_cnt; n++) node_stop(n);
+	report(now);
+	return 0;
+}
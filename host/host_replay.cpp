@@ -0,0 +1,273 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin host replay of captured traffic --------------------------------------------------------------------------------
+*  replays the debug logs of the examples, the m>, l>, b>, <- and -> lines with the frame and the time in brackets:
+*    l> 0B 2B A0 01 63 19 64 1F B7 4A 00 06 (2221137)
+*  the frames for the device are injected through the CC1101 model with the time distance of the log, the device reads
+*  them into rcv_msg and handles them in AS::poll() like on the air. frames of the log which were sent by the device are
+*  the reference for the answers, all other frames are dropped. the device of the log is the one most CONFIG, ACTION and
+*  REMOTE frames go to, the host device takes over its HMID.
+*  per frame the loop() passes and the host cpu time till the frame is read out of the CC1101 and handled, and for frames
+*  with the BIDI flag the latency of the answer in the virtual clock are measured. the answer is compared with the one
+*  of the log, an answer of another device type differs of course. everything but the cpu time is the same in every run,
+*  a stored output of a replay is a regression reference.
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#include "HAL.h"
+#include "host_replay.h"
+
+#include <ctype.h>
+
+
+#define REPLAY_MAX_FRAMES  2048																// frames of the device in the log
+#define REPLAY_START       2000																// ms, first frame after the start of the device
+#define REPLAY_MAX_GAP     10000															// ms, a longer pause of the log or a time going back
+#define REPLAY_GAP         2000																// is replaced by this one
+#define REPLAY_SETTLE      2000																// ms after the last frame for the answers
+
+#define FRM_CNT            1																// positions in the decoded frame
+#define FRM_FLAG           2
+#define FRM_TYPE           3
+#define FRM_SND            4
+#define FRM_RCV            7
+#define FRM_BIDI           0x20
+
+namespace REPLAY {
+	enum E : uint8_t { WAITING, PROCESSING, DONE, LOST, };
+}
+namespace REPLAY_CMP {
+	enum E : uint8_t { NO_LOG, SAME, DIFFERS, };
+}
+
+struct s_replay_frame {
+	uint8_t  buf[64];																		// decoded, buf[0] is the length
+	uint32_t log_time;																		// ms of the log
+	uint16_t line;																			// line in the log
+	uint8_t  input;																			// 1 for the device, 0 sent by the device
+
+	uint32_t due;																			// ms of the virtual clock for the injection
+	uint64_t at_us;																			// time of the injection
+	uint8_t  state;																			// REPLAY::E
+	uint32_t loops;																			// loop() passes till the frame was handled
+	uint64_t cpu_ns;																		// and the host cpu time of them
+	int16_t  expect;																		// answer of the log, index in frame[] or -1
+	uint8_t  answered;
+	uint8_t  cmp;																			// REPLAY_CMP::E, answer against the log
+	uint32_t latency_us;
+};
+
+static s_replay_frame frame[REPLAY_MAX_FRAMES];
+static uint16_t frame_cnt, next, processing;
+static uint32_t last_due;
+static const char *log_name;
+static uint8_t dev[3];
+
+static void print_hex(const uint8_t *buf, uint8_t len) {
+	for (uint8_t i = 0; i < len; i++) printf(" %02X", buf[i]);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+
+/*-- reading the log ------------------------------------------------------------------------------------------------------
+* lines without a frame, like the comments of the PAIRING log, are skipped, a frame must have its length byte right
+*/
+static uint8_t parse_line(const char *str, uint8_t *buf, uint32_t *time) {
+	while (isspace((unsigned char)*str)) str++;
+	if (!(((str[0] == '<') && (str[1] == '-')) || ((str[0] == '-') && (str[1] == '>')) || (islower((unsigned char)str[0]) && (str[1] == '>')))) return 0;
+
+	const char *end = strchr(str, '(');
+	if (!end) return 0;
+	*time = strtoul(end + 1, 0, 10);
+
+	uint8_t len = 0, nibble = 0, val = 0;
+	for (str += 2; (str < end) && (len < 64); str++) {
+		if (isspace((unsigned char)*str)) continue;
+		if (!isxdigit((unsigned char)*str)) return 0;
+		val = (val << 4) | (isdigit((unsigned char)*str) ? *str - '0' : (toupper((unsigned char)*str) - 'A' + 10));
+		if (++nibble == 2) {
+			buf[len++] = val;
+			nibble = val = 0;
+		}
+	}
+	return ((len > FRM_RCV + 2) && (buf[0] + 1 == len)) ? len : 0;
+}
+
+/* the device is the receiver of most frames which a device has to act on */
+static void find_device(uint8_t *hmid) {
+	uint16_t best = 0;
+	for (uint16_t i = 0; i < frame_cnt; i++) {
+		uint8_t type = frame[i].buf[FRM_TYPE];
+		if ((type != 0x01) && (type != 0x11) && (type != 0x40) && (type != 0x41)) continue;
+		uint16_t cnt = 0;
+		for (uint16_t j = 0; j < frame_cnt; j++) cnt += !memcmp(frame[i].buf + FRM_RCV, frame[j].buf + FRM_RCV, 3);
+		if (cnt > best) {
+			best = cnt;
+			memcpy(hmid, frame[i].buf + FRM_RCV, 3);
+		}
+	}
+}
+
+uint8_t replay_open(const char *file_name, uint8_t *hmid) {
+	FILE *f = fopen(file_name, "r");
+	if (!f) return 0;
+	log_name = file_name;
+
+	char line[512];
+	uint16_t line_nr = 0;
+	while ((fgets(line, sizeof(line), f)) && (frame_cnt < REPLAY_MAX_FRAMES)) {
+		line_nr++;
+		s_replay_frame *fr = &frame[frame_cnt];
+		if (!parse_line(line, fr->buf, &fr->log_time)) continue;
+		fr->line = line_nr;
+		frame_cnt++;
+	}
+	fclose(f);
+
+	static const uint8_t empty[3] = { 0, 0, 0, };
+	if (!memcmp(hmid, empty, 3)) find_device(hmid);
+	memcpy(dev, hmid, 3);
+
+	/* only the frames of the device are kept, the time distances of the log become the schedule */
+	uint16_t cnt = 0, prev = 0xffff;
+	for (uint16_t i = 0; i < frame_cnt; i++) {
+		s_replay_frame *fr = &frame[i];
+		uint8_t from_dev = !memcmp(fr->buf + FRM_SND, dev, 3);
+		uint8_t for_dev = !memcmp(fr->buf + FRM_RCV, dev, 3) && !from_dev;
+		if ((!from_dev) && (!for_dev)) continue;
+
+		if (cnt != i) frame[cnt] = *fr;
+		fr = &frame[cnt];
+		fr->input = for_dev;
+		fr->expect = -1;
+		if (for_dev) {
+			uint32_t gap = (prev == 0xffff) ? 0 : fr->log_time - frame[prev].log_time;
+			if ((prev != 0xffff) && ((fr->log_time < frame[prev].log_time) || (gap > REPLAY_MAX_GAP))) gap = REPLAY_GAP;
+			fr->due = (prev == 0xffff) ? REPLAY_START : frame[prev].due + gap;
+			last_due = fr->due;
+			prev = cnt;
+		}
+		cnt++;
+	}
+	frame_cnt = cnt;
+
+	/* the answer of the log is the next frame of the device to the sender with the same counter */
+	for (uint16_t i = 0; i < frame_cnt; i++) {
+		if ((!frame[i].input) || (!(frame[i].buf[FRM_FLAG] & FRM_BIDI))) continue;
+		for (uint16_t j = i + 1; j < frame_cnt; j++) {
+			if ((frame[j].input) || (frame[j].buf[FRM_CNT] != frame[i].buf[FRM_CNT])) continue;
+			if (memcmp(frame[j].buf + FRM_RCV, frame[i].buf + FRM_SND, 3)) continue;
+			frame[i].expect = j;
+			break;
+		}
+	}
+
+	next = 0;
+	processing = 0xffff;
+	return 1;
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- during the run -------------------------------------------------------------------------------------------------------
+*/
+uint32_t replay_poll(void) {
+	for (; next < frame_cnt; next++) {
+		s_replay_frame *fr = &frame[next];
+		if (!fr->input) continue;
+		if (fr->due > get_millis()) return fr->due;
+
+		printf("@%u rx", get_millis()); print_hex(fr->buf, fr->buf[0] + 1); printf(" (line %u)\n", fr->line);
+		fr->at_us = host_get_us();
+		if (host_cc1101.receive(fr->buf, 0x20)) {
+			fr->state = REPLAY::PROCESSING;
+			processing = next;
+		} else {
+			fr->state = REPLAY::LOST;
+			printf("@%u lost\n", get_millis());
+		}
+	}
+	return (get_millis() < last_due + REPLAY_SETTLE) ? last_due + REPLAY_SETTLE : REPLAY_DONE;
+}
+
+void replay_loop_done(uint64_t cpu_ns) {
+	if (processing == 0xffff) return;
+	s_replay_frame *fr = &frame[processing];
+	fr->loops++;
+	fr->cpu_ns += cpu_ns;
+	if (host_cc1101.rx_pos < host_cc1101.rx_len) return;									// not read out of the CC1101 yet
+	fr->state = REPLAY::DONE;
+	processing = 0xffff;
+}
+
+void replay_tx(uint8_t *buf) {
+	for (uint16_t i = next; i-- > 0; ) {													// the latest injected frame first
+		s_replay_frame *fr = &frame[i];
+		if ((!fr->input) || (fr->answered) || (fr->state == REPLAY::LOST) || (!(fr->buf[FRM_FLAG] & FRM_BIDI))) continue;
+		if ((fr->buf[FRM_CNT] != buf[FRM_CNT]) || (memcmp(fr->buf + FRM_SND, buf + FRM_RCV, 3))) continue;
+
+		fr->answered = 1;
+		fr->latency_us = host_cc1101.tx_start - fr->at_us;
+		if (fr->expect >= 0) fr->cmp = (memcmp(frame[fr->expect].buf, buf, buf[0] + 1)) ? REPLAY_CMP::DIFFERS : REPLAY_CMP::SAME;
+		static const char *cmp_name[] = { "-", "same", "differs", };
+		printf("@%u answer to line %u after %u.%03u ms, log: %s\n", get_millis(), fr->line, fr->latency_us / 1000,
+			fr->latency_us % 1000, cmp_name[fr->cmp]);
+		return;
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
+
+
+/*-- summary --------------------------------------------------------------------------------------------------------------
+*/
+void replay_report(void) {
+	static uint64_t lat[REPLAY_MAX_FRAMES], cpu[REPLAY_MAX_FRAMES];
+	uint16_t inputs = 0, outputs = 0, lost = 0, bidi = 0, answered = 0, same = 0, differs = 0, no_log = 0, lat_cnt = 0, cpu_cnt = 0;
+	uint32_t loops_min = 0xffffffff, loops_max = 0;
+	uint64_t loops_sum = 0;
+
+	for (uint16_t i = 0; i < frame_cnt; i++) {
+		s_replay_frame *fr = &frame[i];
+		if (!fr->input) { outputs++; continue; }
+		inputs++;
+		if (fr->state == REPLAY::LOST) { lost++; continue; }
+		if (fr->state == REPLAY::DONE) {
+			cpu[cpu_cnt++] = fr->cpu_ns;
+			loops_sum += fr->loops;
+			if (fr->loops < loops_min) loops_min = fr->loops;
+			if (fr->loops > loops_max) loops_max = fr->loops;
+		}
+		if (!(fr->buf[FRM_FLAG] & FRM_BIDI)) continue;
+		bidi++;
+		if (!fr->answered) {
+			printf("no answer to line %u:", fr->line); print_hex(fr->buf, fr->buf[0] + 1); printf("\n");
+			continue;
+		}
+		answered++;
+		lat[lat_cnt++] = fr->latency_us;
+		if (fr->cmp == REPLAY_CMP::SAME) same++;
+		else if (fr->cmp == REPLAY_CMP::DIFFERS) differs++;
+		else no_log++;
+	}
+
+	printf("\nreplay of %s, device %02X%02X%02X\n", log_name, dev[0], dev[1], dev[2]);
+	printf("  frames for the device %u, sent by the device in the log %u, lost %u\n", inputs, outputs, lost);
+	printf("  with BIDI flag %u, answered %u, without answer %u\n", bidi, answered, bidi - answered);
+	printf("  answers same as in the log %u, different %u, not in the log %u\n", same, differs, no_log);
+	qsort(lat, lat_cnt, sizeof(lat[0]), cmp_u64);
+	if (lat_cnt) printf("  latency of the answers ms  min %.3f  p50 %.3f  p90 %.3f  max %.3f\n", lat[0] / 1000.0,
+		lat[lat_cnt / 2] / 1000.0, lat[lat_cnt * 9 / 10] / 1000.0, lat[lat_cnt - 1] / 1000.0);
+	qsort(cpu, cpu_cnt, sizeof(cpu[0]), cmp_u64);
+	if (cpu_cnt) {
+		printf("  loop() passes per frame  min %u  avg %.1f  max %u\n", loops_min, (double)loops_sum / cpu_cnt, loops_max);
+		printf("  host cpu per frame us    min %.1f  p50 %.1f  max %.1f   (changes from run to run)\n", cpu[0] / 1000.0,
+			cpu[cpu_cnt / 2] / 1000.0, cpu[cpu_cnt - 1] / 1000.0);
+	}
+}
+//- -----------------------------------------------------------------------------------------------------------------------
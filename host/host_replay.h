@@ -0,0 +1,22 @@
+/*
+*  AskSin driver implementation
+*  2013-08-03 <trilu@gmx.de> Creative Commons - http://creativecommons.org/licenses/by-nc-sa/3.0/de/
+* - -----------------------------------------------------------------------------------------------------------------------
+* - AskSin host replay of captured traffic --------------------------------------------------------------------------------
+* - -----------------------------------------------------------------------------------------------------------------------
+*/
+
+#ifndef _HOST_REPLAY_H
+#define _HOST_REPLAY_H
+
+#include <stdint.h>
+
+#define REPLAY_DONE        0xffffffff														// replay_poll(), nothing more to do
+
+uint8_t  replay_open(const char *file_name, uint8_t *hmid);									// reads the log, an empty hmid is taken from the log
+uint32_t replay_poll(void);																	// injects the frames which are due, returns the time of the next one
+void     replay_loop_done(uint64_t cpu_ns);													// after every loop(), host cpu time of the pass
+void     replay_tx(uint8_t *buf);															// every frame which is sent by the device
+void     replay_report(void);																// summary at the end of the run
+
+#endif
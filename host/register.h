@@ -0,0 +1,164 @@
+#ifndef _REGISTER_H
+#define _REGISTER_H
+
+/*
+*  @brief device for the host build, same channel modules and HMID as the HM_LC_Dim1PWM_CV example,
+*  the pins are the atmega328 ones, on the host they are virtual pins of HAL_host.cpp
+*/
+#include <newasksin.h>
+#include "hmkey.h"
+
+
+/*
+*  @brief definition of all classes which are necassary to run asksin
+*/
+HAS_AES as_aes;
+AES *aes = &as_aes;
+
+CC1101 as_cc1101(pinB4, pinB3, pinB5, pinB2, pinD2);					// miso, mosi, sck, csl, gdo0 - handed over to the register model in setup()
+COM *com = &as_cc1101;
+
+const uint16_t as_eeprom_size = int_eeprom_size;						// capacity of the backend below
+INT_EEP as_eeprom;														// internal eeprom, file backed if asksin_host is started with -e
+//FILE_EEP as_eeprom("eeprom.bin", as_eeprom_size);					// or a storage backend which works directly on a file
+EEP *eep = &as_eeprom;
+
+NO_BAT as_bat;
+BAT *bat = &as_bat;
+
+CBN cbn(1, pinB0);														// config button, 'pin B0 0' in the script presses it
+
+LED led(pinD6, pinD4);
+
+POM pom(POWER_MODE_NO_SLEEP);
+
+
+/*
+*  @brief cm_maintenance requires this declaration in the user sketch to make registers flexible
+*/
+constexpr uint8_t cm_maintenance_ChnlReg[] PROGMEM = { 0x02,0x08,0x0a,0x0b,0x0c,0x15,0x18,0x1E,0x71, };
+constexpr uint8_t cm_maintenance_ChnlDef[] PROGMEM = { 0x80,0x00,0x00,0x00,0x00,0xFF,0x00,0x01,0x84, };
+uint8_t cm_maintenance_ChnlVal[sizeof(cm_maintenance_ChnlReg)];
+const uint8_t cm_maintenance_ChnlLen = sizeof(cm_maintenance_ChnlReg);
+
+
+/*
+*  @brief description of the channel modules, one line per channel module in the same order as cmm[], taken from
+*  the type of the channel module, peer_max is the limit of peers per channel
+*/
+constexpr s_cm_def cm_def[] PROGMEM = {
+	CM_MAINTENANCE::cm_def_c(0),
+	CM_DIMMER::cm_def_c(5),
+	CM_DIMMER::cm_def_c(2),
+	CM_DIMMER::cm_def_c(1),
+};
+
+
+/*
+*  @brief definition of the device functionallity per channel, peer_max is taken from cm_def[] above
+*/
+CM_MAINTENANCE cm_maintenance(CM_PEER_MAX(CM_MAINTENANCE, 0));
+CM_DIMMER cm_dimmer1(CM_PEER_MAX(CM_DIMMER, 1), 0, 0);
+CM_DIMMER cm_dimmer2(CM_PEER_MAX(CM_DIMMER, 2), 1, 0);
+CM_DIMMER cm_dimmer3(CM_PEER_MAX(CM_DIMMER, 3), 2, 0);
+
+CM_MASTER *cmm[4] = {
+	&cm_maintenance,
+	&cm_dimmer1,
+	&cm_dimmer2,
+	&cm_dimmer3,
+};
+static_assert(CM_DEF_CNT(cm_def) == sizeof(cmm) / sizeof(cmm[0]), "cm_def[] needs one line per channel module of cmm[]");
+
+/*
+*  @brief compile time composition of the channel modules, used if CM_STATIC is defined in cm_master.h or as build flag, same order as cmm[]
+*/
+#ifdef CM_STATIC
+typedef CM_DEVICE<CM_CNL(cm_maintenance), CM_CNL(cm_dimmer1), CM_CNL(cm_dimmer2), CM_CNL(cm_dimmer3)> cm_device;
+CM_STATIC_DISPATCH(cm_device);
+#endif
+
+
+/*
+*  @brief amount of different peer devices, the HMID of a peer device is stored only once for all channels
+*  peers and their list3/4 of all channels are sharing the peer pool, peer_max in cm_def[] is the limit per channel
+*/
+const uint8_t peer_dev_max = 8;
+const uint16_t peer_pool_size = 10 * CM_POOL_REC(cm_dimmer_PeerReg);
+
+
+/*
+*  @brief eeprom layout and magic crc of the channel modules, calculated by the compiler from cm_def[], the ring stores
+*  of the library are placed behind them
+*/
+const uint8_t cm_def_cnt = CM_DEF_CNT(cm_def);
+const uint16_t cm_layout_crc = cm_layout_crc_c(cm_def, CM_DEF_CNT(cm_def));
+static_assert(sizeof(s_dev_ident) + cm_layout_size_c(cm_def, CM_DEF_CNT(cm_def), peer_dev_max, peer_pool_size) + as_ring_size <= as_eeprom_size, "channel modules and ring stores do not fit into the eeprom");
+
+/*
+*  @brief staged values of a config session, sized by the biggest lstC/lstP of the channel modules
+*/
+const uint8_t config_stage_len = cm_journal_max_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t config_stage[CONFIG_STAGE_SIZE(config_stage_len)];
+
+/*
+*  @brief verified bit per record of the peer pool, the pool holds not more records than peers of all channels
+*/
+const uint8_t ee_check_rec_cnt = cm_peer_cnt_c(cm_def, CM_DEF_CNT(cm_def));
+uint8_t ee_check_rec[(ee_check_rec_cnt + 7) / 8];
+
+/*
+*  @brief pending work bit per channel module for the scheduler
+*/
+uint8_t sched_cnl[(CM_DEF_CNT(cm_def) + 7) / 8];
+
+
+
+/*
+* @brief HMID, Serial number, HM-Default-Key, Key-Index
+*/
+const uint8_t HMSerialData[] PROGMEM = {
+	/* HMID */            0x33,0x12,0x35,
+	/* Serial number */   'H','B','d','i','m','m','e','r','3','5',		// HBdimmer35
+	/* Key-Index */       HM_DEVICE_AES_KEY_INDEX,
+	/* Default-Key */     HM_DEVICE_AES_KEY,
+};
+
+
+/*
+* @brief Settings of HM device, see the HM_LC_Dim1PWM_CV example
+*/
+const uint8_t dev_static[] PROGMEM = {
+	/* firmwareVersion 1 byte */  0x29,
+	/* modelID         2 byte */  0x00,0x67,
+	/* subTypeID       1 byte */  0x00,
+	/* deviceInfo      3 byte */  0x41,0x01,0x00,
+};
+
+
+/*
+* @brief Regular start function
+*/
+void everyTimeStart(void) {
+	DBG(SER, F("HMID: "), _HEX(dev_ident.HMID, 3), F(", MAID: "), _HEX(dev_operate.MAID, 3), F(", CNL: "), cnl_max, F("\n\n"));
+}
+
+
+/*
+* @brief First time start function
+*/
+void firstTimeStart(void) {
+	DBG(SER, F("\n\nnew magic!\n\n"));
+
+	/* a node of asksin_net gets its own HMID, the serial number is made of it */
+	if ((!host_hmid[0]) && (!host_hmid[1]) && (!host_hmid[2])) return;
+	memcpy(dev_ident.HMID, host_hmid, 3);
+	char serial[11];
+	snprintf(serial, sizeof(serial), "HB%02X%02X%02X00", host_hmid[0], host_hmid[1], host_hmid[2]);
+	memcpy(dev_ident.SERIAL_NR, serial, sizeof(dev_ident.SERIAL_NR));
+	set_eeprom(0, sizeof(dev_ident), ((uint8_t*)&dev_ident));
+	ee_check.update(EE_BLOCK_IDENT);
+}
+
+
+#endif
@@ -18,6 +18,7 @@ s_dev_operate dev_operate;																	// struct to hold all operational var
 
 s_pair_mode   pair_mode;																	// helper structure for keeping track of active pairing mode
 s_config_mode config_mode;																	// helper structure for keeping track of active config mode
+s_scheduler   sched;																		// wake reasons and deadline of the main loop
 
 s_rcv_msg rcv_msg;																			// struct to process received strings
 s_snd_msg snd_msg;																			// same for send strings
@@ -12,7 +12,7 @@
 #ifndef _NEWASKSIN_H
 #define _NEWASKSIN_H
 
-#include "as_type_defs.h"
+#include "AS_type_defs.h"
 
 #include "as_main.h"
 #include "as_helpers.h"
@@ -22,6 +22,8 @@
 #include "as_status_led.h"
 #include "as_battery.h"
 #include "as_power.h"			// needs to be reworked
+#include "as_ee_ring.h"
+#include "as_storage.h"
 
 #include "cm_master.h"
 #include "cm_maintenance.h" 
@@ -29,7 +31,7 @@
 #include "cm_switch.h"
 #include "cm_dimmer.h"
 
-#include "version.h"
+#include "Version.h"
 #include "waittimer.h"
 
 
@@ -98,11 +100,12 @@ extern const uint8_t HMSerialData[] PROGMEM;
 extern const uint8_t dev_static[] PROGMEM;
 
 //template<typename T, typename U, typename... Args> inline T* create(Args... args) { static U ret(args...); return &ret; };
-#define create<x, y, z>(...)    z my_#z(#__VA_ARGS); x y = &my_#z;  
+//#define create<x, y, z>(...)    z my_#z(#__VA_ARGS); x y = &my_#z;  
 
 extern AS hm;
 extern AES *aes;
 extern COM *com;
+extern EEP *eep;
 extern BAT *bat;
 
 extern CBN cbn;
@@ -120,10 +123,10 @@ extern s_list_msg list_msg;
 
 extern CM_MASTER *cmm[];
 
-extern const uint8_t cm_maintenance_ChnlLen;
-extern const uint8_t cm_maintenance_ChnlReg[];
-extern const uint8_t cm_maintenance_ChnlDef[];
-extern uint8_t cm_maintenance_ChnlVal[];
+extern const uint8_t peer_dev_max;															// size of the shared peer device table, defined in the user sketch
+extern const uint16_t peer_pool_size;														// size of the peer pool in byte, defined in the user sketch
+
+extern const uint16_t cm_layout_crc;														// magic crc of the channel modules, calculated in the user sketch
 
 static uint8_t dummy_byte;
 
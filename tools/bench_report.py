@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+AskSin driver implementation
+- report of the benchmarks in bench/, see bench/bench.cpp and bench/Makefile
+
+Every build directory, one per mcu and config, holds the console output of the simavr run (run.txt), the symbol sizes
+of avr-nm -S -C (nm.txt) and the section sizes of avr-size -A (size.txt). The table shows per mcu and routine the cycles,
+the time at F_CPU and the flash of the functions which belong to the routine, helpers which are shared count for every
+routine using them. The functions of both aes backends are listed, a build has only the ones of its backend.
+Against a baseline every value which grew more than the tolerance is a regression and the exit code is 1.
+
+Baseline, one value per line: <mcu> <routine> <cycles> <flash>, and <mcu> image <flash> <ram> for the whole firmware
+
+usage: bench_report.py [--tolerance %] [--baseline file | --write file] build/<mcu>-<config> ...
+"""
+
+import os
+import re
+import sys
+
+# functions of a routine, names as avr-nm -C prints them without the parameter list
+SYMBOLS = {
+	'hm_encode':       ['hm_encode'],
+	'hm_decode':       ['hm_decode'],
+	'aes128_init':     ['aes128_init', 'aes_init', 'aes_rotword'],
+	'aes128_enc':      ['aes128_enc', 'aes_encrypt_core', 'aes_enc_round', 'aes_enc_lastround', 'aes_shiftcol', 'gf256mul',
+	                    'aes_addkey', 'aes_subshift', 'aes_mixcol'],
+	'aes128_dec':      ['aes128_dec', 'aes_decrypt_core', 'aes_dec_round', 'aes_dec_firstround', 'aes_invshiftrow',
+	                    'aes_invshiftcol', 'gf256mul', 'aes_addkey', 'aes_invsubshift', 'aes_invmixcol', 'aes_mixcol'],
+	'crc16':           ['crc16'],
+	'ptr_to_val':      ['ts_list_table::ptr_to_val'],
+	'peer_get_idx':    ['ts_peer_table::get_idx'],
+	'get_intend':      ['AS::bench_get_intend'],
+	'process_message': ['AS::bench_process_message'],
+}
+
+
+def read_run(path):
+	""" returns mcu, f_cpu and a list of (routine, avg, min, max, calls) of the console output """
+	mcu, f_cpu, rows, done = None, 0, [], False
+	with open(path, errors='replace') as f:
+		for line in f:
+			m = re.search(r'\bbench_start (\S+) (\d+) (\d+)', line)					# simavr may put its own prefix in front
+			if m:
+				mcu, f_cpu = m.group(1), int(m.group(2))
+				continue
+			m = re.search(r'\bbench (\S+) (\d+) (\d+) (\d+) (\d+)', line)
+			if m:
+				rows.append((m.group(1),) + tuple(int(v) for v in m.group(2, 3, 4, 5)))
+				continue
+			if re.search(r'\bbench_end\b', line):
+				done = True
+	if not mcu or not done:
+		sys.exit('%s: run not complete, see the simavr output' % path)
+	return mcu, f_cpu, rows
+
+
+def read_nm(path):
+	""" returns a dict function name -> size, a name which is there more than once is summed up """
+	sizes = {}
+	with open(path) as f:
+		for line in f:
+			m = re.match(r'[0-9a-fA-F]+ ([0-9a-fA-F]+) [tTwW] (.+)$', line.rstrip())
+			if not m:
+				continue
+			name = m.group(2).split('(')[0]
+			sizes[name] = sizes.get(name, 0) + int(m.group(1), 16)
+	return sizes
+
+
+def read_size(path):
+	""" returns flash and ram of the image """
+	sect = {}
+	with open(path) as f:
+		for line in f:
+			m = re.match(r'(\.\w+)\s+(\d+)\s+\d+', line)
+			if m:
+				sect[m.group(1)] = int(m.group(2))
+	data = sect.get('.data', 0)
+	return sect.get('.text', 0) + data, data + sect.get('.bss', 0) + sect.get('.noinit', 0)
+
+
+def flash_of(routine, sizes):
+	names = SYMBOLS.get(routine, [routine])
+	found = [sizes[n] for n in names if n in sizes]
+	return sum(found) if found else None											# inlined into the caller
+
+
+def read_baseline(path):
+	base = {}
+	with open(path) as f:
+		for line in f:
+			v = line.split()
+			if len(v) == 4 and not line.startswith('#'):
+				base[(v[0], v[1])] = (int(v[2]), None if v[3] == '-' else int(v[3]))
+	return base
+
+
+def compare(new, old, tolerance):
+	""" returns the change in percent as text and 1 if it is a regression """
+	if new is None or old is None or old == 0:
+		return '', 0
+	diff = (new - old) * 100.0 / old
+	return '%+.1f%%' % diff, 1 if diff > tolerance else 0
+
+
+def main(argv):
+	tolerance, baseline, write, dirs = 2.0, None, None, []
+	i = 0
+	while i < len(argv):
+		if argv[i] in ('--tolerance', '--baseline', '--write') and i + 1 < len(argv):
+			if argv[i] == '--tolerance':
+				tolerance = float(argv[i + 1])
+			elif argv[i] == '--baseline':
+				baseline = argv[i + 1]
+			else:
+				write = argv[i + 1]
+			i += 2
+			continue
+		dirs.append(argv[i])
+		i += 1
+	if not dirs:
+		sys.exit(__doc__.strip().splitlines()[-1])
+
+	base = {}
+	if baseline and os.path.exists(baseline):
+		base = read_baseline(baseline)
+	elif baseline:
+		print('no %s, nothing to compare, make baseline stores one' % baseline)
+
+	values, regressions = [], 0
+	print('%-20s %-16s %8s %8s %8s %9s %6s %8s %8s' % ('mcu', 'routine', 'cycles', 'min', 'max', 'us', 'flash', 'cycles', 'flash'))
+	for d in dirs:
+		mcu, f_cpu, rows = read_run(os.path.join(d, 'run.txt'))
+		sizes = read_nm(os.path.join(d, 'nm.txt'))
+		for routine, avg, cmin, cmax, calls in rows:
+			flash = flash_of(routine, sizes)
+			old = base.get((mcu, routine), (None, None))
+			c_txt, c_reg = compare(avg, old[0], tolerance)
+			f_txt, f_reg = compare(flash, old[1], tolerance)
+			regressions += c_reg + f_reg
+			print('%-20s %-16s %8d %8d %8d %9.1f %6s %8s %8s%s' % (mcu, routine, avg, cmin, cmax, avg * 1e6 / f_cpu,
+				'-' if flash is None else flash, c_txt, f_txt, '  <- regression' if c_reg or f_reg else ''))
+			values.append((mcu, routine, avg, '-' if flash is None else flash))
+
+		flash, ram = read_size(os.path.join(d, 'size.txt'))
+		old = base.get((mcu, 'image'), (None, None))
+		f_txt, f_reg = compare(flash, old[0], tolerance)
+		r_txt, r_reg = compare(ram, old[1], tolerance)
+		regressions += f_reg + r_reg
+		print('%-20s image flash %d byte %s, ram %d byte %s%s\n' % (mcu, flash, f_txt, ram, r_txt,
+			'  <- regression' if f_reg or r_reg else ''))
+		values.append((mcu, 'image', flash, ram))
+
+	if write:
+		with open(write, 'w') as f:
+			f.write('# bench baseline, <mcu> <routine> <cycles> <flash> and <mcu> image <flash> <ram>\n')
+			for v in values:
+				f.write('%s %s %s %s\n' % v)
+		print('baseline written to %s' % write)
+		return 0
+
+	if regressions:
+		print('%d values above the tolerance of %.1f%%' % (regressions, tolerance))
+		return 1
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
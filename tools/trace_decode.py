@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+AskSin driver implementation
+- decoder for the binary trace of TRC_DBG, see TRC() in 00_debug-flag.h and s_trc in AS_type_defs.h
+
+The serial output of the device is read from a file or stdin, plain debug text is passed through and every
+trace record is printed in the same format as the DBG() output would have it.
+Record: 0xa5, id, arg, len, loop millis (4 byte, little endian), len bytes of data
+
+usage: trace_decode.py [capture file] [--enum path/to/AS_enum_defs.h]
+       cat /dev/ttyUSB0 | trace_decode.py
+"""
+
+import os
+import re
+import sys
+
+TRC_SYNC = 0xa5
+TRC_HEAD = 8
+
+
+def hex_str(data):
+	return ' '.join('%02X' % b for b in data)
+
+
+# format per trace id, the ids itself are read from TRC_ID in AS_enum_defs.h
+FORMAT = {
+	'LOST':        lambda arg, time, data: '  %d trace records lost' % arg,
+	'RCV_MSG':     lambda arg, time, data: '%c> %s (%d)' % (arg, hex_str(data), time),
+	'RCV_REPEAT':  lambda arg, time, data: '  repeated...',
+	'RCV_UNKNOWN': lambda arg, time, data: '  message not known - please report',
+	'SND_INTERN':  lambda arg, time, data: '<i ...',
+	'SND_MSG':     lambda arg, time, data: '<- %s (%d)' % (hex_str(data), time),
+	'SND_TIMEOUT': lambda arg, time, data: '  timed out (%d)' % time,
+}
+
+
+def read_ids(path):
+	""" returns a dict id -> name of the TRC_ID enum """
+	with open(path, encoding='latin-1') as f:
+		text = f.read()
+	m = re.search(r'namespace\s+TRC_ID\s*\{\s*enum\s+E\s*:\s*uint8_t\s*\{([^}]*)\}', text)
+	if not m:
+		sys.exit('TRC_ID not found in %s' % path)
+	ids = {}
+	for name, value in re.findall(r'(\w+)\s*=\s*(0x[0-9a-fA-F]+|\d+)', m.group(1)):
+		ids[int(value, 0)] = name
+	return ids
+
+
+def decode(stream, ids, out):
+	buf = b''
+	read = getattr(stream, 'read1', stream.read)											# returns what is there, needed for a live serial port
+	while True:
+		chunk = read(4096)
+		if chunk:
+			buf += chunk
+
+		while buf:
+			pos = buf.find(bytes([TRC_SYNC]))
+			if pos < 0:																	# plain text only
+				out.write(buf.decode('latin-1'))
+				buf = b''
+				break
+			if pos:																		# text in front of the record
+				out.write(buf[:pos].decode('latin-1'))
+				buf = buf[pos:]
+			if len(buf) < TRC_HEAD or len(buf) < TRC_HEAD + buf[3]:						# record not complete yet
+				break
+
+			tid, arg, length = buf[1], buf[2], buf[3]
+			time = int.from_bytes(buf[4:8], 'little')
+			data = buf[TRC_HEAD:TRC_HEAD + length]
+			buf = buf[TRC_HEAD + length:]
+
+			name = ids.get(tid)
+			if name in FORMAT:
+				out.write(FORMAT[name](arg, time, data) + '\n')
+			else:
+				out.write('?? trace id 0x%02x, arg 0x%02x, time %d, data %s\n' % (tid, arg, time, hex_str(data)))
+
+		if not chunk:
+			if buf:
+				out.write(buf.decode('latin-1'))
+			return
+
+
+def main(argv):
+	enum_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'AS_enum_defs.h')
+	files = []
+	i = 0
+	while i < len(argv):
+		if argv[i] == '--enum':
+			enum_path = argv[i + 1]
+			i += 2
+			continue
+		files.append(argv[i])
+		i += 1
+
+	ids = read_ids(enum_path)
+	if files:
+		for name in files:
+			with open(name, 'rb') as f:
+				decode(f, ids, sys.stdout)
+	else:
+		decode(sys.stdin.buffer, ids, sys.stdout)
+
+
+if __name__ == '__main__':
+	main(sys.argv[1:])
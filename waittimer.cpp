@@ -9,13 +9,52 @@
 #include "waittimer.h"
 #include "HAL.h"
 
-static uint8_t timer_max;
+waittimer *timer_array[WAITTIMER_MAX];														// registry of all waittimer instances
+uint8_t timer_max;																			// amount of registered timers
+
+/* earliest deadline of all armed timers, the scheduler knows it without asking every timer. 
+*  the deadline is only moved to an earlier time by set(), a timer which is done() or set to a later time leaves an
+*  outdated deadline behind, which is corrected by a search through the registry when the deadline is reached */
+#define NEXT_UNKNOWN  0																		// deadline needs a search through the registry
+#define NEXT_KNOWN    1																		// next_time is the earliest deadline
+#define NEXT_NONE     2																		// no timer armed
+static uint8_t  next_state;
+static uint32_t next_time;
+
+#ifdef WAITTIMER_WHEEL
+/* timer wheel, bucket b of level l holds the timers with a deadline in the (b)th slot of (1 << 4l) ms. 
+*  level 0 buckets are expired tick by tick, the bucket of the next higher level is cascaded down whenever
+*  a level wraps. timers beyond level 3 wait in the overflow bucket, which is sorted again on every wrap of level 3 */
+#define WHEEL_BITS      4
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_LEVELS    4
+#define WHEEL_OVERFLOW  (WHEEL_LEVELS * WHEEL_SLOTS)										// index of the overflow bucket
+#define WHEEL_NONE      0xff																// end of a bucket list
+#define WHEEL_UNLINKED  0x7f																// timer is not in a bucket
+
+static uint8_t  wheel_head[WHEEL_OVERFLOW + 1];												// first timer of each bucket
+static uint16_t wheel_used;																	// level 0 buckets with timers, bit per bucket
+static uint32_t wheel_time;																	// all timers with a deadline up to here are flagged
+static uint8_t  wheel_init;
+#endif
 
 
 /**
 * @brief Constructor to initialize waittimer
 */
 waittimer::waittimer() {
+#ifdef WAITTIMER_WHEEL
+	idx = WHEEL_NONE;
+	bucket = WHEEL_UNLINKED;
+	if (!wheel_init) {																		// first timer, prepare the empty wheel
+		for (uint8_t i = 0; i <= WHEEL_OVERFLOW; i++) wheel_head[i] = WHEEL_NONE;
+		wheel_init = 1;
+	}
+#endif
+	if (timer_max >= WAITTIMER_MAX) return;													// registry full, timer works but is not known by the scheduler
+#ifdef WAITTIMER_WHEEL
+	idx = timer_max;
+#endif
 	timer_array[timer_max] = this;
 	timer_max += 1;
 }
@@ -28,7 +67,14 @@ waittimer::waittimer() {
 */
 uint8_t  waittimer::done(void) {
 	if (!checkTime) return 1;																// not armed, so nothing to do
-	if ((get_millis() - startTime) < checkTime) return 0;									// not ready yet
+#ifdef WAITTIMER_WHEEL
+	if (idx != WHEEL_NONE) {																// registered, the wheel flags it
+		if (!expired) return 0;
+		checkTime = 0;
+		return 1;
+	}
+#endif
+	if ((get_loop_millis() - startTime) < checkTime) return 0;								// not ready yet
 	checkTime = 0;																			// if we are here, timeout was happened
 	return 1;																				// return a 1 for done
 }
@@ -36,13 +82,27 @@ uint8_t  waittimer::done(void) {
 /**
 * @brief Start the timer
 *
-* @param ms Time until timer is done() (unit: ms)
+* @param ms Time until timer is done() (unit: ms), 0 disarms the timer
 */
 void     waittimer::set(uint32_t wait_millis) {
-	uint8_t armed = (wait_millis) ? 1 : 0;
-	if (!armed) return;
-	startTime = get_millis();
 	checkTime = wait_millis;
+#ifdef WAITTIMER_WHEEL
+	unlink();																				// out of the wheel, sorted in again if armed
+	expired = 0;
+#endif
+	if (!wait_millis) return;																// disarmed, done() is 1 and next_due() skips it
+	snap_millis();																			// the loop may have blocked since the snapshot, e.g. a burst send
+	startTime = get_loop_millis();
+#ifdef WAITTIMER_WHEEL
+	if (idx != WHEEL_NONE) link();															// sort it into the wheel
+#endif
+
+	/* inform the scheduler if this timer is due before the known deadline */
+	uint32_t due_time = startTime + wait_millis;
+	if ((next_state == NEXT_NONE) || ((next_state == NEXT_KNOWN) && ((int32_t)(due_time - next_time) < 0))) {
+		next_time = due_time;
+		next_state = NEXT_KNOWN;
+	}
 }
 
 /**
@@ -52,7 +112,7 @@ void     waittimer::set(uint32_t wait_millis) {
 */
 uint32_t waittimer::remain(void) {
 	if (!checkTime) return 0;
-	return (checkTime - (get_millis() - startTime));
+	return (checkTime - (get_loop_millis() - startTime));
 }
 
 /* returns the status of the timer
@@ -61,6 +121,137 @@ uint32_t waittimer::remain(void) {
 * 2 active and remaining time is above 0 */
 uint8_t waittimer::completed(void) {
 	if (!checkTime) return 0;																// not armed, so return not active
-	else if ((get_millis() - startTime) >= checkTime) return 1;								// timer done, but not progressed
+	else if ((get_loop_millis() - startTime) >= checkTime) return 1;						// timer done, but not progressed
 	else return 2;																			// time not ready, need some additional time
-}
\ No newline at end of file
+}
+
+/**
+* @brief Query the time until the next timer in the registry is due
+*
+* As long as the known deadline is in the future, it is answered without touching the registry.
+* When the deadline is reached, all registered timers are checked and the next deadline is stored.
+*
+* @return 0 if a timer is due and needs to be processed by done(), 
+*         time in ms till the next timer is due, or WAITTIMER_NONE if no timer is armed
+*/
+uint32_t waittimer::next_due(void) {
+	uint32_t now = get_loop_millis();
+	if (next_state == NEXT_NONE) return WAITTIMER_NONE;										// nothing armed since the last search
+	if ((next_state == NEXT_KNOWN) && ((int32_t)(next_time - now) > 0)) return next_time - now;// deadline still ahead
+
+	/* deadline reached or unknown, search the registry for the next one */
+	uint32_t next = WAITTIMER_NONE;
+	for (uint8_t i = 0; i < timer_max; i++) {
+		waittimer *t = timer_array[i];
+		if (!t->checkTime) continue;														// not armed
+		uint32_t passed = now - t->startTime;
+		if (passed >= t->checkTime) {														// due, but not progressed via done()
+			next_state = NEXT_UNKNOWN;
+			return 0;
+		}
+		if (t->checkTime - passed < next) next = t->checkTime - passed;						// remember the earliest one
+	}
+
+	next_state = (next == WAITTIMER_NONE) ? NEXT_NONE : NEXT_KNOWN;
+	next_time = now + next;
+	return next;
+}
+
+
+#ifdef WAITTIMER_WHEEL
+/*
+* @brief Sort the timer into the wheel bucket which fits to the distance of its deadline to the wheel time
+*/
+void waittimer::link(void) {
+	uint32_t due_time = startTime + checkTime;
+	uint32_t delta = due_time - wheel_time;
+	expired = 0;
+
+	if ((int32_t)delta <= 0) {																// deadline already passed
+		expired = 1;
+		return;
+	}
+
+	uint8_t b = WHEEL_OVERFLOW;
+	for (uint8_t l = 0; l < WHEEL_LEVELS; l++) {											// search the lowest level which covers the distance
+		if (delta >= (1UL << (WHEEL_BITS * (l + 1)))) continue;
+		b = l * WHEEL_SLOTS + ((due_time >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1));
+		break;
+	}
+
+	next = wheel_head[b];																	// add in front of the bucket list
+	wheel_head[b] = idx;
+	bucket = b;
+	if (b < WHEEL_SLOTS) wheel_used |= (1 << b);
+}
+
+/*
+* @brief Remove the timer from its bucket
+*/
+void waittimer::unlink(void) {
+	if (bucket == WHEEL_UNLINKED) return;
+
+	uint8_t *ptr = &wheel_head[bucket];
+	while ((*ptr != WHEEL_NONE) && (*ptr != idx)) ptr = &timer_array[*ptr]->next;			// search the link which points to us
+	if (*ptr == idx) *ptr = next;
+
+	if ((bucket < WHEEL_SLOTS) && (wheel_head[bucket] == WHEEL_NONE)) wheel_used &= ~(1 << bucket);
+	bucket = WHEEL_UNLINKED;
+}
+
+/*
+* @brief Sort all timers of a bucket again, used to cascade a bucket to the next lower level
+*/
+void waittimer::cascade(uint8_t b) {
+	uint8_t i = wheel_head[b];
+	wheel_head[b] = WHEEL_NONE;
+	while (i != WHEEL_NONE) {
+		waittimer *t = timer_array[i];
+		i = t->next;
+		t->bucket = WHEEL_UNLINKED;
+		t->link();
+	}
+}
+
+/**
+* @brief Advance the timer wheel till now and flag all timers which are due
+*
+* Empty stretches of level 0 are skipped till the next wrap, so a long sleep costs one step per 16ms.
+*/
+void waittimer::tick(void) {
+	uint32_t now = get_loop_millis();
+
+	while (wheel_time != now) {
+		/* nothing in level 0, jump to the last ms before the next wrap */
+		if (!wheel_used) {
+			uint32_t wrap = wheel_time | (WHEEL_SLOTS - 1);
+			if ((int32_t)(now - wrap) <= 0) {												// no wrap till now
+				wheel_time = now;
+				break;
+			}
+			wheel_time = wrap;
+		}
+
+		uint32_t t = ++wheel_time;
+
+		/* cascade the higher levels on a wrap, timers due now are flagged while sorting them again */
+		for (uint8_t l = 1; l <= WHEEL_LEVELS; l++) {
+			if (t & ((1UL << (WHEEL_BITS * l)) - 1)) break;									// no wrap of level l - 1
+			if (l == WHEEL_LEVELS) cascade(WHEEL_OVERFLOW);
+			else cascade(l * WHEEL_SLOTS + ((t >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1)));
+		}
+
+		/* flag all timers of the level 0 bucket */
+		uint8_t b = t & (WHEEL_SLOTS - 1);
+		uint8_t i = wheel_head[b];
+		wheel_head[b] = WHEEL_NONE;
+		wheel_used &= ~(1 << b);
+		while (i != WHEEL_NONE) {
+			waittimer *tm = timer_array[i];
+			i = tm->next;
+			tm->bucket = WHEEL_UNLINKED;
+			tm->expired = 1;
+		}
+	}
+}
+#endif
@@ -11,6 +11,19 @@
 
 #include <stdint.h>
 
+/*
+* @brief Remove the double slash to get the timer wheel backend. Timers are sorted into the buckets of a hierarchical
+*        wheel (4 levels of 16 buckets, 1ms - 16ms - 256ms - 4096ms, longer timers wait in an overflow list), the wheel
+*        is advanced once per loop by tick() and flags the expired timers. done() is then a flag check without reading
+*        the millis timer. tick() is called by AS::poll(), a timer is only flagged done after the next tick.
+*/
+//#define WAITTIMER_WHEEL
+
+#ifndef WAITTIMER_MAX
+#define WAITTIMER_MAX   32																	// size of the timer registry, can be overwritten in the user sketch
+#endif
+#define WAITTIMER_NONE  0xffffffff															// next_due() result while no timer is armed
+
 
 /**
 * @short Timer class for non-blocking delays
@@ -44,6 +57,16 @@ class waittimer {
 private:	//---------------------------------------------------------------------------------------------------------
 	uint32_t startTime;
 	uint32_t checkTime;
+#ifdef WAITTIMER_WHEEL
+	uint8_t  idx;																			// position in the registry, 0xff if not registered
+	uint8_t  next;																			// next timer in the same bucket, 0xff for the end
+	uint8_t  bucket  : 7;																	// bucket the timer is linked in, 0x7f if not linked
+	uint8_t  expired : 1;																	// flagged by the wheel, progressed by done()
+
+	void     link(void);
+	void     unlink(void);
+	static void cascade(uint8_t b);
+#endif
 
 public:		//---------------------------------------------------------------------------------------------------------
 	waittimer();
@@ -51,6 +74,13 @@ public:		//---------------------------------------------------------------------
 	void     set(uint32_t wait_millis);
 	uint32_t remain(void);
 	uint8_t  completed(void);
+
+	static uint32_t next_due(void);															// ms till the earliest armed timer is due, 0 if one is due, WAITTIMER_NONE if none is armed
+#ifdef WAITTIMER_WHEEL
+	static void     tick(void);																// advance the timer wheel till now, once per loop
+#else
+	static void     tick(void) {}
+#endif
 };
 
 